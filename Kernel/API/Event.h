@@ -30,6 +30,8 @@ struct [[gnu::packed]] Event
 {
     EventTypeMask eventsRaised;
     uint64_t pd;
+    // The value given when the pipe was added to the listener.
+    uint64_t cookie;
 };
 
 enum EventTypes : EventType
@@ -38,6 +40,16 @@ enum EventTypes : EventType
     WRITEABLE = 0x2,
 };
 
+/**
+ * Flags that can be combined with the events an EventListener registers for.
+ */
+enum EventFlags : EventType
+{
+    // Report the events on every listen while they are still raised, rather than
+    // once each time they are raised.
+    LEVEL_TRIGGERED = 1ull << 63,
+};
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef XPOS_API_LOCKSTATISTICS_H
+#define XPOS_API_LOCKSTATISTICS_H
+
+#include <cstdint>
+
+/**
+ * The records read from the sys::lockstat device, which exists when the kernel is
+ * built with XPOS_LOCK_STATISTICS. Records are ordered by total wait time, most
+ * contended first, so reading N records gives the top N locks.
+ */
+namespace xpOS::API::LockStatistics
+{
+    static constexpr int NAME_LENGTH = 48;
+
+    /**
+     * Bucket i counts times of [2^i, 2^(i+1)) TSC cycles. The last bucket also
+     * counts anything longer.
+     */
+    static constexpr int HISTOGRAM_BUCKETS = 32;
+
+    struct LockInfo
+    {
+        char name[NAME_LENGTH];
+        uint64_t acquisitions;
+        uint64_t contended;
+        uint64_t waitCycles;
+        uint64_t holdCycles;
+        uint64_t maxWaitCycles;
+        uint64_t maxHoldCycles;
+        uint64_t waitHistogram[HISTOGRAM_BUCKETS];
+        uint64_t holdHistogram[HISTOGRAM_BUCKETS];
+    };
+}
+
+#endif
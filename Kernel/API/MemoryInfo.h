@@ -0,0 +1,62 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef XPOS_API_MEMORYINFO_H
+#define XPOS_API_MEMORYINFO_H
+
+#include <cstdint>
+
+namespace xpOS::API::MemoryInfo
+{
+    struct Flags
+    {
+        /**
+         * Report on a single task rather than the whole system. The pipe is opened
+         * with a pointer to the task ID, or with nullptr for the calling task.
+         */
+        static constexpr int TASK = 1;
+    };
+
+    struct SystemInfo
+    {
+        uint64_t pageSize;
+        uint64_t totalPages;
+        uint64_t freePages;
+        uint64_t pageTablePages;
+
+        uint64_t heapBytesMapped;
+        uint64_t heapBytesInUse;
+        uint64_t heapAllocations;
+        uint64_t heapFrees;
+        uint64_t heapLargeAllocations;
+
+        uint64_t sharedObjects;
+        uint64_t sharedAttachments;
+        uint64_t sharedBytes;
+    };
+
+    struct TaskInfo
+    {
+        uint64_t tid;
+        // Pages mapped in the user half of the task's address space, which threads share.
+        uint64_t residentPages;
+        uint64_t pageTablePages;
+    };
+}
+
+#endif
@@ -19,6 +19,7 @@
 #ifndef XPOS_API_PIPES_H
 #define XPOS_API_PIPES_H
 
+#include <cstddef>
 #include <cstdint>
 
 namespace xpOS::API::Pipes
@@ -35,6 +36,27 @@ struct PipeInfo
 {
     std::size_t size = 0;
 };
+
+/**
+ * One buffer of a scatter-gather read or write.
+ */
+struct IOVector
+{
+    void* base;
+    std::size_t length;
+};
+
+// The most buffers a single preadv or pwritev accepts.
+inline constexpr std::size_t MAX_IO_VECTORS = 16;
+
+struct MapFlags
+{
+    /**
+     * Writes go to a private copy of each page, made on the first write to it.
+     * Without this flag the mapping is read-only.
+     */
+    static constexpr int PRIVATE = 1;
+};
     
 }
 
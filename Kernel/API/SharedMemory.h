@@ -34,6 +34,30 @@ namespace xpOS::API::SharedMemory
         void* mappedTo;
         std::size_t length;
     };
+
+    /**
+     * Written to a shared memory pipe to grow or shrink the object. Every attached
+     * mapping is updated, keeping its address where there is room to.
+     */
+    struct ResizeRequest
+    {
+        std::size_t length;
+    };
+
+    /**
+     * Read from a shared memory pipe to find where the object is currently mapped.
+     */
+    struct MappingInfo
+    {
+        void* mappedTo;
+        std::size_t length;
+    };
+
+    struct EventTypes
+    {
+        // Raised on every attached pipe when the object is resized.
+        static constexpr uint64_t RESIZED = 0x4;
+    };
 }
 
 #endif
\ No newline at end of file
@@ -48,6 +48,10 @@
 #define SYSCALL_FUTEX_WAIT 26
 #define SYSCALL_PINFO 27
 #define SYSCALL_BOOTTICKS_MS 28
+#define SYSCALL_PMMAP 29
+#define SYSCALL_PREADV 30
+#define SYSCALL_PWRITEV 31
+#define SYSCALL_PSPLICE 32
 
 namespace xpOS::API::Syscalls
 {
@@ -40,3 +40,15 @@ void CPU::set_task_state_segment(X86_64::TaskStateSegment* taskStateSegment)
     tssGdtEntry.set_access(GlobalDescriptorTable::AccessFlag::PRESENT | GlobalDescriptorTable::AccessFlag::TSS64);
     m_globalDescriptorTable->set_table_entry(tssGdtEntry, TSS_GDT_ENTRY_NUM);
 }
+
+void CPU::initialise_local_area(uint32_t id)
+{
+    auto& area = m_localAreas[id];
+    area.self = &area;
+    area.id = id;
+
+    // There is no swapgs on kernel entry, so this relies on user tasks leaving GS
+    // alone. Nothing reads GS until MAX_CPUS is raised above one.
+    auto base = reinterpret_cast<uint64_t>(&area);
+    asm volatile("wrmsr" ::"a"(base & 0xFFFFFFFF), "d"(base >> 32), "c"(GS_BASE_MSR));
+}
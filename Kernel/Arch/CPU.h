@@ -19,6 +19,7 @@
 #ifndef CPU_H
 #define CPU_H
 
+#include <cstddef>
 #include <cstdint>
 
 #include "Arch/GDT.h"
@@ -40,6 +41,55 @@ public:
         TWO =    2
     };
 
+    /**
+     * The number of processors the kernel is built for. With a single processor,
+     * per-CPU data is found at compile time rather than through GS.
+     */
+    static constexpr std::size_t MAX_CPUS = 1;
+
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    /**
+     * The block of data owned by a processor. The GS base of each processor points
+     * at its own area, so fields are read with one GS-relative load.
+     */
+    struct alignas(CACHE_LINE_SIZE) LocalArea
+    {
+        LocalArea* self;
+        uint32_t id;
+    };
+
+    /**
+     * Points the executing processor's GS base at the local area for the given id.
+     */
+    static void initialise_local_area(uint32_t id);
+
+    /**
+     * Returns the id of the executing processor. The caller must not be migrated
+     * between processors while it uses the result.
+     */
+    static uint32_t current_id()
+    {
+        if constexpr (MAX_CPUS == 1) {
+            return 0;
+        } else {
+            uint32_t id;
+            asm volatile("movl %%gs:%c1, %0" : "=r"(id) : "i"(offsetof(LocalArea, id)));
+            return id;
+        }
+    }
+
+    static LocalArea& local_area()
+    {
+        if constexpr (MAX_CPUS == 1) {
+            return m_localAreas[0];
+        } else {
+            LocalArea* area;
+            asm volatile("movq %%gs:%c1, %0" : "=r"(area) : "i"(offsetof(LocalArea, self)));
+            return *area;
+        }
+    }
+
     static X86_64::GlobalDescriptorTable& get_global_descriptor_table()
     {
         return *m_gdtDescriptor.offset;
@@ -77,7 +127,9 @@ private:
     inline static X86_64::GlobalDescriptorTable* m_globalDescriptorTable;
     inline static X86_64::GlobalDescriptorTableDescriptor m_gdtDescriptor;
     inline static X86_64::TaskStateSegment* m_taskStateSegment;
+    inline static LocalArea m_localAreas[MAX_CPUS];
     static constexpr int TSS_GDT_ENTRY_NUM = 5;
+    static constexpr uint32_t GS_BASE_MSR = 0xC0000101;
 };
 
 #endif
\ No newline at end of file
@@ -45,6 +45,8 @@ namespace X86_64 {
         static constexpr uint32_t INIT_FREQUENCY = 200;
     }
 
+    constinit ProgrammableIntervalTimer ProgrammableIntervalTimer::m_instance;
+
     void ProgrammableIntervalTimer::initialise()
     {
         reload_count();
@@ -37,8 +37,7 @@ public:
     static void tick();
     static ProgrammableIntervalTimer& instance()
     {
-        static ProgrammableIntervalTimer instance;
-        return instance;
+        return m_instance;
     }
     ProgrammableIntervalTimer(ProgrammableIntervalTimer const&) = delete;
     ProgrammableIntervalTimer& operator=(ProgrammableIntervalTimer const&) = delete;
@@ -48,11 +47,12 @@ public:
     }
     
 private:
-    ProgrammableIntervalTimer() {}
+    constexpr ProgrammableIntervalTimer() = default;
     void reload_count();
-    uint32_t m_freq;
-    volatile uint64_t m_timeSinceBootMs;
-    volatile uint64_t m_ticks;
+    static ProgrammableIntervalTimer m_instance;
+    uint32_t m_freq = 0;
+    volatile uint64_t m_timeSinceBootMs = 0;
+    volatile uint64_t m_ticks = 0;
 };
 }
 
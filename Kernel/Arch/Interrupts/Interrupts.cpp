@@ -81,7 +81,7 @@ namespace X86_64::Interrupts {
         m_interruptHandlerTable[vector] = nullptr;
     }
 
-    void Manager::internal_interrupt_handler(uint8_t vector)
+    void Manager::internal_interrupt_handler(uint8_t vector, uint8_t err)
     {
         switch (vector) {
             case ExceptionVectors::PAGE_FAULT:
@@ -92,12 +92,17 @@ namespace X86_64::Interrupts {
                 asm volatile ("mov %%cr2, %0" : "=r" (pageFaultAddress));
                 uint64_t addressSpaceAddress;
                 asm volatile ("mov %%cr3, %0" : "=r" (addressSpaceAddress));
-                auto physicalAddress = Memory::Manager::instance().get_physical_address(pageFaultAddress, Memory::Manager::instance().get_main_address_space());
-                // Check that the physical address exists.
-                if (physicalAddress.get()) {
-                    auto vaddrspace = Memory::VirtualAddressSpace(addressSpaceAddress);
-                    Memory::Manager::instance().request_virtual_map(Memory::VirtualMemoryMapRequest(physicalAddress, Memory::VirtualAddress(BYTE_ALIGN_DOWN(pageFaultAddress, Memory::PAGE_4KiB))), vaddrspace);
-                } else {
+                // The low bits of CR3 hold the PCID when PCIDs are enabled.
+                addressSpaceAddress = BYTE_ALIGN_DOWN(addressSpaceAddress, Memory::PAGE_4KiB);
+                auto vaddrspace = Memory::VirtualAddressSpace(addressSpaceAddress);
+
+                // A write to a present page may be the first write to a copy-on-write page.
+                if ((err & PAGE_FAULT_PRESENT) && (err & PAGE_FAULT_WRITE)
+                    && Memory::Manager::instance().resolve_copy_on_write(pageFaultAddress, vaddrspace))
+                    return;
+
+                // Any other fault on a present page is a protection violation, which mirroring cannot fix.
+                if ((err & PAGE_FAULT_PRESENT) || !Memory::Manager::instance().mirror_main_page(pageFaultAddress, vaddrspace)) {
                     printf("PANIC (HALTING): PAGEFAULT AT");
                     printf(pageFaultAddress);
                     Kernel::stop_execution();
@@ -122,9 +127,9 @@ namespace X86_64::Interrupts {
         Manager::instance().internal_interrupt_handler(vector);
     }
 
-    void Manager::handle_err_interrupt(uint8_t vector, [[maybe_unused]] uint8_t err)
+    void Manager::handle_err_interrupt(uint8_t vector, uint8_t err)
     {
-        Manager::instance().internal_interrupt_handler(vector);
+        Manager::instance().internal_interrupt_handler(vector, err);
     }
 
     void Manager::enable_interrupts()
@@ -64,6 +64,9 @@ namespace X86_64::Interrupts {
     static constexpr uint64_t MAX_PIC_VECTOR = 48;
     static constexpr uint8_t MASTER_PIC_VECTOR_BASE = 32;
     static constexpr uint8_t SLAVE_PIC_VECTOR_BASE = 40;
+    // Bits of the error code pushed with a page fault.
+    static constexpr uint8_t PAGE_FAULT_PRESENT = 0x1;
+    static constexpr uint8_t PAGE_FAULT_WRITE = 0x2;
 
     class Manager
     {
@@ -184,7 +187,7 @@ namespace X86_64::Interrupts {
         void initialise();
         void enable_interrupts();
         void disable_interrupts();
-        void internal_interrupt_handler(uint8_t vector);
+        void internal_interrupt_handler(uint8_t vector, uint8_t err = 0);
         static void handle_noerr_interrupt(uint8_t vector);
         static void handle_err_interrupt(uint8_t vector, uint8_t err);
         /**
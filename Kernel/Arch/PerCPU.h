@@ -0,0 +1,81 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef PERCPU_H
+#define PERCPU_H
+
+#include <cstdint>
+
+#include "Arch/CPU.h"
+
+/**
+ * One instance of T for each processor, each on its own cache lines so that
+ * processors never contend for them. Accesses go to the executing processor's
+ * instance, found through GS, or at compile time when there is one processor.
+ *
+ * PerCPU is constant-initialised when T is, so a static PerCPU needs no guard.
+ * Callers must not be migrated between processors while holding a reference.
+ */
+template<typename T>
+class PerCPU
+{
+public:
+    constexpr PerCPU() = default;
+    PerCPU(const PerCPU&) = delete;
+    PerCPU& operator=(const PerCPU&) = delete;
+
+    T& get()
+    {
+        return m_slots[CPU::current_id()].value;
+    }
+
+    T& get(uint32_t cpu)
+    {
+        return m_slots[cpu].value;
+    }
+
+    T& operator*()
+    {
+        return get();
+    }
+
+    T* operator->()
+    {
+        return &get();
+    }
+
+    /**
+     * Calls f on the instance of every processor, for example to sum counters.
+     */
+    template<typename F>
+    void for_each(F f)
+    {
+        for (auto& slot : m_slots)
+            f(slot.value);
+    }
+
+private:
+    struct alignas(CPU::CACHE_LINE_SIZE) Slot
+    {
+        T value{};
+    };
+
+    Slot m_slots[CPU::MAX_CPUS];
+};
+
+#endif
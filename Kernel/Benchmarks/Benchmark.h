@@ -0,0 +1,54 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+
+#include "print.h"
+
+/**
+ * Microbenchmarks run once at boot when the kernel is configured with XPOS_KERNEL_BENCHMARKS.
+ * Results are printed as the mean number of TSC cycles per operation.
+ */
+namespace Benchmarks
+{
+    static inline uint64_t read_timestamp_counter()
+    {
+        uint32_t low, high;
+        asm volatile ("lfence; rdtsc" : "=a"(low), "=d"(high) : : "memory");
+        return (static_cast<uint64_t>(high) << 32) | low;
+    }
+
+    static inline void report(const char* name, uint64_t cycles, uint64_t operations)
+    {
+        printf("benchmark: ");
+        printf(name);
+        printf(": ");
+        printf(cycles / operations);
+        printf(" cycles/op\n");
+    }
+
+    void run_memory_benchmarks();
+    void run_hashmap_benchmarks();
+    void run_local_socket_benchmarks();
+    void run_network_benchmarks();
+}
+
+#endif
@@ -0,0 +1,131 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "Benchmarks/Benchmark.h"
+#include "Common/Hashmap.h"
+#include "Common/List.h"
+
+namespace Benchmarks
+{
+
+namespace
+{
+    constexpr std::size_t KEY_COUNT = 1024;
+    constexpr std::size_t LOOKUP_ROUNDS = 16;
+
+    /**
+     * The previous Hashmap: chained List buckets, MurmurHash3 over the key's bytes and a
+     * bucket count that never grew past one.
+     */
+    class ChainedHashmap
+    {
+    public:
+        using value_type = std::pair<uint64_t, uint64_t>;
+
+        void insert(const value_type& value)
+        {
+            auto& bucket = m_buckets[bucket_index(value.first)];
+            for (auto& item : bucket) {
+                if (item.first == value.first)
+                    return;
+            }
+            bucket.push_back(value);
+        }
+
+        uint64_t* find(uint64_t key)
+        {
+            for (auto& item : m_buckets[bucket_index(key)]) {
+                if (item.first == key)
+                    return &item.second;
+            }
+            return nullptr;
+        }
+
+        void erase(uint64_t key)
+        {
+            auto& bucket = m_buckets[bucket_index(key)];
+            for (auto it = bucket.begin(); it != bucket.end(); ++it) {
+                if (it->first == key) {
+                    bucket.erase(it);
+                    return;
+                }
+            }
+        }
+
+    private:
+        static constexpr std::size_t BUCKET_COUNT = 1;
+        Common::List<value_type> m_buckets[BUCKET_COUNT];
+
+        std::size_t bucket_index(uint64_t key)
+        {
+            return Common::hash_bytes(&key, sizeof(key)) % BUCKET_COUNT;
+        }
+    };
+
+    // Task IDs, pipe descriptors and futex addresses are the common keys.
+    uint64_t key_at(std::size_t i)
+    {
+        return i * 8 + 0xFFFF800000000000;
+    }
+
+    template<typename Map, typename Find>
+    void run(const char* name, Map& map, Find find)
+    {
+        auto start = read_timestamp_counter();
+        for (std::size_t i = 0; i < KEY_COUNT; i++)
+            map.insert({key_at(i), i});
+        report(name, read_timestamp_counter() - start, KEY_COUNT);
+
+        uint64_t found = 0;
+        start = read_timestamp_counter();
+        for (std::size_t round = 0; round < LOOKUP_ROUNDS; round++) {
+            for (std::size_t i = 0; i < KEY_COUNT; i++)
+                found += find(map, key_at(i));
+        }
+        report("  lookup hit", read_timestamp_counter() - start, LOOKUP_ROUNDS * KEY_COUNT);
+
+        start = read_timestamp_counter();
+        for (std::size_t round = 0; round < LOOKUP_ROUNDS; round++) {
+            for (std::size_t i = 0; i < KEY_COUNT; i++)
+                found += find(map, key_at(i) + 1);
+        }
+        report("  lookup miss", read_timestamp_counter() - start, LOOKUP_ROUNDS * KEY_COUNT);
+
+        start = read_timestamp_counter();
+        for (std::size_t i = 0; i < KEY_COUNT; i++)
+            map.erase(key_at(i));
+        report("  erase", read_timestamp_counter() - start, KEY_COUNT);
+
+        KERNEL_ASSERT(found == LOOKUP_ROUNDS * KEY_COUNT);
+    }
+}
+
+void run_hashmap_benchmarks()
+{
+    ChainedHashmap chained;
+    run("chained hashmap insert 1024 keys", chained, [](ChainedHashmap& map, uint64_t key) -> uint64_t {
+        return map.find(key) != nullptr;
+    });
+
+    Common::Hashmap<uint64_t, uint64_t> open;
+    run("open addressing hashmap insert 1024 keys", open, [](Common::Hashmap<uint64_t, uint64_t>& map, uint64_t key) -> uint64_t {
+        return map.find(key) != map.end();
+    });
+}
+
+}
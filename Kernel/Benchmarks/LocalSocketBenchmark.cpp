@@ -0,0 +1,149 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "Benchmarks/Benchmark.h"
+#include "Memory/MemoryManager.h"
+#include "Pipes/LocalSocket.h"
+#include "Pipes/Pipe.h"
+#include "Tasks/TaskManager.h"
+
+namespace Benchmarks
+{
+
+namespace
+{
+    constexpr std::size_t TRANSFER_BYTES = 64 * 1024 * 1024;
+    constexpr std::size_t MESSAGE_BYTES = 64 * 1024;
+
+    struct Transfer
+    {
+        const char* name;
+        const char* identifier;
+        int flags;
+    };
+
+    constexpr Transfer transfers[] = {
+        { "local socket copy 64KiB writes, per 4KiB", "benchmark::copy", 0 },
+        { "local socket zero-copy 64KiB writes, per 4KiB", "benchmark::zero-copy", static_cast<int>(Sockets::LocalSocket::Flags::ZERO_COPY) }
+    };
+
+    /**
+     * Maps a writeable user buffer in the current task, as socket buffers normally
+     * come from userspace.
+     */
+    uint8_t* map_user_buffer(std::size_t length)
+    {
+        auto& addressSpace = *Task::Manager::instance().get_current_task()->tlTable;
+        auto region = addressSpace.acquire_available_region(length);
+        auto start = reinterpret_cast<uint64_t>(region.start);
+        for (auto page = start; page < start + length; page += Memory::PAGE_4KiB)
+            Memory::Manager::instance().alloc_page(Memory::VirtualMemoryAllocationRequest(page, true, true), addressSpace);
+        return static_cast<uint8_t*>(region.start);
+    }
+
+    void unmap_user_buffer(uint8_t* buffer, std::size_t length)
+    {
+        auto& addressSpace = *Task::Manager::instance().get_current_task()->tlTable;
+        auto region = addressSpace.extract_region(buffer);
+        auto start = reinterpret_cast<uint64_t>(region.start);
+        for (auto page = start; page < start + length; page += Memory::PAGE_4KiB)
+            Memory::Manager::instance().free_page(Memory::VirtualMemoryFreeRequest(page), addressSpace);
+    }
+
+    void send_messages(Pipes::Pipe& pipe, uint8_t* buffer)
+    {
+        for (std::size_t sent = 0; sent < TRANSFER_BYTES; sent += MESSAGE_BYTES) {
+            // Producing each message writes every page, which is where lent pages pay
+            // for copy-on-write if the reader still holds them.
+            for (std::size_t i = 0; i < MESSAGE_BYTES; i += Memory::PAGE_4KiB)
+                buffer[i] = static_cast<uint8_t>(sent);
+
+            std::size_t written = 0;
+            while (written < MESSAGE_BYTES) {
+                auto count = pipe.write(MESSAGE_BYTES - written, buffer + written);
+                if (count == 0)
+                    return;
+                written += count;
+            }
+        }
+    }
+
+    void send(const Transfer* transfer)
+    {
+        auto* buffer = map_user_buffer(MESSAGE_BYTES);
+        {
+            Pipes::Pipe pipe("socket::local", nullptr, transfer->flags);
+            if (Sockets::LocalSocket::connect(pipe, transfer->identifier))
+                send_messages(pipe, buffer);
+        }
+        unmap_user_buffer(buffer, MESSAGE_BYTES);
+    }
+
+    void receive_messages(const Transfer& transfer, uint8_t* buffer)
+    {
+        Pipes::Pipe listener("socket::local");
+        Pipes::Pipe connection("socket::local");
+        if (!Sockets::LocalSocket::bind(listener, transfer.identifier) || !Sockets::LocalSocket::listen(listener))
+            return;
+
+        // The sender has its own address space, so pages really move between processes.
+        Task::Manager::instance().launch_task({
+            .addressSpace = Memory::RegionableVirtualAddressSpace::create(),
+            .openPipes = Common::AutomaticReferenceCountable<Task::PipeTable>(Task::PipeTable()),
+            .entryPoint = reinterpret_cast<void*>(&send),
+            .launchParam = const_cast<Transfer*>(&transfer)
+        });
+        if (!Sockets::LocalSocket::accept(listener, connection))
+            return;
+
+        std::size_t received = 0;
+        auto start = read_timestamp_counter();
+        while (received < TRANSFER_BYTES) {
+            auto count = connection.read(MESSAGE_BYTES, buffer);
+            if (count == 0)
+                return;
+            received += count;
+        }
+        report(transfer.name, read_timestamp_counter() - start, TRANSFER_BYTES / Memory::PAGE_4KiB);
+    }
+
+    void receive(const Transfer& transfer)
+    {
+        auto* buffer = map_user_buffer(MESSAGE_BYTES);
+        receive_messages(transfer, buffer);
+        unmap_user_buffer(buffer, MESSAGE_BYTES);
+    }
+
+    void run_transfers(void*)
+    {
+        for (auto& transfer : transfers)
+            receive(transfer);
+    }
+}
+
+void run_local_socket_benchmarks()
+{
+    // Transfers need the scheduler, so they run in their own task once it starts.
+    Task::Manager::instance().launch_task({
+        .addressSpace = Memory::RegionableVirtualAddressSpace::create(),
+        .openPipes = Common::AutomaticReferenceCountable<Task::PipeTable>(Task::PipeTable()),
+        .entryPoint = reinterpret_cast<void*>(&run_transfers)
+    });
+}
+
+}
@@ -0,0 +1,91 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "Benchmarks/Benchmark.h"
+#include "Common/ObjectCache.h"
+#include "Memory/KernelHeap.h"
+
+namespace Benchmarks
+{
+
+namespace
+{
+    constexpr std::size_t ITERATIONS = 100000;
+    constexpr std::size_t BATCH_SIZE = 512;
+
+    struct SmallObject
+    {
+        uint64_t data[8];
+
+        static void* operator new(std::size_t) { return Common::ObjectCache<SmallObject>::instance().allocate(); }
+        static void operator delete(void* ptr) { Common::ObjectCache<SmallObject>::instance().free(ptr); }
+    };
+
+    void* batch[BATCH_SIZE];
+
+    void kmalloc_pairs()
+    {
+        auto start = read_timestamp_counter();
+        for (std::size_t i = 0; i < ITERATIONS; i++)
+            kfree(kmalloc(sizeof(SmallObject)));
+        report("kmalloc/kfree 64B", read_timestamp_counter() - start, ITERATIONS);
+    }
+
+    void object_cache_pairs()
+    {
+        auto start = read_timestamp_counter();
+        for (std::size_t i = 0; i < ITERATIONS; i++)
+            delete new SmallObject;
+        report("object cache new/delete 64B", read_timestamp_counter() - start, ITERATIONS);
+    }
+
+    void kmalloc_batches()
+    {
+        auto start = read_timestamp_counter();
+        for (std::size_t round = 0; round < ITERATIONS / BATCH_SIZE; round++) {
+            for (std::size_t i = 0; i < BATCH_SIZE; i++)
+                batch[i] = kmalloc(sizeof(SmallObject));
+            for (std::size_t i = 0; i < BATCH_SIZE; i++)
+                kfree(batch[i]);
+        }
+        report("kmalloc/kfree 64B batch of 512", read_timestamp_counter() - start, (ITERATIONS / BATCH_SIZE) * BATCH_SIZE);
+    }
+
+    void object_cache_batches()
+    {
+        auto start = read_timestamp_counter();
+        for (std::size_t round = 0; round < ITERATIONS / BATCH_SIZE; round++) {
+            for (std::size_t i = 0; i < BATCH_SIZE; i++)
+                batch[i] = new SmallObject;
+            for (std::size_t i = 0; i < BATCH_SIZE; i++)
+                delete static_cast<SmallObject*>(batch[i]);
+        }
+        report("object cache new/delete 64B batch of 512", read_timestamp_counter() - start, (ITERATIONS / BATCH_SIZE) * BATCH_SIZE);
+    }
+}
+
+void run_memory_benchmarks()
+{
+    kmalloc_pairs();
+    object_cache_pairs();
+    kmalloc_batches();
+    object_cache_batches();
+    Common::ObjectCache<SmallObject>::instance().reclaim();
+}
+
+}
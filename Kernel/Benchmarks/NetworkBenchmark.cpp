@@ -0,0 +1,189 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "Benchmarks/Benchmark.h"
+#include "Common/Vector.h"
+#include "Memory/KernelHeap.h"
+#include "Networking/Ethernet/Common.h"
+#include "Networking/IP/IPv4/Common.h"
+#include "Networking/PacketBuffer.h"
+#include "Networking/TCP/Common.h"
+
+namespace Benchmarks
+{
+
+namespace
+{
+    using namespace Networking;
+    namespace IPv4 = Networking::InternetProtocolV4;
+    namespace TCP = Networking::TransmissionControlProtocol;
+
+    constexpr std::size_t PACKET_COUNT = 16 * 1024;
+    constexpr std::size_t SEGMENT_BYTES = 1024;
+
+    // Each packet is sent to a loopback device, received from it and delivered to a
+    // socket, with the device's ring and the socket's buffer standing in as below.
+    uint8_t deviceRing[PacketBuffer::CAPACITY];
+    uint8_t socketBuffer[SEGMENT_BYTES];
+    uint8_t segmentData[SEGMENT_BYTES];
+    std::size_t copies = 0;
+
+    void copy(void* to, const void* from, std::size_t count)
+    {
+        memcpy(to, from, count);
+        copies++;
+    }
+
+    void fill_headers(TCP::PseudoHeader* pseudoHeader, TCP::Header* header, std::size_t size)
+    {
+        header->set_source_port(80);
+        header->set_dest_port(8080);
+        header->set_sequence_number(1);
+        header->set_ack_number(1);
+        header->set_flags(TCP::Flags::ACK);
+        header->set_window_size(8192);
+        header->set_checksum(0);
+        header->set_urgent_pointer(0);
+        header->set_options(0);
+        header->set_data_offset(sizeof(TCP::Header) / 4);
+        pseudoHeader->set_dest_ip(IPv4::ipAddress);
+        pseudoHeader->set_source_ip(IPv4::ipAddress);
+        pseudoHeader->set_length(sizeof(TCP::Header) + size);
+        pseudoHeader->set_protocol(IPv4::Protocol::TCP);
+
+        Utilities::BigEndian<uint16_t> chksum;
+        chksum.set_raw_value(IPv4::checksum(reinterpret_cast<uint16_t*>(pseudoHeader), sizeof(TCP::PseudoHeader) + sizeof(TCP::Header) + size));
+        header->set_checksum(chksum.get_value());
+    }
+
+    void fill_header(IPv4::MessageHeader* message, std::size_t size)
+    {
+        message->set_version(IPv4::Version::IPV4);
+        message->set_ihl(sizeof(IPv4::MessageHeader) / 4);
+        message->set_length(size);
+        message->set_ident(0x0001);
+        message->set_flags(IPv4::Flags::NO_FRAGMENT);
+        message->set_fragment_offset(0);
+        message->set_time_to_live(0x40);
+        message->set_protocol(IPv4::Protocol::TCP);
+        message->set_dest_ip(IPv4::ipAddress);
+        message->set_source_ip(IPv4::ipAddress);
+        message->set_header_checksum(0);
+        Utilities::BigEndian<uint16_t> chksum;
+        chksum.set_raw_value(IPv4::checksum(reinterpret_cast<uint16_t*>(message), sizeof(IPv4::MessageHeader)));
+        message->set_header_checksum(chksum.get_value());
+    }
+
+    void fill_header(Ethernet::FrameHeader* frame)
+    {
+        frame->macDest = Ethernet::macAddress;
+        frame->macSource = Ethernet::macAddress;
+        frame->ethertype = Ethernet::EtherTypeValues::IPV4;
+    }
+
+    /**
+     * The previous stack: each layer allocated a buffer for its header and copied the
+     * layers above in after it, and received segments were copied again to make room
+     * for the pseudo-header.
+     */
+    void loopback_copying()
+    {
+        auto tcpSize = sizeof(TCP::PseudoHeader) + sizeof(TCP::Header) + SEGMENT_BYTES;
+        auto* tcp = static_cast<uint8_t*>(kmalloc(tcpSize, 0));
+        copy(tcp + sizeof(TCP::PseudoHeader) + sizeof(TCP::Header), segmentData, SEGMENT_BYTES);
+        fill_headers(reinterpret_cast<TCP::PseudoHeader*>(tcp), reinterpret_cast<TCP::Header*>(tcp + sizeof(TCP::PseudoHeader)), SEGMENT_BYTES);
+
+        auto ipSize = sizeof(IPv4::MessageHeader) + sizeof(TCP::Header) + SEGMENT_BYTES;
+        auto* ip = static_cast<uint8_t*>(kmalloc(ipSize, 0));
+        fill_header(reinterpret_cast<IPv4::MessageHeader*>(ip), ipSize);
+        copy(ip + sizeof(IPv4::MessageHeader), tcp + sizeof(TCP::PseudoHeader), ipSize - sizeof(IPv4::MessageHeader));
+
+        auto frameSize = sizeof(Ethernet::FrameHeader) + ipSize;
+        auto* frame = static_cast<uint8_t*>(kmalloc(frameSize, 0));
+        fill_header(reinterpret_cast<Ethernet::FrameHeader*>(frame));
+        copy(frame + sizeof(Ethernet::FrameHeader), ip, ipSize);
+
+        copy(deviceRing, frame, frameSize);
+        // The previous stack leaked these, which would not survive the benchmark.
+        kfree(frame);
+        kfree(ip);
+        kfree(tcp);
+
+        Common::Vector<uint8_t> received;
+        received.assign(deviceRing, frameSize);
+        copies++;
+
+        auto* segment = received.data() + sizeof(Ethernet::FrameHeader) + sizeof(IPv4::MessageHeader);
+        auto segmentSize = sizeof(TCP::Header) + SEGMENT_BYTES;
+        auto* checked = static_cast<uint8_t*>(kmalloc(sizeof(TCP::PseudoHeader) + segmentSize, 0));
+        copy(checked + sizeof(TCP::PseudoHeader), segment, segmentSize);
+        kfree(checked);
+
+        copy(socketBuffer, segment + sizeof(TCP::Header), SEGMENT_BYTES);
+    }
+
+    /**
+     * The stack now: one buffer with headroom is filled once and each layer prepends
+     * its header in place, and received frames are passed up by pulling headers off.
+     */
+    void loopback_packet_buffer()
+    {
+        PacketHandle packet(PacketBuffer::allocate());
+        copy(packet->put(SEGMENT_BYTES), segmentData, SEGMENT_BYTES);
+        auto* header = reinterpret_cast<TCP::Header*>(packet->push(sizeof(TCP::Header)));
+        fill_headers(reinterpret_cast<TCP::PseudoHeader*>(packet->push(sizeof(TCP::PseudoHeader))), header, SEGMENT_BYTES);
+        packet->pull(sizeof(TCP::PseudoHeader));
+        fill_header(reinterpret_cast<IPv4::MessageHeader*>(packet->push(sizeof(IPv4::MessageHeader))), packet->size() + sizeof(IPv4::MessageHeader));
+        fill_header(reinterpret_cast<Ethernet::FrameHeader*>(packet->push(sizeof(Ethernet::FrameHeader))));
+
+        auto frameSize = packet->size();
+        copy(deviceRing, packet->data(), frameSize);
+        packet = PacketHandle();
+
+        PacketHandle received(PacketBuffer::allocate(0));
+        copy(received->put(frameSize), deviceRing, frameSize);
+        received->pull(sizeof(Ethernet::FrameHeader));
+        received->pull(sizeof(IPv4::MessageHeader));
+        received->pull(sizeof(TCP::Header));
+
+        copy(socketBuffer, received->data(), received->size());
+    }
+
+    void run(const char* name, void (*loopback)())
+    {
+        copies = 0;
+        auto start = read_timestamp_counter();
+        for (std::size_t i = 0; i < PACKET_COUNT; i++)
+            loopback();
+        report(name, read_timestamp_counter() - start, PACKET_COUNT);
+
+        printf("benchmark: ");
+        printf(name);
+        printf(": ");
+        printf(copies / PACKET_COUNT);
+        printf(" copies/packet\n");
+    }
+}
+
+void run_network_benchmarks()
+{
+    run("network loopback 1KiB segment, buffer per layer", loopback_copying);
+    run("network loopback 1KiB segment, packet buffer", loopback_packet_buffer);
+}
+
+}
@@ -0,0 +1,488 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef XPOS_COMMON_DEQUE_H
+#define XPOS_COMMON_DEQUE_H
+
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace Common
+{
+
+/**
+ * A double-ended queue that stores its elements in fixed-size chunks, held in a
+ * ring of chunk pointers. Pushing and popping at either end is amortised
+ * constant time and only allocates when a chunk fills up. The most recently
+ * emptied chunk is kept for reuse, so a queue that is drained as fast as it is
+ * filled stops allocating altogether.
+ *
+ * @tparam T type of element stored.
+ */
+template<typename T>
+class Deque
+{
+private:
+    template<bool IsConst>
+    class IteratorBase;
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+
+    using Iterator = IteratorBase<false>;
+    using ConstIterator = IteratorBase<true>;
+
+    Deque() = default;
+
+    ~Deque()
+    {
+        clear();
+        delete[] m_chunks;
+        free_chunk(m_spareChunk);
+    }
+
+    Deque(const Deque& other)
+    {
+        for (auto& item : other)
+            push_back(item);
+    }
+
+    Deque(Deque&& other)
+    {
+        swap(*this, other);
+    }
+
+    Deque& operator=(Deque other)
+    {
+        swap(*this, other);
+        return *this;
+    }
+
+    /**
+     * Swaps the contents of two deques.
+     */
+    friend void swap(Deque& a, Deque& b)
+    {
+        using std::swap;
+        swap(a.m_chunks, b.m_chunks);
+        swap(a.m_chunkCapacity, b.m_chunkCapacity);
+        swap(a.m_firstChunk, b.m_firstChunk);
+        swap(a.m_chunkCount, b.m_chunkCount);
+        swap(a.m_front, b.m_front);
+        swap(a.m_size, b.m_size);
+        swap(a.m_spareChunk, b.m_spareChunk);
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    reference operator[](size_type position)
+    {
+        return *element(position);
+    }
+
+    const_reference operator[](size_type position) const
+    {
+        return *element(position);
+    }
+
+    reference front()
+    {
+        return *element(0);
+    }
+
+    const_reference front() const
+    {
+        return *element(0);
+    }
+
+    reference back()
+    {
+        return *element(m_size - 1);
+    }
+
+    const_reference back() const
+    {
+        return *element(m_size - 1);
+    }
+
+    Iterator begin()
+    {
+        return Iterator(this, 0);
+    }
+
+    Iterator end()
+    {
+        return Iterator(this, m_size);
+    }
+
+    ConstIterator begin() const
+    {
+        return cbegin();
+    }
+
+    ConstIterator end() const
+    {
+        return cend();
+    }
+
+    ConstIterator cbegin() const
+    {
+        return ConstIterator(this, 0);
+    }
+
+    ConstIterator cend() const
+    {
+        return ConstIterator(this, m_size);
+    }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    template<class... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if (m_front + m_size == m_chunkCount * CHUNK_SIZE)
+            add_back_chunk();
+
+        auto* slot = element(m_size);
+        new (slot) T(std::forward<Args>(args)...);
+        m_size++;
+        return *slot;
+    }
+
+    void push_front(const T& value)
+    {
+        emplace_front(value);
+    }
+
+    void push_front(T&& value)
+    {
+        emplace_front(std::move(value));
+    }
+
+    template<class... Args>
+    reference emplace_front(Args&&... args)
+    {
+        if (m_front == 0)
+            add_front_chunk();
+
+        auto* slot = chunk_slot(m_front - 1);
+        new (slot) T(std::forward<Args>(args)...);
+        m_front--;
+        m_size++;
+        return *slot;
+    }
+
+    void pop_front()
+    {
+        element(0)->~T();
+        m_front++;
+        m_size--;
+
+        if (m_size == 0) {
+            release_all_chunks();
+        } else if (m_front == CHUNK_SIZE) {
+            release_chunk(m_chunks[m_firstChunk]);
+            m_firstChunk = (m_firstChunk + 1) & (m_chunkCapacity - 1);
+            m_chunkCount--;
+            m_front = 0;
+        }
+    }
+
+    void pop_back()
+    {
+        element(m_size - 1)->~T();
+        m_size--;
+
+        if (m_size == 0) {
+            release_all_chunks();
+        } else if (m_chunkCount * CHUNK_SIZE - (m_front + m_size) == CHUNK_SIZE) {
+            m_chunkCount--;
+            release_chunk(m_chunks[(m_firstChunk + m_chunkCount) & (m_chunkCapacity - 1)]);
+        }
+    }
+
+    /**
+     * Inserts an element before the given position. Elements after it are shifted
+     * along, so this is linear in their number. This invalidates iterators.
+     *
+     * @return an iterator pointing to the inserted element.
+     */
+    Iterator insert(ConstIterator it, T value)
+    {
+        auto position = it.m_index;
+        push_back(std::move(value));
+        for (auto index = m_size - 1; index > position; index--) {
+            using std::swap;
+            swap(*element(index), *element(index - 1));
+        }
+        return Iterator(this, position);
+    }
+
+    /**
+     * Destroys every element. One chunk is kept for reuse.
+     */
+    void clear()
+    {
+        for (size_type i = 0; i < m_size; i++)
+            element(i)->~T();
+        m_size = 0;
+        release_all_chunks();
+    }
+
+private:
+    // Chunks hold at least eight elements, or around 512 bytes of small ones.
+    static constexpr size_type CHUNK_SIZE = sizeof(T) * 8 > 512 ? 8 : 512 / sizeof(T);
+    static constexpr size_type MIN_CHUNK_CAPACITY = 4;
+
+    // A ring of chunk pointers, of which m_chunkCount starting at m_firstChunk are in use.
+    T** m_chunks = nullptr;
+    size_type m_chunkCapacity = 0;
+    size_type m_firstChunk = 0;
+    size_type m_chunkCount = 0;
+    // The index of the front element within the first chunk.
+    size_type m_front = 0;
+    size_type m_size = 0;
+    T* m_spareChunk = nullptr;
+
+    T* chunk_slot(size_type offset) const
+    {
+        auto* chunk = m_chunks[(m_firstChunk + offset / CHUNK_SIZE) & (m_chunkCapacity - 1)];
+        return chunk + offset % CHUNK_SIZE;
+    }
+
+    T* element(size_type position) const
+    {
+        return chunk_slot(m_front + position);
+    }
+
+    T* allocate_chunk()
+    {
+        if (m_spareChunk)
+            return std::exchange(m_spareChunk, nullptr);
+        return reinterpret_cast<T*>(std::launder(new uint8_t[sizeof(T) * CHUNK_SIZE]));
+    }
+
+    static void free_chunk(T* chunk)
+    {
+        delete[] reinterpret_cast<uint8_t*>(chunk);
+    }
+
+    void release_chunk(T* chunk)
+    {
+        if (m_spareChunk)
+            free_chunk(chunk);
+        else
+            m_spareChunk = chunk;
+    }
+
+    void release_all_chunks()
+    {
+        for (size_type i = 0; i < m_chunkCount; i++)
+            release_chunk(m_chunks[(m_firstChunk + i) & (m_chunkCapacity - 1)]);
+        m_chunkCount = 0;
+        m_firstChunk = 0;
+        m_front = 0;
+    }
+
+    /**
+     * Makes room in the ring for one more chunk pointer.
+     */
+    void reserve_chunk()
+    {
+        if (m_chunkCount < m_chunkCapacity)
+            return;
+
+        auto capacity = m_chunkCapacity ? m_chunkCapacity * 2 : MIN_CHUNK_CAPACITY;
+        auto** chunks = new T*[capacity];
+        for (size_type i = 0; i < m_chunkCount; i++)
+            chunks[i] = m_chunks[(m_firstChunk + i) & (m_chunkCapacity - 1)];
+        delete[] m_chunks;
+        m_chunks = chunks;
+        m_chunkCapacity = capacity;
+        m_firstChunk = 0;
+    }
+
+    void add_back_chunk()
+    {
+        reserve_chunk();
+        m_chunks[(m_firstChunk + m_chunkCount) & (m_chunkCapacity - 1)] = allocate_chunk();
+        m_chunkCount++;
+    }
+
+    void add_front_chunk()
+    {
+        reserve_chunk();
+        m_firstChunk = (m_firstChunk - 1) & (m_chunkCapacity - 1);
+        m_chunks[m_firstChunk] = allocate_chunk();
+        m_chunkCount++;
+        m_front += CHUNK_SIZE;
+    }
+
+    template<bool IsConst>
+    class IteratorBase
+    {
+        friend class Deque;
+    public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+        using iterator_category = std::random_access_iterator_tag;
+
+        IteratorBase() = default;
+
+        template<bool WasConst, class = std::enable_if_t<IsConst || !WasConst>>
+        IteratorBase(const IteratorBase<WasConst>& rhs)
+            : m_deque(rhs.m_deque)
+            , m_index(rhs.m_index)
+        {
+            /**
+            * We want to be able to construct a const iterator from a non-const
+            * iterator, but not vice versa. As a result, this template is only
+            * suitable if we are constructing a const iterator (IsConst), or we 
+            * are constructing from a non const iterator (not WasConst).
+            */
+        }
+
+        reference operator*() const
+        {
+            return *m_deque->element(m_index);
+        }
+
+        pointer operator->() const
+        {
+            return m_deque->element(m_index);
+        }
+
+        reference operator[](difference_type i) const
+        {
+            return *m_deque->element(m_index + i);
+        }
+
+        IteratorBase& operator++()
+        {
+            m_index++;
+            return *this;
+        }
+
+        IteratorBase& operator--()
+        {
+            m_index--;
+            return *this;
+        }
+
+        IteratorBase operator++(int)
+        {
+            auto copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        IteratorBase operator--(int)
+        {
+            auto copy = *this;
+            --(*this);
+            return copy;
+        }
+
+        IteratorBase& operator+=(difference_type i)
+        {
+            m_index += i;
+            return *this;
+        }
+
+        IteratorBase& operator-=(difference_type i)
+        {
+            m_index -= i;
+            return *this;
+        }
+
+        friend IteratorBase operator+(IteratorBase lhs, difference_type i)
+        {
+            return lhs += i;
+        }
+
+        friend IteratorBase operator+(difference_type i, IteratorBase rhs)
+        {
+            return rhs += i;
+        }
+
+        friend IteratorBase operator-(IteratorBase lhs, difference_type i)
+        {
+            return lhs -= i;
+        }
+
+        friend difference_type operator-(const IteratorBase& lhs, const IteratorBase& rhs)
+        {
+            return static_cast<difference_type>(lhs.m_index) - static_cast<difference_type>(rhs.m_index);
+        }
+
+        friend bool operator==(const IteratorBase& lhs, const IteratorBase& rhs)
+        {
+            return lhs.m_index == rhs.m_index;
+        }
+
+        friend auto operator<=>(const IteratorBase& lhs, const IteratorBase& rhs)
+        {
+            return lhs.m_index <=> rhs.m_index;
+        }
+
+    private:
+        using DequePointer = std::conditional_t<IsConst, const Deque*, Deque*>;
+
+        IteratorBase(DequePointer deque, size_type index)
+            : m_deque(deque)
+            , m_index(index)
+        {}
+
+        template<bool>
+        friend class IteratorBase;
+
+        DequePointer m_deque = nullptr;
+        size_type m_index = 0;
+    };
+
+    static_assert(std::random_access_iterator<Iterator>);
+};
+
+}
+
+#endif
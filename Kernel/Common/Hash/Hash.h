@@ -0,0 +1,121 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef XPOS_COMMON_HASH_H
+#define XPOS_COMMON_HASH_H
+
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "Common/Hash/MurmurHash3.h"
+#include "Common/String.h"
+
+namespace Common
+{
+
+/**
+ * Mixes an integer with a single multiply. The high bits of the product are folded back
+ * into the low bits, as the Hashmap picks a probe position from the low bits and a tag
+ * from the high bits.
+ */
+constexpr uint64_t hash_integer(uint64_t value)
+{
+    value *= 0x9E3779B97F4A7C15;
+    return value ^ (value >> 32);
+}
+
+constexpr uint64_t hash_combine(uint64_t seed, uint64_t value)
+{
+    return hash_integer(seed ^ (value + 0x9E3779B97F4A7C15 + (seed << 6) + (seed >> 2)));
+}
+
+inline uint64_t hash_bytes(const void* data, std::size_t length)
+{
+    uint64_t hashedIntegers[2];
+    // This is an open source hash.
+    MurmurHash3_x64_128(data, length, 3, hashedIntegers);
+    return hashedIntegers[0];
+}
+
+/**
+ * The hash used by Hashmap. Specialisations may provide hash() overloads for other types
+ * that compare equal to the key type, so that maps can be searched without constructing a key.
+ *
+ * By default, keys are hashed by their object representation.
+ */
+template<typename K>
+struct Hash
+{
+    static uint64_t hash(const K& key)
+    {
+        if constexpr (sizeof(K) <= sizeof(uint64_t) && std::is_trivially_copyable_v<K>) {
+            uint64_t value = 0;
+            memcpy(&value, &key, sizeof(K));
+            return hash_integer(value);
+        } else {
+            return hash_bytes(&key, sizeof(K));
+        }
+    }
+};
+
+template<std::integral K>
+struct Hash<K>
+{
+    static uint64_t hash(K key) { return hash_integer(static_cast<uint64_t>(key)); }
+};
+
+template<typename T>
+struct Hash<T*>
+{
+    static uint64_t hash(const T* key) { return hash_integer(reinterpret_cast<uintptr_t>(key)); }
+};
+
+template<typename A, typename B>
+struct Hash<std::pair<A, B>>
+{
+    static uint64_t hash(const std::pair<A, B>& key)
+    {
+        return hash_combine(Hash<A>::hash(key.first), Hash<B>::hash(key.second));
+    }
+};
+
+template<>
+struct Hash<String>
+{
+    static uint64_t hash(StringView key) { return hash_bytes(key.data(), key.size()); }
+};
+
+template<>
+struct Hash<HashableString>
+{
+    static uint64_t hash(const HashableString& key) { return hash(key.string()); }
+
+    static uint64_t hash(const char* key)
+    {
+        std::size_t length = 0;
+        while (key[length])
+            length++;
+        return hash_bytes(key, length);
+    }
+};
+
+}
+
+#endif
@@ -16,10 +16,11 @@
     xpOS v1.0
 */
 
+#include <iterator>
+#include <new>
 #include <utility>
 
-#include "Common/List.h"
-#include "Common/Hash/MurmurHash3.h"
+#include "Common/Hash/Hash.h"
 
 #include "panic.h"
 #ifndef XPOS_COMMON_HASHMAP_H
@@ -31,10 +32,15 @@ namespace Common {
  * A data structure that allows amortised constant time lookup for key-value
  * pairs.
  * 
+ * Pairs are stored inline in a single open-addressed table. Each slot has a
+ * control byte holding seven bits of the key's hash, and lookups compare eight
+ * control bytes at a time before touching any keys.
+ * 
  * @tparam K the key type.
  * @tparam V the value type.
+ * @tparam H the hash of the key, see Hash.
 */
-template<typename K, typename V>
+template<typename K, typename V, typename H = Hash<K>>
 class Hashmap
 {
 private:
@@ -48,26 +54,32 @@ public:
 
     using Iterator = IteratorBase<false>;
     using ConstIterator = IteratorBase<true>;
-private:
-    using Bucket = List<value_type>;
-public:
 
-    Hashmap()
-        : m_bucketArray(new Bucket[m_bucketCount])
-    {
-    }
+    /**
+     * Types other than K that can be used to search the map. The hash must
+     * provide an overload for them, and they must compare equal with the key.
+     * Arithmetic types are converted to K instead.
+     */
+    template<typename Q>
+    static constexpr bool IsLookupKey = (std::is_same_v<Q, K> || !std::is_arithmetic_v<Q>) && requires(const K& key, const Q& query) {
+        { H::hash(query) } -> std::convertible_to<uint64_t>;
+        { key == query } -> std::convertible_to<bool>;
+    };
+
+    Hashmap() = default;
 
     ~Hashmap()
     {
-        if (m_bucketArray) {
+        if (m_slots) {
             clear();
-            delete[] m_bucketArray;
+            free_table(m_slots);
         }
     }
 
     Hashmap(const Hashmap& other)
         : Hashmap()
     {
+        reserve(other.size());
         for (auto& item : other) {
             insert(item);
         }
@@ -80,13 +92,17 @@ public:
     }
 
     Hashmap(Hashmap&& other)
-        : m_bucketCount(other.m_bucketCount)
+        : m_capacity(other.m_capacity)
         , m_size(other.m_size)
-        , m_bucketArray(other.m_bucketArray)
+        , m_growthLeft(other.m_growthLeft)
+        , m_control(other.m_control)
+        , m_slots(other.m_slots)
     {
-        other.m_bucketCount = 0;
+        other.m_capacity = 0;
         other.m_size = 0;
-        other.m_bucketArray = nullptr;
+        other.m_growthLeft = 0;
+        other.m_control = nullptr;
+        other.m_slots = nullptr;
     }
 
     /**
@@ -98,16 +114,22 @@ public:
     friend void swap(Hashmap& a, Hashmap& b)
     {
         using std::swap;
-        swap(a.m_bucketCount, b.m_bucketCount);
+        swap(a.m_capacity, b.m_capacity);
         swap(a.m_size, b.m_size);
-        swap(a.m_bucketArray, b.m_bucketArray);
+        swap(a.m_growthLeft, b.m_growthLeft);
+        swap(a.m_control, b.m_control);
+        swap(a.m_slots, b.m_slots);
     }
 
     void clear()
     {
-        for (std::size_t bucket = 0; bucket < m_bucketCount; bucket++)
-            m_bucketArray[bucket].clear();
+        for (std::size_t index = 0; index < m_capacity; index++) {
+            if (is_full(m_control[index]))
+                m_slots[index].~value_type();
+            m_control[index] = EMPTY;
+        }
         m_size = 0;
+        m_growthLeft = max_load(m_capacity);
     }
 
     std::size_t size() const
@@ -115,6 +137,21 @@ public:
         return m_size;
     }
 
+    /**
+     * Grows the table so that it can hold count pairs without rehashing.
+     * This invalidates iterators if the table grows.
+    */
+    void reserve(std::size_t count)
+    {
+        if (count <= m_size + m_growthLeft)
+            return;
+
+        auto capacity = m_capacity ? m_capacity : MIN_CAPACITY;
+        while (max_load(capacity) < count)
+            capacity *= 2;
+        rehash(capacity);
+    }
+
     /**
      * Inserts a key-value pair. This invalidates iterators.
      * 
@@ -125,11 +162,7 @@ public:
     */
     std::pair<Iterator, bool> insert(const value_type& value)
     {
-        auto it = find(value.first);
-        if (it != end()) {
-            return std::pair(it, false);
-        }
-        return std::pair(force_insert(value), true);
+        return insert_unique(value);
     }
 
     /**
@@ -142,11 +175,7 @@ public:
     */
     std::pair<Iterator, bool> insert(value_type&& value)
     {
-        auto it = find(value.first);
-        if (it != end()) {
-            return std::pair(it, false);
-        }
-        return std::pair(force_insert(std::move(value)), true);
+        return insert_unique(std::move(value));
     }
     
     /**
@@ -160,12 +189,7 @@ public:
     template<class P, std::enable_if_t<std::is_constructible<value_type, P&&>::value, bool> = true>
     std::pair<Iterator, bool> insert(P&& value)
     {
-        auto constructedValue = value_type(std::forward<P>(value));
-        auto it = find(constructedValue.first);
-        if (it != end()) {
-            return std::pair(it, false);
-        }
-        return std::pair(force_insert(std::move(constructedValue)), true);
+        return insert_unique(value_type(std::forward<P>(value)));
     }
 
     /**
@@ -174,14 +198,12 @@ public:
     template<class... Args>
     std::pair<Iterator, bool> emplace(Args&&... args)
     {
-        return insert(value_type(args...));
+        return insert_unique(value_type(std::forward<Args>(args)...));
     }
 
     Iterator begin()
     {
-        if (size() == 0)
-            return end();
-        return Iterator(m_bucketArray->begin(), m_bucketArray, m_bucketArray + m_bucketCount);
+        return Iterator(next_full(0), m_control, m_slots, m_capacity);
     }
 
     Iterator end()
@@ -201,9 +223,7 @@ public:
 
     ConstIterator cbegin() const
     {
-        if (size() == 0)
-            return cend();
-        return ConstIterator(m_bucketArray->begin(), m_bucketArray, m_bucketArray + m_bucketCount);
+        return ConstIterator(next_full(0), m_control, m_slots, m_capacity);
     }
 
     ConstIterator cend() const
@@ -218,13 +238,16 @@ public:
     */
     Iterator find(const K& key)
     {
-        // Search through the bucket to find the key.
-        auto* bucket = m_bucketArray + bucket_index(key);
-        for (auto it = bucket->begin(); it != bucket->end(); ++it) {
-            if (it->first == key) 
-                return Iterator(it, bucket, m_bucketArray + m_bucketCount);
-        }
-        return Iterator();
+        return find<K>(key);
+    }
+
+    template<typename Q> requires IsLookupKey<Q>
+    Iterator find(const Q& key)
+    {
+        auto index = find_index(key, H::hash(key));
+        if (index == NOT_FOUND)
+            return end();
+        return Iterator(index, m_control, m_slots, m_capacity);
     }
 
     /**
@@ -234,12 +257,16 @@ public:
     */
     ConstIterator find(const K& key) const
     {
-        auto* bucket = m_bucketArray + bucket_index(key);
-        for (auto it = bucket->begin(); it != bucket->end(); ++it) {
-            if (it->first == key)
-                return ConstIterator(it, bucket, m_bucketArray + m_bucketCount);
-        }
-        return ConstIterator();
+        return find<K>(key);
+    }
+
+    template<typename Q> requires IsLookupKey<Q>
+    ConstIterator find(const Q& key) const
+    {
+        auto index = find_index(key, H::hash(key));
+        if (index == NOT_FOUND)
+            return cend();
+        return ConstIterator(index, m_control, m_slots, m_capacity);
     }
 
     /**
@@ -269,40 +296,134 @@ public:
     }
 
     /**
-     * Remove the key-value pair associated with the given key and rebalance if needed.
-     * This invalidates iterators.
+     * Remove the key-value pair associated with the given key. Iterators to
+     * other pairs remain valid.
      * 
      * @param key the key of the pair to be erased.
     */
     void erase(const K& key)
     {
-        auto it = find(key);
-        if (it != end()) {
-            it.m_bucket->erase(it.m_bucketIterator);
-            update_size_on_removal();
-        }
+        erase<K>(key);
+    }
+
+    template<typename Q> requires IsLookupKey<Q>
+    void erase(const Q& key)
+    {
+        auto index = find_index(key, H::hash(key));
+        if (index != NOT_FOUND)
+            erase_index(index);
     }
 
     /**
-     * Remove the key-value pair pointed to by the iterator.
-     * This invalidates iterators.
+     * Remove the key-value pair pointed to by the iterator. Iterators to
+     * other pairs remain valid.
      * 
      * @param it an iterator pointing to the pair to erase.
     */
     void erase(Iterator it)
     {
-        if (it != end()) {
-            it.m_bucket->erase(it.m_bucketIterator);
-            update_size_on_removal();
-        }
+        if (it != end())
+            erase_index(it.m_index);
     }
 
 private:
+    using ControlByte = int8_t;
+    // A full slot's control byte holds the top seven bits of its hash, so is never negative.
+    static constexpr ControlByte EMPTY = -128;
+    static constexpr ControlByte DELETED = -2;
+
+    static constexpr std::size_t GROUP_WIDTH = 8;
+    static constexpr std::size_t MIN_CAPACITY = GROUP_WIDTH;
+    static constexpr std::size_t NOT_FOUND = SIZE_MAX;
+
+    static bool is_full(ControlByte control)
+    {
+        return control >= 0;
+    }
+
+    /**
+     * Up to seven-eighths of the slots are used before the table grows, which
+     * guarantees that every probe sequence ends at an empty slot.
+     */
+    static constexpr std::size_t max_load(std::size_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+
+    class BitMask
+    {
+    public:
+        explicit BitMask(uint64_t mask)
+            : m_mask(mask)
+        {}
+
+        explicit operator bool() const
+        {
+            return m_mask != 0;
+        }
+
+        /**
+         * @return the index within the group of the lowest matching control byte.
+        */
+        std::size_t lowest() const
+        {
+            return __builtin_ctzll(m_mask) / 8;
+        }
+
+        void clear_lowest()
+        {
+            m_mask &= m_mask - 1;
+        }
+
+    private:
+        uint64_t m_mask;
+    };
+
+    /**
+     * A group of control bytes matched together with ordinary integer arithmetic,
+     * as the kernel is built without SSE. Each match sets the top bit of every
+     * matching byte.
+     */
+    class Group
+    {
+    public:
+        explicit Group(const ControlByte* control)
+        {
+            memcpy(&m_word, control, sizeof(m_word));
+        }
+
+        /**
+         * May report false positives, but only in a byte following a true match.
+         * Callers compare the keys anyway.
+        */
+        BitMask match(uint8_t tag) const
+        {
+            auto word = m_word ^ (LSBS * tag);
+            return BitMask((word - LSBS) & ~word & MSBS);
+        }
+
+        BitMask match_empty() const
+        {
+            // Only EMPTY has the top bit set and bit one clear.
+            return BitMask(m_word & ~(m_word << 6) & MSBS);
+        }
+
+        BitMask match_empty_or_deleted() const
+        {
+            return BitMask(m_word & MSBS);
+        }
+
+    private:
+        static constexpr uint64_t LSBS = 0x0101010101010101;
+        static constexpr uint64_t MSBS = 0x8080808080808080;
+        uint64_t m_word;
+    };
 
     template<bool IsConst>
     class IteratorBase
     {
         friend class Hashmap;
+        template<bool> friend class IteratorBase;
     public:
         using value_type = std::pair<K, V>;
         using difference_type = std::ptrdiff_t;
@@ -314,9 +435,10 @@ private:
 
         template<bool WasConst, class = std::enable_if_t<IsConst || !WasConst>>
         IteratorBase(const IteratorBase<WasConst>& rhs)
-            : m_bucketIterator(rhs.m_bucketIterator)
-            , m_bucket(rhs.m_bucket)
-            , m_endBucket(rhs.m_endBucket)
+            : m_index(rhs.m_index)
+            , m_control(rhs.m_control)
+            , m_slots(rhs.m_slots)
+            , m_capacity(rhs.m_capacity)
         {
             /**
             * We want to be able to construct a const iterator from a non-const
@@ -328,31 +450,15 @@ private:
         
         IteratorBase& operator++()
         {
-            if (!m_bucket)
+            if (m_index == NOT_FOUND)
                 return *this;
-            
-            /*do {
-                m_bucketIterator++;
-                if (m_bucketIterator == m_bucket->end()) {
-                    m_bucket++;
-                    if (m_bucket == m_endBucket) {
-                        m_bucket = nullptr;
-                        return *this;
-                    }
-                    m_bucketIterator = m_bucket->begin();
-                }
-            } while (m_bucketIterator == m_bucket->end());*/
-
-            ++m_bucketIterator;
-            while (m_bucketIterator == m_bucket->end()) {
-                ++m_bucket;
-                if (m_bucket == m_endBucket) {
-                    m_bucket = nullptr;
-                    return *this;
-                }
-                m_bucketIterator = m_bucket->begin();
-            }
-            
+
+            do {
+                m_index++;
+            } while (m_index < m_capacity && !is_full(m_control[m_index]));
+
+            if (m_index == m_capacity)
+                m_index = NOT_FOUND;
             return *this;
         }
 
@@ -365,20 +471,19 @@ private:
 
         reference operator*() const
         {
-            return *m_bucketIterator;
+            return m_slots[m_index];
         }
 
         pointer operator->() const
         {
-            return &*m_bucketIterator;
+            return &m_slots[m_index];
         }
 
         friend bool operator==(const IteratorBase& lhs, const IteratorBase& rhs)
         {
-            if (lhs.m_bucket == rhs.m_bucket) {
-                return (lhs.m_bucket == nullptr) || (lhs.m_bucketIterator == rhs.m_bucketIterator);
-            }
-            return false;
+            if (lhs.m_index == NOT_FOUND || rhs.m_index == NOT_FOUND)
+                return lhs.m_index == rhs.m_index;
+            return lhs.m_slots + lhs.m_index == rhs.m_slots + rhs.m_index;
         }
 
         friend bool operator!=(const IteratorBase& lhs, const IteratorBase& rhs)
@@ -387,91 +492,163 @@ private:
         }
 
     private:
-
-        IteratorBase(List<value_type>::Iterator bucketIterator, Bucket* bucket, Bucket* endBucket)
-            : m_bucketIterator(bucketIterator)
-            , m_bucket(bucket)
-            , m_endBucket(endBucket)
+        IteratorBase(std::size_t index, const ControlByte* control, value_type* slots, std::size_t capacity)
+            : m_index(index)
+            , m_control(control)
+            , m_slots(slots)
+            , m_capacity(capacity)
         {}
-public:
-        Bucket::Iterator m_bucketIterator;
-        Bucket* m_bucket = nullptr;
-        Bucket* m_endBucket = nullptr;
+
+        std::size_t m_index = NOT_FOUND;
+        const ControlByte* m_control = nullptr;
+        value_type* m_slots = nullptr;
+        std::size_t m_capacity = 0;
     };
-    std::size_t m_bucketCount = 1;
+
+    std::size_t m_capacity = 0;
     std::size_t m_size = 0;
-    Bucket* m_bucketArray = nullptr;
-    static constexpr float MAX_LOAD_FACTOR = 1;
+    std::size_t m_growthLeft = 0;
+    ControlByte* m_control = nullptr;
+    value_type* m_slots = nullptr;
 
-    std::size_t bucket_index(const K& key)
+    static uint8_t tag(uint64_t hash)
     {
-        uint64_t hashedIntegers[2];
-        // This is an open source hash.
-        MurmurHash3_x64_128(&key, sizeof(K), 3, hashedIntegers);
-        return hashedIntegers[0] % m_bucketCount;
+        return hash >> 57;
     }
 
-    Iterator force_insert(const value_type& value)
+    std::size_t group_mask() const
     {
-        update_size_on_insertion();
-        auto bucketIndex = bucket_index(value.first);
-        m_bucketArray[bucketIndex].push_back(value);
-        auto listIt = --m_bucketArray[bucketIndex].end();
-        return Iterator(listIt, m_bucketArray + bucketIndex, m_bucketArray + m_bucketCount);
+        return m_capacity / GROUP_WIDTH - 1;
     }
 
-    Iterator force_insert(value_type&& value)
+    /**
+     * Groups are probed in triangular steps from the group chosen by the low bits of the hash,
+     * which visits every group when there is a power of two of them.
+    */
+    template<typename Q>
+    std::size_t find_index(const Q& key, uint64_t hash) const
     {
-        update_size_on_insertion();
-        auto bucketIndex = bucket_index(value.first);
-        m_bucketArray[bucketIndex].push_back(std::move(value));
-        auto listIt = --m_bucketArray[bucketIndex].end();
-        return Iterator(listIt, m_bucketArray + bucketIndex, m_bucketArray + m_bucketCount);
+        if (!m_capacity)
+            return NOT_FOUND;
+
+        auto group = hash & group_mask();
+        for (std::size_t step = 1;; step++) {
+            Group controls(m_control + group * GROUP_WIDTH);
+            for (auto match = controls.match(tag(hash)); match; match.clear_lowest()) {
+                auto index = group * GROUP_WIDTH + match.lowest();
+                if (m_slots[index].first == key)
+                    return index;
+            }
+            if (controls.match_empty())
+                return NOT_FOUND;
+            group = (group + step) & group_mask();
+        }
     }
 
-    void update_size_on_insertion()
+    std::size_t find_insert_index(uint64_t hash) const
     {
-        m_size++;
-        // If we have a high load factor (avg. bucket size), then increase the number of buckets.
-        if (m_size <= 2 * m_bucketCount)
-            return;
-        
-        /*auto oldBucketCount = m_bucketCount;
-        m_bucketCount *= 2;
-        auto newBuckets = new Bucket[m_bucketCount];
-        // Rehash each element and populate the new buckets.
-        for (std::size_t i = 0; i < oldBucketCount; i++) {
-            for (auto it = m_bucketArray[i].begin(); it != m_bucketArray[i].end(); ++it)
-                newBuckets[bucket_index(it->first)].push_back(*it);
+        auto group = hash & group_mask();
+        for (std::size_t step = 1;; step++) {
+            auto match = Group(m_control + group * GROUP_WIDTH).match_empty_or_deleted();
+            if (match)
+                return group * GROUP_WIDTH + match.lowest();
+            group = (group + step) & group_mask();
         }
-        
-        delete[] m_bucketArray;
-        m_bucketArray = newBuckets;*/
-        
     }
 
-    void update_size_on_removal()
+    std::size_t next_full(std::size_t index) const
+    {
+        for (; index < m_capacity; index++) {
+            if (is_full(m_control[index]))
+                return index;
+        }
+        return NOT_FOUND;
+    }
+
+    template<typename P>
+    std::pair<Iterator, bool> insert_unique(P&& value)
+    {
+        auto hash = H::hash(value.first);
+        auto index = find_index(value.first, hash);
+        if (index != NOT_FOUND)
+            return std::pair(Iterator(index, m_control, m_slots, m_capacity), false);
+
+        if (!m_capacity)
+            rehash(MIN_CAPACITY);
+        index = find_insert_index(hash);
+        // Reusing a deleted slot does not shorten any probe sequence's path to an empty slot.
+        if (!m_growthLeft && m_control[index] == EMPTY) {
+            grow();
+            index = find_insert_index(hash);
+        }
+
+        if (m_control[index] == EMPTY)
+            m_growthLeft--;
+        new (m_slots + index) value_type(std::forward<P>(value));
+        m_control[index] = tag(hash);
+        m_size++;
+        return std::pair(Iterator(index, m_control, m_slots, m_capacity), true);
+    }
+
+    void erase_index(std::size_t index)
     {
+        m_slots[index].~value_type();
         m_size--;
-        // Check if the number of buckets can be shrunk.
-        if (m_size != 0 && m_bucketCount <= 3 * m_size )
-            return;
-        
-        /*auto oldBucketCount = m_bucketCount;
-        m_bucketCount /= 2;
-        if (m_bucketCount <= 0)
-            m_bucketCount = 1;
-        auto newBuckets = new Bucket[m_bucketCount]();
-        for (std::size_t i = 0; i < oldBucketCount; i++) {
-            for (auto it = m_bucketArray[i].begin(); it != m_bucketArray[i].end(); ++it)
-                newBuckets[bucket_index(it->first)].push_back(*it);
+
+        // If the group still has an empty slot, no probe sequence can have passed through it,
+        // so this slot can become empty too. Otherwise it must be marked so probing continues.
+        auto group = index & ~(GROUP_WIDTH - 1);
+        if (Group(m_control + group).match_empty()) {
+            m_control[index] = EMPTY;
+            m_growthLeft++;
+        } else {
+            m_control[index] = DELETED;
         }
-        delete[] m_bucketArray;
-        m_bucketArray = newBuckets;*/
+    }
+
+    void grow()
+    {
+        // If most of the used slots are deleted, clearing them out is enough.
+        if (m_size <= max_load(m_capacity) / 2)
+            rehash(m_capacity);
+        else
+            rehash(m_capacity * 2);
+    }
+
+    void rehash(std::size_t capacity)
+    {
+        auto* oldControl = m_control;
+        auto* oldSlots = m_slots;
+        auto oldCapacity = m_capacity;
+
+        auto* memory = std::launder(new uint8_t[capacity * (sizeof(value_type) + 1)]);
+        m_slots = reinterpret_cast<value_type*>(memory);
+        m_control = reinterpret_cast<ControlByte*>(memory + capacity * sizeof(value_type));
+        m_capacity = capacity;
+        m_growthLeft = max_load(capacity) - m_size;
+        memset(m_control, static_cast<uint8_t>(EMPTY), capacity);
+
+        for (std::size_t index = 0; index < oldCapacity; index++) {
+            if (!is_full(oldControl[index]))
+                continue;
+            auto hash = H::hash(oldSlots[index].first);
+            auto newIndex = find_insert_index(hash);
+            new (m_slots + newIndex) value_type(std::move(oldSlots[index]));
+            m_control[newIndex] = tag(hash);
+            oldSlots[index].~value_type();
+        }
+
+        if (oldSlots)
+            free_table(oldSlots);
+    }
+
+    static void free_table(value_type* slots)
+    {
+        delete[] reinterpret_cast<uint8_t*>(slots);
     }
 
     static_assert(std::forward_iterator<Iterator>);
 };
 
 } // namespace
-#endif
\ No newline at end of file
+#endif
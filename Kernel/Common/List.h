@@ -22,6 +22,7 @@
 #include <iterator>
 #include <memory>
 
+#include "Common/ObjectCache.h"
 #include "Memory/KernelHeap.h"
 
 namespace Common {
@@ -410,6 +411,9 @@ private:
         explicit ListNode(Args&&... args)
             : value(std::forward<Args>(args)...)
         {}
+
+        static void* operator new(std::size_t) { return Common::ObjectCache<ListNode>::instance().allocate(); }
+        static void operator delete(void* ptr) { Common::ObjectCache<ListNode>::instance().free(ptr); }
     };
 
     ListNode* m_head = nullptr;
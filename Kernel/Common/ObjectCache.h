@@ -0,0 +1,81 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef XPOS_COMMON_OBJECTCACHE_H
+#define XPOS_COMMON_OBJECTCACHE_H
+
+#include <cstddef>
+
+#include "Memory/SlabAllocator.h"
+
+namespace Common
+{
+
+/**
+ * The cache that objects of type T are allocated from.
+ *
+ * A class without derived classes opts in by declaring
+ * @code
+ * static void* operator new(std::size_t) { return Common::ObjectCache<T>::instance().allocate(); }
+ * static void operator delete(void* ptr) { Common::ObjectCache<T>::instance().free(ptr); }
+ * @endcode
+ *
+ * @tparam T type of object stored.
+ */
+template <class T>
+class ObjectCache
+{
+public:
+    static ObjectCache& instance()
+    {
+        static ObjectCache instance;
+        return instance;
+    }
+
+    /**
+     * Allocates uninitialised storage for a T.
+     */
+    void* allocate()
+    {
+        return m_cache.allocate();
+    }
+
+    void free(void* object)
+    {
+        m_cache.free(object);
+    }
+
+    void reclaim()
+    {
+        m_cache.reclaim();
+    }
+
+    ObjectCache(const ObjectCache&) = delete;
+    ObjectCache& operator=(const ObjectCache&) = delete;
+
+private:
+    constexpr ObjectCache()
+        : m_cache(sizeof(T), alignof(T))
+    {}
+
+    Memory::Slab::Cache m_cache;
+};
+
+}
+
+#endif
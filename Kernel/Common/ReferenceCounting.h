@@ -62,6 +62,7 @@ namespace Common
         AutomaticReferenceCountable& operator=(AutomaticReferenceCountable&& sharedResource)
         {
             // Using move semantics, we steal the control block from the old shared resource.
+            reset();
             m_controlBlock = sharedResource.m_controlBlock;
             sharedResource.m_controlBlock = nullptr;
             return *this;
@@ -78,7 +79,11 @@ namespace Common
             return m_controlBlock->m_resource;
         }
 
-        ~AutomaticReferenceCountable()
+        /**
+         * Drops this reference early, destroying the resource if it was the last.
+         * Nothing may be dereferenced through this object afterwards.
+         */
+        void reset()
         {
             if (!m_controlBlock)
                 return;
@@ -86,6 +91,12 @@ namespace Common
 
             if (m_controlBlock->m_refCount == 0)
                 delete m_controlBlock;
+            m_controlBlock = nullptr;
+        }
+
+        ~AutomaticReferenceCountable()
+        {
+            reset();
         }
 
     private:
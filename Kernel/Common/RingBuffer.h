@@ -0,0 +1,253 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef XPOS_COMMON_RINGBUFFER_H
+#define XPOS_COMMON_RINGBUFFER_H
+
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Memory/Memory.h"
+
+namespace Common
+{
+
+static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * A counter padded out to a whole cache line, so that the producer's and the
+ * consumer's indices are never on the same line. Padding is used rather than
+ * alignas, as the kernel heap does not provide over-aligned allocation.
+ */
+struct PaddedIndex
+{
+    std::size_t value = 0;
+    uint8_t padding[CACHE_LINE_SIZE - sizeof(std::size_t)];
+};
+
+/**
+ * A lock-free ring for one producer and one consumer, which may be an interrupt
+ * handler and a thread. The head and tail are free-running counters, so all
+ * Capacity slots are usable, and each side only writes its own counter.
+ *
+ * Trivially copyable records can also be moved in bulk with read() and write(),
+ * which copy whole records with at most two memcpys. With T as uint8_t, this is a
+ * byte stream.
+ *
+ * @tparam T the type of record stored.
+ * @tparam Capacity the number of records, which must be a power of two.
+ */
+template<typename T, std::size_t Capacity>
+class SPSCRing
+{
+    static_assert(Capacity && !(Capacity & (Capacity - 1)), "Capacity must be a power of two");
+public:
+    SPSCRing() = default;
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    ~SPSCRing()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (auto index = m_head.value; index != m_tail.value; index++)
+                slot(index)->~T();
+        }
+    }
+
+    /**
+     * Producer only. Returns false if the ring is full.
+     */
+    template<class... Args>
+    bool try_emplace(Args&&... args)
+    {
+        auto tail = m_tail.value;
+        if (tail - __atomic_load_n(&m_head.value, __ATOMIC_ACQUIRE) == Capacity)
+            return false;
+
+        new (slot(tail)) T(std::forward<Args>(args)...);
+        __atomic_store_n(&m_tail.value, tail + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    bool try_push(const T& value)
+    {
+        return try_emplace(value);
+    }
+
+    bool try_push(T&& value)
+    {
+        return try_emplace(std::move(value));
+    }
+
+    /**
+     * Consumer only. Returns false if the ring is empty.
+     */
+    bool try_pop(T& value)
+    {
+        auto head = m_head.value;
+        if (head == __atomic_load_n(&m_tail.value, __ATOMIC_ACQUIRE))
+            return false;
+
+        value = std::move(*slot(head));
+        slot(head)->~T();
+        __atomic_store_n(&m_head.value, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /**
+     * Producer only. Writes as many whole records from the count bytes at buf as fit.
+     *
+     * @return the number of bytes written.
+     */
+    std::size_t write(std::size_t count, const void* buf) requires std::is_trivially_copyable_v<T>
+    {
+        auto tail = m_tail.value;
+        auto records = count / sizeof(T);
+        auto free = space();
+        if (records > free)
+            records = free;
+
+        copy_in(tail, records, buf);
+        __atomic_store_n(&m_tail.value, tail + records, __ATOMIC_RELEASE);
+        return records * sizeof(T);
+    }
+
+    /**
+     * Producer only. Copies records to the free space after offset bytes that are
+     * already staged, without making them visible to the consumer.
+     *
+     * @return the number of bytes staged, which is 0 unless all count bytes fit.
+     */
+    std::size_t stage(std::size_t offset, std::size_t count, const void* buf) requires std::is_trivially_copyable_v<T>
+    {
+        auto skipped = offset / sizeof(T);
+        auto records = count / sizeof(T);
+        if (skipped + records > space())
+            return 0;
+
+        copy_in(m_tail.value + skipped, records, buf);
+        return records * sizeof(T);
+    }
+
+    /**
+     * Producer only. Makes count staged bytes visible to the consumer at once.
+     */
+    void publish(std::size_t count)
+    {
+        __atomic_store_n(&m_tail.value, m_tail.value + count / sizeof(T), __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Consumer only. Reads as many whole records as are available and fit in count bytes.
+     *
+     * @return the number of bytes read.
+     */
+    std::size_t read(std::size_t count, void* buf) requires std::is_trivially_copyable_v<T>
+    {
+        auto records = peek(count, buf) / sizeof(T);
+        __atomic_store_n(&m_head.value, m_head.value + records, __ATOMIC_RELEASE);
+        return records * sizeof(T);
+    }
+
+    /**
+     * Consumer only. Like read(), but leaves the records queued.
+     */
+    std::size_t peek(std::size_t count, void* buf) requires std::is_trivially_copyable_v<T>
+    {
+        auto head = m_head.value;
+        auto records = count / sizeof(T);
+        auto available = __atomic_load_n(&m_tail.value, __ATOMIC_ACQUIRE) - head;
+        if (records > available)
+            records = available;
+
+        auto offset = head & MASK;
+        auto first = records < Capacity - offset ? records : Capacity - offset;
+        memcpy(buf, slot(head), first * sizeof(T));
+        memcpy(static_cast<uint8_t*>(buf) + first * sizeof(T), slot(0), (records - first) * sizeof(T));
+        return records * sizeof(T);
+    }
+
+    /**
+     * Consumer only. Drops up to count queued records without copying them.
+     *
+     * @return the number of records dropped.
+     */
+    std::size_t discard(std::size_t count) requires std::is_trivially_copyable_v<T>
+    {
+        auto head = m_head.value;
+        auto available = __atomic_load_n(&m_tail.value, __ATOMIC_ACQUIRE) - head;
+        if (count > available)
+            count = available;
+
+        __atomic_store_n(&m_head.value, head + count, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    /**
+     * The number of records queued. Exact for the producer and consumer, and a
+     * snapshot for anyone else.
+     */
+    std::size_t size() const
+    {
+        return __atomic_load_n(&m_tail.value, __ATOMIC_ACQUIRE) - __atomic_load_n(&m_head.value, __ATOMIC_ACQUIRE);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    bool full() const
+    {
+        return size() == Capacity;
+    }
+
+    /**
+     * The number of free records. Exact for the producer, and a snapshot for anyone else.
+     */
+    std::size_t space() const
+    {
+        return Capacity - size();
+    }
+
+private:
+    static constexpr std::size_t MASK = Capacity - 1;
+
+    void copy_in(std::size_t index, std::size_t records, const void* buf)
+    {
+        auto offset = index & MASK;
+        auto first = records < Capacity - offset ? records : Capacity - offset;
+        memcpy(slot(index), buf, first * sizeof(T));
+        memcpy(slot(0), static_cast<const uint8_t*>(buf) + first * sizeof(T), (records - first) * sizeof(T));
+    }
+
+    T* slot(std::size_t index)
+    {
+        return std::launder(reinterpret_cast<T*>(m_storage)) + (index & MASK);
+    }
+
+    PaddedIndex m_head;
+    PaddedIndex m_tail;
+    alignas(T) uint8_t m_storage[sizeof(T) * Capacity];
+};
+
+}
+
+#endif
@@ -16,6 +16,9 @@
     xpOS v1.0
 */
 
+#include <new>
+#include <utility>
+
 #include "Common/String.h"
 
 char* strcpy(char* dst, const char* str)
@@ -53,4 +56,90 @@ int strncmp(const char* s1, const char* s2, uint64_t num)
         return 0;
     
     return *(const uint8_t*)s1 - *(const uint8_t*)s2;
-}
\ No newline at end of file
+}
+
+uint64_t strlen(const char* str)
+{
+    const char* end = str;
+    while (*end)
+        end++;
+    return end - str;
+}
+
+namespace Common
+{
+
+String::String(StringView view)
+{
+    m_inline[0] = '\0';
+    append(view);
+}
+
+String::String(const String& other)
+    : String(StringView(other))
+{
+}
+
+String::String(String&& other)
+    : m_length(other.m_length)
+    , m_capacity(other.m_capacity)
+{
+    if (other.is_inline()) {
+        memcpy(m_inline, other.m_inline, m_length + 1);
+    } else {
+        m_heap = other.m_heap;
+        other.m_capacity = 0;
+    }
+    other.m_length = 0;
+    other.m_inline[0] = '\0';
+}
+
+String::~String()
+{
+    if (!is_inline())
+        delete[] m_heap;
+}
+
+void swap(String& a, String& b)
+{
+    // A moved-from String holds no allocation, so it can be constructed over without destroying it.
+    String temporary(std::move(a));
+    new (&a) String(std::move(b));
+    new (&b) String(std::move(temporary));
+}
+
+String& String::append(StringView view)
+{
+    // The view may point into this string, which growing would free.
+    auto* source = view.data();
+    bool aliases = source >= data() && source <= data() + m_length;
+    auto offset = source - data();
+
+    reserve(m_length + view.size());
+    auto* characters = mutable_data();
+    if (aliases)
+        source = characters + offset;
+    memcpy(characters + m_length, source, view.size());
+    m_length += view.size();
+    characters[m_length] = '\0';
+    return *this;
+}
+
+void String::reserve(std::size_t length)
+{
+    auto capacity = is_inline() ? INLINE_CAPACITY : m_capacity;
+    if (length <= capacity)
+        return;
+
+    while (capacity < length)
+        capacity *= 2;
+
+    auto* characters = new char[capacity + 1];
+    memcpy(characters, data(), m_length + 1);
+    if (!is_inline())
+        delete[] m_heap;
+    m_heap = characters;
+    m_capacity = capacity;
+}
+
+}
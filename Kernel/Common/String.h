@@ -26,10 +26,161 @@ char* strcpy(char* dst, const char* str);
 char* strncpy(char* dst, const char* str, uint64_t num);
 int strcmp(const char* s1, const char* s2);
 int strncmp(const char* s1, const char* s2, uint64_t num);
+uint64_t strlen(const char* str);
 
 namespace Common
 {
 
+/**
+ * A non-owning reference to a run of characters, which need not be null terminated.
+ */
+class StringView
+{
+public:
+    constexpr StringView() = default;
+
+    constexpr StringView(const char* str, std::size_t length)
+        : m_data(str)
+        , m_length(length)
+    {}
+
+    StringView(const char* str)
+        : m_data(str)
+        , m_length(strlen(str))
+    {}
+
+    const char* data() const
+    {
+        return m_data;
+    }
+
+    std::size_t size() const
+    {
+        return m_length;
+    }
+
+    bool empty() const
+    {
+        return m_length == 0;
+    }
+
+    char operator[](std::size_t position) const
+    {
+        return m_data[position];
+    }
+
+    friend bool operator==(StringView lhs, StringView rhs)
+    {
+        if (lhs.m_length != rhs.m_length)
+            return false;
+        for (std::size_t i = 0; i < lhs.m_length; i++) {
+            if (lhs.m_data[i] != rhs.m_data[i])
+                return false;
+        }
+        return true;
+    }
+
+private:
+    const char* m_data = nullptr;
+    std::size_t m_length = 0;
+};
+
+/**
+ * An owned, null terminated string. Strings short enough for identifiers such as
+ * device names are stored inline, so creating them does not allocate.
+ */
+class String
+{
+public:
+    String()
+    {
+        m_inline[0] = '\0';
+    }
+
+    String(const char* str)
+        : String(StringView(str))
+    {}
+
+    explicit String(StringView view);
+    String(const String& other);
+    String(String&& other);
+    ~String();
+
+    String& operator=(String other)
+    {
+        swap(*this, other);
+        return *this;
+    }
+
+    friend void swap(String& a, String& b);
+
+    const char* data() const
+    {
+        return is_inline() ? m_inline : m_heap;
+    }
+
+    const char* c_str() const
+    {
+        return data();
+    }
+
+    std::size_t size() const
+    {
+        return m_length;
+    }
+
+    bool empty() const
+    {
+        return m_length == 0;
+    }
+
+    operator StringView() const
+    {
+        return StringView(data(), m_length);
+    }
+
+    String& append(StringView view);
+
+    friend bool operator==(const String& lhs, const String& rhs)
+    {
+        return StringView(lhs) == StringView(rhs);
+    }
+
+    friend bool operator==(const String& lhs, StringView rhs)
+    {
+        return StringView(lhs) == rhs;
+    }
+
+    friend bool operator==(const String& lhs, const char* rhs)
+    {
+        return !strcmp(lhs.data(), rhs);
+    }
+
+private:
+    static constexpr std::size_t INLINE_CAPACITY = 23;
+
+    bool is_inline() const
+    {
+        return m_capacity == 0;
+    }
+
+    char* mutable_data()
+    {
+        return is_inline() ? m_inline : m_heap;
+    }
+
+    void reserve(std::size_t length);
+
+    std::size_t m_length = 0;
+    // Zero while the characters are stored inline.
+    std::size_t m_capacity = 0;
+    union
+    {
+        char* m_heap;
+        char m_inline[INLINE_CAPACITY + 1];
+    };
+};
+
 class HashableString
 {
 public:
@@ -44,7 +195,12 @@ public:
         return !strcmp(lhs.m_str, rhs.m_str);
     }
 
-    const char* string()
+    friend bool operator==(const HashableString& lhs, const char* rhs)
+    {
+        return !strcmp(lhs.m_str, rhs);
+    }
+
+    const char* string() const
     {
         return m_str;
     }
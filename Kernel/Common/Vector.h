@@ -21,6 +21,11 @@
 
 #include <cstdint>
 #include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Memory/Memory.h"
 
 namespace Common
 {
@@ -53,8 +58,8 @@ public:
 
     ~Vector()
     {
-        if (size())
-            delete[] m_start;
+        clear();
+        deallocate(m_start);
     }
 
     /**
@@ -76,15 +81,14 @@ public:
         reserve(count);
 
         for (size_type i = 0; i < count; i++) {
-            new (m_start + count) T(value);
+            new (m_finish) T(value);
+            m_finish++;
         }
     }
 
     Vector(const Vector& vector)
     {
-        reserve(vector.capacity());
-        for (auto& item : vector)
-            push_back(item);
+        append(vector.data(), vector.size());
     }
 
     /**
@@ -121,19 +125,11 @@ public:
     {
         if (new_cap <= capacity())
             return;
-        
-
-        auto* newCharAlloc = std::launder(new uint8_t[sizeof(value_type) * new_cap]);
-        auto* newAlloc = reinterpret_cast<pointer>(newCharAlloc);
 
+        auto* newAlloc = allocate(new_cap);
         auto sz = size();
-
-        if (sz) {
-            for (std::size_t i = 0; i < sz; i++) {
-                newAlloc[i] = m_start[i];
-            }
-            delete[] m_start;
-        }
+        relocate(newAlloc, m_start, sz);
+        deallocate(m_start);
         
         m_start = newAlloc;
         m_finish = m_start + sz;
@@ -153,6 +149,11 @@ public:
         return static_cast<size_type>(m_finish - m_start);
     }
 
+    bool empty() const
+    {
+        return m_finish == m_start;
+    }
+
     reference operator[](size_type position)
     {
         return *(m_start + position);
@@ -205,12 +206,12 @@ public:
 
     reference back()
     {
-        return *m_finish;
+        return *(m_finish - 1);
     }
 
     const_reference back() const
     {
-        return *m_finish;
+        return *(m_finish - 1);
     }
 
     T* data()
@@ -223,36 +224,83 @@ public:
         return m_start;
     }
 
+    /**
+     * Destroys the elements, but keeps the allocation for reuse.
+     */
     void clear()
     {
-        auto init_size = size();
-        for (std::size_t i = 0; i < init_size; i++) {
-            pop_back();
-        }
+        destroy(m_start, m_finish);
+        m_finish = m_start;
     }
 
     void push_back(const T& value)
     {
-        if (size() >= capacity())
-            reserve(capacity() * 2 + 1);
-
-        new (m_finish) T(value);
-        m_finish++;
+        emplace_back(value);
     }
 
     void push_back(T&& value)
     {
-        if (size() >= capacity())
-            reserve(capacity() * 2 + 1);
+        emplace_back(std::move(value));
+    }
+
+    template<class... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if (m_finish == m_capacityEnd)
+            return grow_and_emplace_back(std::forward<Args>(args)...);
 
-        new (m_finish) T(std::move(value));
-        m_finish++;
+        new (m_finish) T(std::forward<Args>(args)...);
+        return *m_finish++;
     }
 
     void pop_back()
     {
-        (&back())->~T();
         m_finish--;
+        m_finish->~T();
+    }
+
+    /**
+     * Copies count elements onto the end of the vector, growing it at most once.
+     * The elements must not belong to this vector.
+     */
+    void append(const T* values, size_type count)
+    {
+        if (size() + count > capacity())
+            grow(size() + count);
+
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (count)
+                memcpy(m_finish, values, count * sizeof(T));
+        } else {
+            for (size_type i = 0; i < count; i++)
+                new (m_finish + i) T(values[i]);
+        }
+        m_finish += count;
+    }
+
+    /**
+     * Replaces the contents of the vector with a copy of count elements.
+     */
+    void assign(const T* values, size_type count)
+    {
+        clear();
+        append(values, count);
+    }
+
+    /**
+     * Changes the number of elements, value-initialising any new ones.
+     */
+    void resize(size_type count)
+    {
+        if (count > capacity())
+            grow(count);
+
+        while (size() > count)
+            pop_back();
+        while (size() < count) {
+            new (m_finish) T();
+            m_finish++;
+        }
     }
 
 private:
@@ -260,6 +308,78 @@ private:
     pointer m_finish = nullptr;
     pointer m_capacityEnd = nullptr;
 
+    static constexpr size_type MIN_CAPACITY = 4;
+
+    /**
+     * Grows geometrically, so a run of insertions is amortised constant time.
+     */
+    void grow(size_type minimum)
+    {
+        auto newCapacity = capacity() * 2;
+        if (newCapacity < MIN_CAPACITY)
+            newCapacity = MIN_CAPACITY;
+        if (newCapacity < minimum)
+            newCapacity = minimum;
+        reserve(newCapacity);
+    }
+
+    /**
+     * The arguments may refer to elements of this vector, so the new element is
+     * constructed before the old ones are moved out from under them.
+     */
+    template<class... Args>
+    reference grow_and_emplace_back(Args&&... args)
+    {
+        auto sz = size();
+        auto newCapacity = capacity() * 2;
+        if (newCapacity < MIN_CAPACITY)
+            newCapacity = MIN_CAPACITY;
+
+        auto* newAlloc = allocate(newCapacity);
+        new (newAlloc + sz) T(std::forward<Args>(args)...);
+        relocate(newAlloc, m_start, sz);
+        deallocate(m_start);
+
+        m_start = newAlloc;
+        m_finish = m_start + sz + 1;
+        m_capacityEnd = m_start + newCapacity;
+        return *(m_finish - 1);
+    }
+
+    static pointer allocate(size_type count)
+    {
+        return reinterpret_cast<pointer>(std::launder(new uint8_t[sizeof(value_type) * count]));
+    }
+
+    static void deallocate(pointer allocation)
+    {
+        delete[] reinterpret_cast<uint8_t*>(allocation);
+    }
+
+    static void destroy(pointer first, pointer last)
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (; first != last; ++first)
+                first->~T();
+        }
+    }
+
+    /**
+     * Moves count elements into uninitialised storage, destroying the originals.
+     */
+    static void relocate(pointer destination, pointer source, size_type count)
+    {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (count)
+                memcpy(destination, source, count * sizeof(T));
+        } else {
+            for (size_type i = 0; i < count; i++) {
+                new (destination + i) T(std::move(source[i]));
+                source[i].~T();
+            }
+        }
+    }
+
     template<bool IsConst>
     class IteratorBase
     {
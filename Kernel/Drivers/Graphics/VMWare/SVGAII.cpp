@@ -52,7 +52,8 @@ bool Device::open(void* with, int flags, void*& deviceSpecific)
     KERNEL_ASSERT(fbAddress.get_raw() == fbAddressAlignedDown);
 
     // We acquire a virtual memory region sufficiently sized for the framebuffer,
-    // and map it in.
+    // and map it in. The framebuffer is device memory, so the physical allocator
+    // does not own it and tearing down the address space leaves it alone.
     auto fbSize = instance().get_framebuffer_size();
     request->width = instance().get_width();
     request->height = instance().get_height();
@@ -18,12 +18,13 @@
 
 #include "Arch/Interrupts/Interrupts.h"
 #include "Arch/IO/IO.h"
-#include "Common/CircularBuffer.h"
+#include "Common/RingBuffer.h"
+#include "Common/Vector.h"
 #include "Drivers/HID/Keyboard.h"
 
 namespace Devices::HID::Keyboard
 {
-    using ScancodeBuffer = Common::FixedCircularBuffer<30>;
+    using ScancodeBuffer = Common::SPSCRing<xpOS::API::HID::KeyboardEvent, 32>;
     using namespace xpOS::API::HID;
     
     namespace {
@@ -32,22 +33,22 @@ namespace Devices::HID::Keyboard
         Pipes::EventListenerList eventListenerList;
         Mutex bufferListLock;
         Mutex eventListenerLock;
-        Spinlock scancodeQueueLock;
-        Common::List<uint8_t> queuedMessages;
-        Common::List<KeyboardEvent> keyEvents;
+        // Filled by the interrupt handler and drained by the receive thread.
+        Common::SPSCRing<uint8_t, 64> queuedMessages;
         uint64_t threadId = 0;
+        bool threadWaiting = false;
         Pipes::DeviceOperations deviceOperations;
     }
 
-    void convert_keys(Common::List<uint8_t>& scancodes, Common::List<KeyboardEvent>& eventsOut)
+    void convert_keys(Common::SPSCRing<uint8_t, 64>& scancodes, Common::Vector<KeyboardEvent>& eventsOut)
     {
         // Some keys have a two byte extended scancode, so we track this property.
         static bool extended = false;
-        for (auto it = queuedMessages.begin(); it != queuedMessages.end(); it++) {
+        uint8_t scancode;
+        while (scancodes.try_pop(scancode)) {
             KeyboardEvent k;
             k.key = 0;
-            auto scancode = *it;
-            if (*it == SCANCODE_S1_EXTID) {
+            if (scancode == SCANCODE_S1_EXTID) {
                 extended = true;
                 continue;
             }
@@ -82,22 +83,25 @@ namespace Devices::HID::Keyboard
 
     void receive_thread(void*)
     {
-        scancodeQueueLock.acquire();
+        Common::Vector<KeyboardEvent> keyEvents;
         while (true) {
-            if (queuedMessages.size() > 0) {
-                convert_keys(queuedMessages, keyEvents);
-                queuedMessages.clear();
-                for (auto message : keyEvents) {
+            convert_keys(queuedMessages, keyEvents);
+            if (!keyEvents.empty()) {
+                {
+                    LockAcquirer l(bufferListLock);
                     for (auto buffer : buffers)
-                        buffer->write(sizeof(KeyboardEvent), &message);
+                        buffer->write(keyEvents.size() * sizeof(KeyboardEvent), keyEvents.data());
                 }
                 keyEvents.clear();
                 eventListenerList.notify(Pipes::EventTypes::READABLE);
             }
+            // The interrupt handler only wakes us while we wait for scancodes, so it
+            // cannot wake us while we are blocked on one of the mutexes above.
+            __atomic_store_n(&threadWaiting, true, __ATOMIC_SEQ_CST);
             Task::Manager::instance().about_to_block();
-            scancodeQueueLock.release();
-            Task::Manager::instance().block();
-            scancodeQueueLock.acquire();
+            if (queuedMessages.empty())
+                Task::Manager::instance().block();
+            __atomic_store_n(&threadWaiting, false, __ATOMIC_SEQ_CST);
         }
     }
 
@@ -107,10 +111,10 @@ namespace Devices::HID::Keyboard
         // in a queue to be processed.
         auto scancode = IO::in_8(SCANCODE_PORT);
         if (threadId && Task::Manager::instance().is_executing()) {
-            scancodeQueueLock.acquire();
-            queuedMessages.push_back(scancode);
-            scancodeQueueLock.release();
-            Task::Manager::instance().unblock(threadId);
+            // If the queue is full, the scancode is dropped.
+            queuedMessages.try_push(scancode);
+            if (__atomic_load_n(&threadWaiting, __ATOMIC_SEQ_CST))
+                Task::Manager::instance().unblock(threadId);
         }
     }
 
@@ -163,9 +167,10 @@ namespace Devices::HID::Keyboard
         Pipes::EventTypeMask mask = 0;
         {
             LockAcquirer l(bufferListLock);
-            if (!scancodeBuffer->is_queue_empty())
+            if (!scancodeBuffer->empty())
                 mask |= Pipes::EventTypes::READABLE;
         }
+        current = mask;
 
         LockAcquirer l(eventListenerLock);
         return eventListenerList.add(listener, raise_event);
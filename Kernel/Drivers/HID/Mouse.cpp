@@ -19,13 +19,13 @@
 #include "API/HID.h"
 #include "Arch/Interrupts/Interrupts.h"
 #include "Arch/IO/IO.h"
-#include "Common/CircularBuffer.h"
 #include "Common/List.h"
+#include "Common/RingBuffer.h"
 #include "Drivers/HID/Mouse.h"
 
 namespace Devices::HID::Mouse
 {
-    using MouseBuffer = Common::FixedCircularBuffer<30>;
+    using MouseBuffer = Common::SPSCRing<xpOS::API::HID::MouseEvent, 32>;
     using namespace xpOS;
 
     namespace {
@@ -33,9 +33,10 @@ namespace Devices::HID::Mouse
         Pipes::EventListenerList eventListenerList;
         Mutex bufferListLock;
         Mutex eventListenerLock;
-        Spinlock mouseQueueLock;
-        Common::List<API::HID::MouseEvent> queuedMessages;
+        // Filled by the interrupt handler and drained by the receive thread.
+        Common::SPSCRing<API::HID::MouseEvent, 64> queuedMessages;
         uint64_t threadId = 0;
+        bool threadWaiting = false;
         Pipes::DeviceOperations deviceOperations;
         uint8_t buffer[3];
         int bufferPointer = 0;
@@ -43,20 +44,24 @@ namespace Devices::HID::Mouse
 
     void receive_thread(void*)
     {
-        mouseQueueLock.acquire();
+        API::HID::MouseEvent events[64];
         while (true) {
-            if (queuedMessages.size() > 0) {
-                for (auto message : queuedMessages) {
+            auto count = queuedMessages.read(sizeof(events), events);
+            if (count) {
+                {
+                    LockAcquirer l(bufferListLock);
                     for (auto buffer : buffers)
-                        buffer->write(sizeof(API::HID::MouseEvent), &message);
+                        buffer->write(count, events);
                 }
-                queuedMessages.clear();
                 eventListenerList.notify(Pipes::EventTypes::READABLE);
             }
+            // The interrupt handler only wakes us while we wait for events, so it
+            // cannot wake us while we are blocked on one of the mutexes above.
+            __atomic_store_n(&threadWaiting, true, __ATOMIC_SEQ_CST);
             Task::Manager::instance().about_to_block();
-            mouseQueueLock.release();
-            Task::Manager::instance().block();
-            mouseQueueLock.acquire();
+            if (queuedMessages.empty())
+                Task::Manager::instance().block();
+            __atomic_store_n(&threadWaiting, false, __ATOMIC_SEQ_CST);
         }
     }
 
@@ -86,10 +91,10 @@ namespace Devices::HID::Mouse
                 mevent.dy = -mevent.dy;
             }
             if (threadId && Task::Manager::instance().is_executing()) {
-                mouseQueueLock.acquire();
-                queuedMessages.push_back(mevent);
-                mouseQueueLock.release();
-                Task::Manager::instance().unblock(threadId);
+                // If the queue is full, the event is dropped.
+                queuedMessages.try_push(mevent);
+                if (__atomic_load_n(&threadWaiting, __ATOMIC_SEQ_CST))
+                    Task::Manager::instance().unblock(threadId);
             }
         }
 
@@ -155,9 +160,10 @@ namespace Devices::HID::Mouse
         Pipes::EventTypeMask mask = 0;
         {
             LockAcquirer l(bufferListLock);
-            if (!mouseBuffer->is_queue_empty())
+            if (!mouseBuffer->empty())
                 mask |= Pipes::EventTypes::READABLE;
         }
+        current = mask;
 
         LockAcquirer l(eventListenerLock);
         return eventListenerList.add(listener, raise_event);
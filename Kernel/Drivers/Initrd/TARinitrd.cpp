@@ -126,6 +126,12 @@ uint64_t TarReader::vfsdriver_fileinfo(const ConcreteObject& vnode)
     return header->get_size();
 }
 
+const void* TarReader::vfsdriver_resident(const ConcreteObject& vnode)
+{
+    // The whole archive stays mapped, and each file's contents follow its header.
+    return reinterpret_cast<uint8_t*>(vnode.fs) + TAR_ALIGN;
+}
+
 ConcreteObject* TarReader::prepare_concrete_object(TarDirectoryEntry entry)
 {
     auto* concreteObject = VirtualFilesystem::instance().create_concrete_object(&drops);
@@ -94,10 +94,12 @@ public:
     static uint64_t vfsdriver_read(ConcreteObject&, uint64_t, uint64_t, char*);
     static ConcreteObject* vfsdriver_finddir(const ConcreteObject&, char* name);
     static uint64_t vfsdriver_fileinfo(const ConcreteObject&);
+    static const void* vfsdriver_resident(const ConcreteObject&);
     static constexpr DriverOperations drops = {
         .read = vfsdriver_read,
         .finddir = vfsdriver_finddir,
-        .fileinfo = vfsdriver_fileinfo
+        .fileinfo = vfsdriver_fileinfo,
+        .resident = vfsdriver_resident
     };
 
     static TarReader& instance()
@@ -153,21 +153,20 @@ void Device::connect_to_network_server()
 
 void Device::receive_thread(Device* device)
 {
-    device->m_threadLock.acquire();
-
+    NetworkData message;
     while (true) {
-        if (device->m_queuedMessages.size() > 0) {
-            for (auto& message: device->m_queuedMessages) {
-                //driver->m_conn->send_message(message);
-                if (device->m_server.has_value())
-                    (*device->m_server)->receive_from_driver(std::move(message));
-            }
-            device->m_queuedMessages.clear();
+        while (device->m_queuedMessages.try_pop(message)) {
+            //driver->m_conn->send_message(message);
+            if (device->m_server.has_value())
+                (*device->m_server)->receive_from_driver(std::move(message));
         }
+        // The interrupt handler only wakes us while we wait for frames, so it
+        // cannot wake us while the server has us blocked on a mutex.
+        __atomic_store_n(&device->m_threadWaiting, true, __ATOMIC_SEQ_CST);
         Task::Manager::instance().about_to_block();
-        device->m_threadLock.release();
-        Task::Manager::instance().block();
-        device->m_threadLock.acquire();
+        if (device->m_queuedMessages.empty())
+            Task::Manager::instance().block();
+        __atomic_store_n(&device->m_threadWaiting, false, __ATOMIC_SEQ_CST);
     }
 }
 
@@ -190,14 +189,15 @@ void Device::receive_data()
             uint8_t* recvBuf = static_cast<uint8_t*>(Memory::VirtualAddress(Memory::PhysicalAddress(physBuf)).get());
 
             if (m_server.has_value()) {
-                Common::Vector<uint8_t> data;
-                for (std::size_t i = 0; i < size; i++) {
-                    data.push_back(recvBuf[i]);
+                // Frames go in buffers from the pool, so the interrupt handler does not touch
+                // the kernel heap. If the pool or the queue is full, the frame is dropped.
+                NetworkData frame(Networking::PacketBuffer::try_allocate(0));
+                if (frame && size <= frame->tailroom()) {
+                    memcpy(frame->put(size), recvBuf, size);
+                    m_queuedMessages.try_push(std::move(frame));
                 }
-                m_threadLock.acquire();
-                m_queuedMessages.push_back(std::move(data));
-                m_threadLock.release();
-                Task::Manager::instance().unblock(m_threadId);
+                if (__atomic_load_n(&m_threadWaiting, __ATOMIC_SEQ_CST))
+                    Task::Manager::instance().unblock(m_threadId);
                 //m_conn->send_message(m);
             }
             /*auto eventMessage = Events::EventMessage();
@@ -23,14 +23,14 @@
 
 #include <API/Network.h>
 #include <Arch/IO/PCI.h>
-#include <Common/Vector.h>
+#include <Common/RingBuffer.h>
 #include <Networking/NetworkServer.h>
 #include <Tasks/Task.h>
 
 namespace Drivers::Network::PCNet
 {
 
-using NetworkData = Common::Vector<uint8_t>;
+using NetworkData = Networking::PacketHandle;
 
 static constexpr int AMDPCNET_VENDOR_ID = 0x1022;
 static constexpr int AMDPCNET_DEVICE_ID = 0x2000;
@@ -205,13 +205,15 @@ private:
     
     static constexpr int TX_RING_BUF_SIZE = BUF_SIZE * TX_BUF_COUNT + 15;
     static constexpr int RX_RING_BUF_SIZE = BUF_SIZE * RX_BUF_COUNT + 15;
+    static constexpr int RECEIVE_QUEUE_SIZE = 64;
 
     uint16_t m_basePort;
 
     InitialisationBlock m_initBlock;
     PCI::BusDevice* m_pciDevice;
 
-    Common::Vector<NetworkData> m_queuedMessages;
+    // Filled by the interrupt handler and drained by the receive thread.
+    Common::SPSCRing<NetworkData, RECEIVE_QUEUE_SIZE> m_queuedMessages;
 
     int m_curTxBufDescriptor = 0;
     int m_curRxBufDescriptor = 0;
@@ -236,7 +238,7 @@ private:
     void receive_data();
 
     Task::TaskID m_threadId;
-    Spinlock m_threadLock;
+    bool m_threadWaiting = false;
     static void receive_thread(Device* device);
     
     uint16_t read_offset_reg(uint16_t offset) const
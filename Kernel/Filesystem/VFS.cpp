@@ -17,6 +17,8 @@
 */
 
 #include "Filesystem/VFS.h"
+#include "Memory/AddressSpace.h"
+#include "Tasks/TaskManager.h"
 
 namespace Filesystem
 {
@@ -29,7 +31,11 @@ namespace Filesystem
             .close = close,
             .read = read,
             .write = write,
-            .info = info
+            .info = info,
+            .mmap = mmap,
+            .readv = readv,
+            .writev = writev,
+            .resident = resident
         };
         Pipes::register_device("vfs", &m_deviceOperations);
     }
@@ -58,6 +64,32 @@ namespace Filesystem
         return node->concreteObject->operations->write(*node->concreteObject, offset, count, static_cast<const char*>(buf));
     }
 
+    std::size_t VirtualFilesystem::readv(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific)
+    {
+        auto* object = static_cast<Node*>(deviceSpecific)->concreteObject;
+        std::size_t readCount = 0;
+        for (std::size_t i = 0; i < vectorCount; i++) {
+            auto count = object->operations->read(*object, offset + readCount, vectors[i].length, static_cast<char*>(vectors[i].base));
+            readCount += count;
+            if (count < vectors[i].length)
+                break;
+        }
+        return readCount;
+    }
+
+    std::size_t VirtualFilesystem::writev(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific)
+    {
+        auto* object = static_cast<Node*>(deviceSpecific)->concreteObject;
+        std::size_t writeCount = 0;
+        for (std::size_t i = 0; i < vectorCount; i++) {
+            auto count = object->operations->write(*object, offset + writeCount, vectors[i].length, static_cast<const char*>(vectors[i].base));
+            writeCount += count;
+            if (count < vectors[i].length)
+                break;
+        }
+        return writeCount;
+    }
+
     xpOS::API::Pipes::PipeInfo VirtualFilesystem::info(void*& deviceSpecific)
     {
         auto* node = static_cast<Node*>(deviceSpecific);
@@ -71,6 +103,79 @@ namespace Filesystem
         return reinterpret_cast<Node*>(pipe.device_specific())->concreteObject->operations->fileinfo(*reinterpret_cast<Node*>(pipe.device_specific())->concreteObject);
     }
 
+    const void* VirtualFilesystem::resident_data(Pipes::Pipe& pipe)
+    {
+        auto* node = reinterpret_cast<Node*>(pipe.device_specific());
+        auto* operations = node->concreteObject->operations;
+        return operations->resident ? operations->resident(*node->concreteObject) : nullptr;
+    }
+
+    void* VirtualFilesystem::mmap(std::size_t offset, std::size_t count, int flags, void*& deviceSpecific)
+    {
+        auto* node = static_cast<Node*>(deviceSpecific);
+        auto* object = node->concreteObject;
+        if (!object->operations->resident)
+            return nullptr;
+
+        auto fileLength = object->operations->fileinfo(*object);
+        if (offset >= fileLength || count == 0)
+            return nullptr;
+        if (count > fileLength - offset)
+            count = fileLength - offset;
+
+        // Pages wholly inside the mapped range are shared with the initrd. Files need not
+        // be page aligned in memory, so the pages at either end can hold neighbouring
+        // headers and files, and only the range's own bytes are copied out of them.
+        auto data = reinterpret_cast<uint64_t>(object->operations->resident(*object)) + offset;
+        auto firstPage = BYTE_ALIGN_DOWN(data, Memory::PAGE_4KiB);
+        auto lastPage = BYTE_ALIGN_UP(data + count, Memory::PAGE_4KiB);
+
+        auto& manager = Memory::Manager::instance();
+        auto& vas = *Task::Manager::instance().get_current_task()->tlTable;
+        auto region = vas.acquire_available_region(lastPage - firstPage);
+        auto regionStart = reinterpret_cast<uint64_t>(region.start);
+
+        for (auto page = firstPage; page < lastPage; page += Memory::PAGE_4KiB) {
+            Memory::PhysicalAddress physicalAddress;
+            if (page >= data && page + Memory::PAGE_4KiB <= data + count) {
+                physicalAddress = manager.get_physical_address(page);
+                manager.reference_physical_block(physicalAddress);
+            } else {
+                physicalAddress = manager.alloc_physical_block();
+                auto* copy = static_cast<uint8_t*>(Memory::VirtualAddress(physicalAddress).get());
+                auto start = page > data ? page : data;
+                auto end = page + Memory::PAGE_4KiB < data + count ? page + Memory::PAGE_4KiB : data + count;
+                memset(copy, 0, Memory::PAGE_4KiB);
+                memcpy(copy + (start - page), reinterpret_cast<const void*>(start), end - start);
+            }
+            Memory::VirtualMemoryMapRequest request = {
+                .physicalAddress = physicalAddress,
+                .virtualAddress = regionStart + (page - firstPage),
+                .allowUserAccess = true,
+                .copyOnWrite = static_cast<bool>(flags & xpOS::API::Pipes::MapFlags::PRIVATE)
+            };
+            manager.request_virtual_map(request, vas);
+        }
+
+        return reinterpret_cast<void*>(regionStart + (data - firstPage));
+    }
+
+    const void* VirtualFilesystem::resident(std::size_t offset, std::size_t& count, void*& deviceSpecific)
+    {
+        auto* object = static_cast<Node*>(deviceSpecific)->concreteObject;
+        if (!object->operations->resident)
+            return nullptr;
+
+        auto fileLength = object->operations->fileinfo(*object);
+        if (offset >= fileLength) {
+            count = 0;
+            return nullptr;
+        }
+        if (count > fileLength - offset)
+            count = fileLength - offset;
+        return static_cast<const uint8_t*>(object->operations->resident(*object)) + offset;
+    }
+
     bool VirtualFilesystem::open(void* with, int flags, void*& deviceSpecific)
     {
         auto path = static_cast<const char*>(with);
@@ -33,6 +33,7 @@ typedef std::size_t (*vfsdriver_read_callback)(ConcreteObject&, std::size_t, std
 typedef std::size_t (*vfsdriver_write_callback)(ConcreteObject&, std::size_t, std::size_t, const char*);
 typedef ConcreteObject* (*vfsdriver_finddir_callback)(const ConcreteObject&, char* name);
 typedef std::size_t (*vfsdriver_fileinfo_callback)(const ConcreteObject&);
+typedef const void* (*vfsdriver_resident_callback)(const ConcreteObject&);
 
 static constexpr int MAX_PATH_SIZE = 256;
 static constexpr char PATH_SEPERATOR = '/';
@@ -48,6 +49,9 @@ struct DriverOperations
     vfsdriver_write_callback write;
     vfsdriver_finddir_callback finddir;
     vfsdriver_fileinfo_callback fileinfo;
+    // Returns the file's contents if the driver keeps them in memory, so they can be
+    // mapped rather than copied. Optional.
+    vfsdriver_resident_callback resident;
 };
 
 /**
@@ -134,6 +138,10 @@ public:
     void unregister_filesystem(int mountNum);
 
     std::size_t filelen(Pipes::Pipe& pipe);
+    /**
+     * Returns the contents of a file opened by the kernel, if they are resident in memory.
+     */
+    const void* resident_data(Pipes::Pipe& pipe);
     ConcreteObject* create_concrete_object(const DriverOperations* operations)
     {
         return new ConcreteObject(operations);
@@ -160,7 +168,11 @@ private:
     static void close(void*& deviceSpecific);
     static std::size_t read(std::size_t offset, std::size_t count, void* buf, void*& deviceSpecific);
     static std::size_t write(std::size_t offset, std::size_t count, const void* buf, void*& deviceSpecific);
+    static std::size_t readv(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific);
+    static std::size_t writev(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific);
     static xpOS::API::Pipes::PipeInfo info(void*& deviceSpecific);
+    static void* mmap(std::size_t offset, std::size_t count, int flags, void*& deviceSpecific);
+    static const void* resident(std::size_t offset, std::size_t& count, void*& deviceSpecific);
 
 public:
     /**
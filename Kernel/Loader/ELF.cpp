@@ -79,11 +79,15 @@ namespace Loader
 
     void prepare_elf(const char* path, Task::Task* task)
     {
-        // Load the ELF file into memory.
+        // Read the ELF file in place if its contents are resident, otherwise load it into memory.
         Pipes::Pipe pipe("vfs", const_cast<void*>(reinterpret_cast<const void*>(path)), 0);
-        auto fileInfo = pipe.info();
-        auto elfFile = reinterpret_cast<Elf64_Ehdr*>(kmalloc(fileInfo.size, 0));
-        pipe.read(fileInfo.size, elfFile);
+        auto elfFile = const_cast<Elf64_Ehdr*>(static_cast<const Elf64_Ehdr*>(Filesystem::VirtualFilesystem::instance().resident_data(pipe)));
+        bool ownsCopy = !elfFile;
+        if (ownsCopy) {
+            auto fileInfo = pipe.info();
+            elfFile = reinterpret_cast<Elf64_Ehdr*>(kmalloc(fileInfo.size, 0));
+            pipe.read(fileInfo.size, elfFile);
+        }
         
         if (!check_elf_header_ident(elfFile) || !check_elf_header_support(elfFile))
             return;
@@ -131,6 +135,7 @@ namespace Loader
             }
         }
         task->entryPoint = (void*)(elfFile->e_entry);
-        kfree(elfFile);
+        if (ownsCopy)
+            kfree(elfFile);
     }
 }
@@ -22,6 +22,27 @@
 namespace Memory
 {
 
+RegionableVirtualAddressSpace::RegionableVirtualAddressSpace(RegionableVirtualAddressSpace&& other)
+    : VirtualAddressSpace(other)
+    , m_sortedRegions(std::move(other.m_sortedRegions))
+    , m_owned(other.m_owned)
+{
+    other.m_owned = false;
+}
+
+RegionableVirtualAddressSpace::~RegionableVirtualAddressSpace()
+{
+    if (m_owned)
+        Manager::instance().destroy_virtual_address_space(*this);
+}
+
+RegionableVirtualAddressSpace RegionableVirtualAddressSpace::create()
+{
+    RegionableVirtualAddressSpace addressSpace(Manager::instance().create_virtual_address_space());
+    addressSpace.m_owned = true;
+    return addressSpace;
+}
+
 void RegionableVirtualAddressSpace::insert_region(MappedRegion region)
 {
     auto it = m_sortedRegions.begin();
@@ -42,21 +63,37 @@ MappedRegion RegionableVirtualAddressSpace::extract_region(void* start)
     return MappedRegion();
 }
 
-MappedRegion RegionableVirtualAddressSpace::acquire_available_region(int64_t size)
+bool RegionableVirtualAddressSpace::resize_region(void* start, std::size_t length)
+{
+    auto end = reinterpret_cast<uint8_t*>(start) + BYTE_ALIGN_UP(length, PAGE_4KiB);
+    for (auto it = m_sortedRegions.begin(); it != m_sortedRegions.end(); ++it) {
+        if (it->start != start)
+            continue;
+        auto next = it;
+        if (++next != m_sortedRegions.end() && end > next->start)
+            return false;
+        it->end = end;
+        return true;
+    }
+    return false;
+}
+
+MappedRegion RegionableVirtualAddressSpace::acquire_available_region(int64_t size, uint64_t alignment)
 {
     size = BYTE_ALIGN_UP(size, PAGE_4KiB);
-    void* regionBegin = reinterpret_cast<void*>(PAGE_4KiB);
+    uint64_t regionBegin = BYTE_ALIGN_UP(static_cast<uint64_t>(PAGE_4KiB), alignment);
     for (auto it = m_sortedRegions.begin(); it != m_sortedRegions.end();) {
         auto currentIt = it++;
+        auto gapBegin = BYTE_ALIGN_UP(reinterpret_cast<uint64_t>(currentIt->end), alignment);
         if (it == m_sortedRegions.end()) {
-            regionBegin = currentIt->end;
+            regionBegin = gapBegin;
             break;
         }
-        if (size <= reinterpret_cast<uint8_t*>(it->start) - reinterpret_cast<uint8_t*>(currentIt->end))
-            regionBegin = currentIt->end;
+        if (gapBegin + size <= reinterpret_cast<uint64_t>(it->start))
+            regionBegin = gapBegin;
     }
 
-    MappedRegion region(reinterpret_cast<void*>(regionBegin), reinterpret_cast<uint8_t*>(regionBegin) + size);
+    MappedRegion region(reinterpret_cast<void*>(regionBegin), reinterpret_cast<void*>(regionBegin + size));
     insert_region(region);
     
     return region;
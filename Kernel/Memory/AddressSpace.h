@@ -33,11 +33,22 @@ public:
         : RegionableVirtualAddressSpace(VirtualAddressSpace(topLevelTable)) {}
     RegionableVirtualAddressSpace(VirtualAddressSpace addressSpace)
         : VirtualAddressSpace(addressSpace) {}
+    RegionableVirtualAddressSpace(const RegionableVirtualAddressSpace&) = delete;
+    RegionableVirtualAddressSpace(RegionableVirtualAddressSpace&& other);
+    ~RegionableVirtualAddressSpace();
 
     /**
-     * Finds a free space large enough and creates a new region there.
+     * Creates a new address space, which is destroyed along with the object that
+     * ends up holding it. Address spaces wrapped from an existing one, such as the
+     * main address space kernel processes share, are never destroyed.
      */
-    MappedRegion acquire_available_region(int64_t size);
+    static RegionableVirtualAddressSpace create();
+
+    /**
+     * Finds a free space large enough and creates a new region there, starting
+     * at a multiple of the alignment.
+     */
+    MappedRegion acquire_available_region(int64_t size, uint64_t alignment = PAGE_4KiB);
     /**
      * Insert a new memory region that is disjoint from all other regions in
      * the address space.
@@ -47,9 +58,15 @@ public:
      * Removes a region starting at the specified address.
      */
     MappedRegion extract_region(void* start);
+    /**
+     * Moves the end of the region starting at the specified address, failing if
+     * it would overlap the next region.
+     */
+    bool resize_region(void* start, std::size_t length);
 
 private:
     Common::List<MappedRegion> m_sortedRegions;
+    bool m_owned = false;
 };
 
 }
@@ -16,257 +16,243 @@
     xpOS v1.0
 */
 
-#include "Memory/dlmalloc.h"
 #include "Memory/KernelHeap.h"
 #include "Memory/MemoryManager.h"
 #include "panic.h"
-#include "x86_64.h"
 
 namespace Memory::Heap {
-    /**
-     * For the kernel heap manager, we use a binary search tree organising free sections in the current heap and ordering them by size.
-     * This means that sufficient size spaces can be quickly found and allocated.
-     * Each allocation or free space in memory also has surrounding tags to quickly point to the heap and allow for a fast kmalloc/kfree.
-     */
 
-    HeapManager::HeapManager() : m_bst(Common::BinarySearchTree<IndexEntry>(reinterpret_cast<void*>(HEAP_BASE)))
-    {
-        m_nextIndexPagePointer = reinterpret_cast<uint8_t*>(HEAP_BASE);
-        m_nextHeapPagePointer = reinterpret_cast<uint8_t*>(HEAP_BASE + HEAP_INDEX_SIZE);
-
-        // Allocate first pages for heap and index (binary search tree).
-        Memory::Manager::instance().alloc_page(VirtualMemoryAllocationRequest(VirtualAddress(m_nextIndexPagePointer), true, true));
-        Memory::Manager::instance().alloc_page(VirtualMemoryAllocationRequest(VirtualAddress(m_nextHeapPagePointer), true, true));
-
-        m_nextIndexPagePointer += PAGE_4KiB;
-        m_nextHeapPagePointer += PAGE_4KiB;
-
-        // Create the first entry which is the size of the whole page.
-        auto entry = IndexEntry();
-        entry.ptr = m_nextHeapPagePointer - PAGE_4KiB + sizeof(ChunkHeader);
-        entry.size = Memory::PAGE_4KiB - sizeof(ChunkHeader) - sizeof(ChunkFooter);
-        insert_entry_into_tree(entry);
-        write_entry_tags(entry, true);
-    }
+namespace
+{
+    constexpr std::size_t SIZE_CLASS_GRANULE = 16;
 
     /**
-     * Write header and footer tags for memory chunks in memory.
+     * Maps a request size, in granules, to its size class.
      */
-    void HeapManager::write_entry_tags(IndexEntry entry, bool isHole)
+    template <std::size_t Granules, std::size_t Count>
+    struct SizeClassTable
     {
-        uint8_t* start = entry.ptr - sizeof(ChunkHeader);
-        auto heapChunkHeader = new (start) ChunkHeader();
-        heapChunkHeader->isHole = isHole;
-        heapChunkHeader->size = entry.size;
-        auto heapChunkFooter = new (entry.ptr + entry.size) ChunkFooter();
-        heapChunkFooter->size = entry.size;
-    }
+        uint8_t classes[Granules + 1];
 
-    void HeapManager::insert_entry_into_tree(IndexEntry entry)
-    {
-        // If the binary search tree page range is too small, expand it.
-        if (m_bst.byte_size() + 2 * m_bst.node_size() >= reinterpret_cast<uint64_t>(m_nextIndexPagePointer - HEAP_BASE)) {
-            if (m_nextIndexPagePointer >= (void*)(HEAP_BASE + HEAP_INDEX_SIZE)) {
-                printf("PANIC: HEAP OVERFLOW");
-                while(1);
-            }
-            Memory::Manager::instance().alloc_page(Memory::VirtualMemoryAllocationRequest(m_nextIndexPagePointer, true, true));
-            m_nextIndexPagePointer += PAGE_4KiB;
-        }
-        m_bst.insert_element(entry);
-    }
-
-    void HeapManager::remove_entry_from_tree(IndexEntry entry)
-    {
-        m_bst.remove_element(entry);
-        // If the last page of the binary search tree page range is unused, free it.
-        if (m_bst.byte_size() + m_bst.node_size() < reinterpret_cast<uint64_t>(m_nextIndexPagePointer - HEAP_BASE - Memory::PAGE_4KiB))
+        constexpr SizeClassTable(const uint32_t (&sizeClasses)[Count])
+            : classes()
         {
-            Memory::Manager::instance().free_page(VirtualAddress((m_nextIndexPagePointer) - Memory::PAGE_4KiB));
-            m_nextIndexPagePointer -= PAGE_4KiB;
+            std::size_t sizeClass = 0;
+            for (std::size_t granules = 0; granules <= Granules; granules++) {
+                while (sizeClasses[sizeClass] < granules * SIZE_CLASS_GRANULE)
+                    sizeClass++;
+                classes[granules] = sizeClass;
+            }
         }
-    }
+    };
+}
 
-    IndexEntry HeapManager::get_entry(ChunkHeader* header)
-    {
-        IndexEntry entry = IndexEntry();
-        entry.ptr = reinterpret_cast<uint8_t*>(header) + sizeof(ChunkHeader);
-        entry.size = header->size;
-        return entry;
-    }
+void* HeapManager::kmalloc(uint64_t size, uint64_t flags)
+{
+    // Every allocation is 16-byte aligned, so no flags need special handling.
+    static constexpr SizeClassTable<MAX_SMALL_SIZE / SIZE_CLASS_GRANULE, SIZE_CLASS_COUNT> sizeClassTable(SIZE_CLASSES);
 
-    IndexEntry HeapManager::get_entry(ChunkFooter* footer)
-    {
-        IndexEntry entry = IndexEntry();
-        entry.ptr = reinterpret_cast<uint8_t*>(footer) - footer->size;
-        entry.size = footer->size;
-        return entry;
-    }
+    if (size > MAX_SMALL_SIZE)
+        return allocate_large(size);
+    return allocate_small(sizeClassTable.classes[(size + SIZE_CLASS_GRANULE - 1) / SIZE_CLASS_GRANULE]);
+}
 
-    ChunkHeader* HeapManager::get_corresponding_header(ChunkFooter* footer)
-    {
-        return reinterpret_cast<ChunkHeader*>(reinterpret_cast<uint8_t*>(footer) - sizeof(ChunkHeader) - footer->size);
-    }
+void HeapManager::kfree(void* ptr)
+{
+    if (!ptr)
+        return;
 
-    ChunkHeader* HeapManager::get_next_header(ChunkHeader* header)
-    {
-        auto headerPointer = reinterpret_cast<uint8_t*>(header) + sizeof(ChunkHeader) + sizeof(ChunkFooter) + header->size;
-        if (headerPointer >= m_nextHeapPagePointer)
-            return nullptr;
-        return reinterpret_cast<ChunkHeader*>(headerPointer);
-    }
+    auto header = static_cast<ChunkHeader*>(ptr) - 1;
+    KERNEL_ASSERT(header->magic == CHUNK_MAGIC);
 
-    ChunkHeader* HeapManager::get_prev_header(ChunkHeader* header)
-    {
-        auto footerPointer = reinterpret_cast<ChunkFooter*>(header) - 1;
-        if (reinterpret_cast<uint64_t>(footerPointer) < static_cast<uint64_t>(HEAP_BASE + HEAP_INDEX_SIZE))
-            return nullptr;
-        return get_corresponding_header(footerPointer);
-    }
+    if (header->sizeClass == LARGE_CHUNK)
+        free_large(header);
+    else
+        free_small(header);
+}
 
-    /**
-     * Expand the heap by adding an extra page at the end and merging the previous chunk if it was a hole.
-     */ 
-    void HeapManager::expand()
-    {
-        Memory::Manager::instance().alloc_page(VirtualMemoryAllocationRequest(m_nextHeapPagePointer, true, true));
+Statistics HeapManager::get_statistics()
+{
+    InterruptDisabler disabler;
+    return m_statistics;
+}
 
-        auto oldFooter = reinterpret_cast<ChunkFooter*>(m_nextHeapPagePointer) - 1;
-        auto oldHeader = get_corresponding_header(oldFooter);
-        if (oldHeader->isHole)
-        {
-            // We can simply make the previous entry 4KiB larger.
-            IndexEntry oldEntry = get_entry(oldFooter);
-            remove_entry_from_tree(oldEntry);
-            oldEntry.size += PAGE_4KiB;
-            insert_entry_into_tree(oldEntry);
-            write_entry_tags(oldEntry, true);
-        } else
-        {
-            // We need to insert a new entry for the new page.
-            IndexEntry newEntry = IndexEntry();
-            newEntry.ptr = m_nextHeapPagePointer + sizeof(ChunkHeader);
-            newEntry.size = PAGE_4KiB - sizeof(ChunkHeader) - sizeof(ChunkFooter);
-            insert_entry_into_tree(newEntry);
-            write_entry_tags(newEntry, true);
+void* HeapManager::allocate_small(std::size_t sizeClass)
+{
+    InterruptDisabler disabler;
+    if (!m_front.freeLists[sizeClass]) {
+        // Take a batch of chunks from the shared free list, carving more out of the heap if it is empty.
+        LockAcquirer l(m_spinlock);
+        while (m_front.counts[sizeClass] < FRONT_CAPACITY / 2) {
+            if (!m_freeLists[sizeClass])
+                refill(sizeClass);
+            auto chunk = m_freeLists[sizeClass];
+            m_freeLists[sizeClass] = chunk->next;
+            chunk->next = m_front.freeLists[sizeClass];
+            m_front.freeLists[sizeClass] = chunk;
+            m_front.counts[sizeClass]++;
         }
-
-        m_nextHeapPagePointer += PAGE_4KiB;
     }
 
-    void* HeapManager::kmalloc(uint64_t size, uint64_t flags)
-    {
-        LockAcquirer l(m_spinlock);
-        auto entry = find_smallest_entry_greater_than(size);
-        // Keep expanding the heap until we find a sufficiently sized entry.
-        while (!entry) {
-            expand();
-            entry = find_smallest_entry_greater_than(size);
-        }
-        IndexEntry backEntry = *entry;
+    auto chunk = m_front.freeLists[sizeClass];
+    m_front.freeLists[sizeClass] = chunk->next;
+    m_front.counts[sizeClass]--;
 
-        remove_entry_from_tree(*entry);
-        // The entry can be split into two - the allocation and the leftover free hole.
-        if (backEntry.size >= size + sizeof(ChunkFooter) + sizeof(ChunkHeader))
-        {
-            uint64_t oldEntrySize = backEntry.size;
-            backEntry.size = size;
-            IndexEntry holeEntry = backEntry;
-            holeEntry.ptr += backEntry.size + sizeof(ChunkHeader) + sizeof(ChunkFooter);
-            holeEntry.size = oldEntrySize - size - sizeof(ChunkHeader) - sizeof(ChunkFooter);
-            write_entry_tags(holeEntry, true);
-            insert_entry_into_tree(holeEntry);
-        }
-        write_entry_tags(backEntry, false);
-        return backEntry.ptr;
-    }
+    m_statistics.bytesInUse += SIZE_CLASSES[sizeClass];
+    m_statistics.allocations++;
+    return chunk;
+}
 
-    ChunkHeader* HeapManager::get_header(IndexEntry entry)
-    {
-        return reinterpret_cast<ChunkHeader*>(entry.ptr) - 1;
+void HeapManager::free_small(ChunkHeader* header)
+{
+    auto sizeClass = header->sizeClass;
+    auto chunk = reinterpret_cast<FreeChunk*>(header + 1);
+
+    InterruptDisabler disabler;
+    chunk->next = m_front.freeLists[sizeClass];
+    m_front.freeLists[sizeClass] = chunk;
+    m_front.counts[sizeClass]++;
+
+    m_statistics.bytesInUse -= SIZE_CLASSES[sizeClass];
+    m_statistics.frees++;
+
+    if (m_front.counts[sizeClass] < FRONT_CAPACITY)
+        return;
+
+    // Give half of the front's chunks back to the shared free list.
+    LockAcquirer l(m_spinlock);
+    while (m_front.counts[sizeClass] > FRONT_CAPACITY / 2) {
+        chunk = m_front.freeLists[sizeClass];
+        m_front.freeLists[sizeClass] = chunk->next;
+        m_front.counts[sizeClass]--;
+        chunk->next = m_freeLists[sizeClass];
+        m_freeLists[sizeClass] = chunk;
     }
+}
 
-    // If the next entry is also a hole, combine the two into a larger entry.
-    void HeapManager::merge_forwards(IndexEntry* entry)
-    {
-        auto nextHeader = get_next_header(get_header(*entry));
-        if (nextHeader && nextHeader->isHole)
-        {
-            auto nextEntry = get_entry(nextHeader);
-            // Remove the two smaller entries.
-            remove_entry_from_tree(*entry);
-            remove_entry_from_tree(nextEntry);
-            entry->size += nextHeader->size + sizeof(ChunkHeader) + sizeof(ChunkFooter);
-            // Insert the larger, combined entry.
-            insert_entry_into_tree(*entry);
-            write_entry_tags(*entry, true);
-        }
+void HeapManager::refill(std::size_t sizeClass)
+{
+    // The headers are written once here and stay intact while chunks move between free lists.
+    auto chunkSize = sizeof(ChunkHeader) + SIZE_CLASSES[sizeClass];
+    auto start = take_from_top(REFILL_SIZE);
+    for (auto ptr = start; ptr + chunkSize <= start + REFILL_SIZE; ptr += chunkSize) {
+        auto header = reinterpret_cast<ChunkHeader*>(ptr);
+        header->magic = CHUNK_MAGIC;
+        header->sizeClass = sizeClass;
+        header->size = SIZE_CLASSES[sizeClass];
+        auto chunk = reinterpret_cast<FreeChunk*>(header + 1);
+        chunk->next = m_freeLists[sizeClass];
+        m_freeLists[sizeClass] = chunk;
     }
+}
 
-    // If the previous entry is also a hole, combine the two into a larger entry.
-    void HeapManager::merge_backwards(IndexEntry* entry)
-    {
-        auto prevHeader = get_prev_header(get_header(*entry));
-        if (prevHeader && prevHeader->isHole)
-        {
-            auto prevEntry = get_entry(prevHeader);
-            // Remove the two smaller entries.
-            remove_entry_from_tree(*entry);
-            remove_entry_from_tree(prevEntry);
-            entry->size += prevHeader->size + sizeof(ChunkHeader) + sizeof(ChunkFooter);
-            entry->ptr -= prevHeader->size + sizeof(ChunkHeader) + sizeof(ChunkFooter);
-            // Insert the larger, combined entry.
-            insert_entry_into_tree(*entry);
-            write_entry_tags(*entry, true);
+void* HeapManager::allocate_large(uint64_t size)
+{
+    auto pages = BYTE_ALIGN_UP(size + sizeof(ChunkHeader), PAGE_4KiB) / PAGE_4KiB;
+    uint64_t run = 0;
+
+    LockAcquirer l(m_spinlock);
+    if (pages < RUN_BIN_COUNT) {
+        if (m_runBins[pages]) {
+            run = reinterpret_cast<uint64_t>(m_runBins[pages]);
+            m_runBins[pages] = m_runBins[pages]->next;
+        }
+    } else {
+        for (auto** it = &m_longRuns; *it; it = &(*it)->next) {
+            auto* freeRun = *it;
+            if (freeRun->pages < pages)
+                continue;
+            *it = freeRun->next;
+            run = reinterpret_cast<uint64_t>(freeRun);
+            auto remainingPages = freeRun->pages - pages;
+
+            if (remainingPages) {
+                auto remainder = run + pages * PAGE_4KiB;
+                if (remainingPages < RUN_BIN_COUNT) {
+                    auto remainderRun = reinterpret_cast<FreeRun*>(remainder);
+                    remainderRun->next = m_runBins[remainingPages];
+                    m_runBins[remainingPages] = remainderRun;
+                } else {
+                    auto remainderRun = reinterpret_cast<FreeRun*>(remainder);
+                    remainderRun->pages = remainingPages;
+                    remainderRun->next = m_longRuns;
+                    m_longRuns = remainderRun;
+                }
+            }
+            break;
         }
     }
 
-    void HeapManager::kfree(void* ptr)
-    {
-        LockAcquirer l(m_spinlock);
-        auto header = reinterpret_cast<ChunkHeader*>(ptr) - 1;
-        // Add the entry into the index binary search tree.
-        auto entry = get_entry(header);
-        insert_entry_into_tree(entry);
-        write_entry_tags(entry, true);
-
-        // Try and merge with holes either side, if they exist.
-        merge_forwards(&entry);
-        merge_backwards(&entry);
+    if (!run)
+        run = take_from_top(pages * PAGE_4KiB);
+
+    auto header = reinterpret_cast<ChunkHeader*>(run);
+    header->magic = CHUNK_MAGIC;
+    header->sizeClass = LARGE_CHUNK;
+    header->size = pages * PAGE_4KiB - sizeof(ChunkHeader);
+
+    m_statistics.bytesInUse += header->size;
+    m_statistics.allocations++;
+    m_statistics.largeAllocations++;
+    return header + 1;
+}
+
+void HeapManager::free_large(ChunkHeader* header)
+{
+    auto run = reinterpret_cast<uint64_t>(header);
+    auto pages = (header->size + sizeof(ChunkHeader)) / PAGE_4KiB;
+
+    LockAcquirer l(m_spinlock);
+    m_statistics.bytesInUse -= header->size;
+    m_statistics.frees++;
+    m_statistics.largeAllocations--;
+
+    auto freeRun = reinterpret_cast<FreeRun*>(run);
+    if (pages < RUN_BIN_COUNT) {
+        freeRun->next = m_runBins[pages];
+        m_runBins[pages] = freeRun;
+        return;
     }
 
-    IndexEntry* HeapManager::find_smallest_entry_greater_than(uint64_t size)
-    {
-        // We insert a searchEntry that is of the requested size and find the successor to the node in the binary search tree.
-        // The successor is the smallest entry that is greater than the searchEntry.
-        if (m_bst.byte_size() + 5 * m_bst.node_size() >= reinterpret_cast<uint64_t>(m_nextIndexPagePointer - HEAP_BASE)) {
-            Memory::Manager::instance().alloc_page(VirtualMemoryAllocationRequest(m_nextIndexPagePointer, true, true));
-            m_nextIndexPagePointer += PAGE_4KiB;
-        }
-        IndexEntry searchEntry;
-        searchEntry.size = size;
-        searchEntry.ptr = 0;
-        auto retEntry = m_bst.successor(searchEntry);
-        if (m_bst.byte_size() + 5 * m_bst.node_size() < reinterpret_cast<uint64_t>(m_nextIndexPagePointer - HEAP_BASE - PAGE_4KiB)) {
-            Memory::Manager::instance().free_page(VirtualMemoryFreeRequest(m_nextIndexPagePointer - PAGE_4KiB));
-            m_nextIndexPagePointer -= PAGE_4KiB;
-        }
-        return retEntry;
+    // Heap pages stay mapped for good. The page fault handler copies kernel mappings into
+    // other address spaces lazily, so a frame unmapped here could still be reached
+    // through them after it was freed.
+    freeRun->pages = pages;
+    freeRun->next = m_longRuns;
+    m_longRuns = freeRun;
+}
+
+uint64_t HeapManager::take_from_top(uint64_t size)
+{
+    // The top of the heap is always page aligned, as it only grows by whole pages.
+    if (m_heapTop + size > m_mappedTop) {
+        auto growth = BYTE_ALIGN_UP(m_heapTop + size - m_mappedTop, GROWTH_SIZE);
+        if (m_mappedTop + growth > HEAP_END)
+            Kernel::panic("Kernel heap exhausted its virtual address range.");
+        map_pages(m_mappedTop, growth / PAGE_4KiB);
+        m_mappedTop += growth;
     }
+
+    auto start = m_heapTop;
+    m_heapTop += size;
+    return start;
 }
 
-static Spinlock kmlock;
+void HeapManager::map_pages(uint64_t start, uint64_t pages)
+{
+    for (uint64_t page = 0; page < pages; page++)
+        Memory::Manager::instance().alloc_page(VirtualMemoryAllocationRequest(VirtualAddress(start + page * PAGE_4KiB), true, true));
+    m_statistics.bytesMapped += pages * PAGE_4KiB;
+}
+
+}
 
 void* kmalloc(uint64_t size, uint64_t flags)
 {
-    LockAcquirer l(kmlock);
-    return dlmalloc(size);
-    //return Memory::Heap::HeapManager::instance().kmalloc(size, flags);
+    return Memory::Heap::HeapManager::instance().kmalloc(size, flags);
 }
 
 void kfree(void* ptr)
 {
-    LockAcquirer l(kmlock);
-    return dlfree(ptr);
-    //Memory::Heap::HeapManager::instance().kfree(ptr);
+    Memory::Heap::HeapManager::instance().kfree(ptr);
 }
@@ -19,9 +19,9 @@
 #ifndef KHEAP_H
 #define KHEAP_H
 
-#include <stddef.h>
+#include <cstddef>
+#include <cstdint>
 
-#include "Common/BinarySearchTree.h"
 #include "Tasks/Spinlock.h"
 #include "print.h"
 
@@ -36,62 +36,44 @@ enum Flag : uint8_t
 };
 
 /**
- * The ChunkHeader is written in the heap before each allocation or hole.
+ * Every allocation is preceded by a header, which keeps the allocation 16-byte aligned.
  */
-struct [[gnu::packed]] ChunkHeader
+struct alignas(16) ChunkHeader
 {
-    bool isHole;
+    uint32_t magic;
+    // The size class of a small allocation, or LARGE_CHUNK for a run of pages.
+    uint32_t sizeClass;
+    // The number of bytes usable after the header.
     uint64_t size;
 };
 
-/**
- * The ChunkFooter is written in memory after each allocation or hole.
- */
-struct [[gnu::packed]] ChunkFooter
+static_assert(sizeof(ChunkHeader) == 16);
+
+struct Statistics
 {
-    uint64_t size;
+    // Bytes of virtual memory backed by physical pages.
+    uint64_t bytesMapped;
+    // Bytes handed out to callers, including size class rounding but not headers.
+    uint64_t bytesInUse;
+    uint64_t allocations;
+    uint64_t frees;
+    // Runs of pages currently allocated for large requests.
+    uint64_t largeAllocations;
 };
 
 /**
- * Each hole is inserted into a binary search tree table organised by size.
+ * The kernel heap is a segregated-fit allocator.
+ *
+ * Small requests are rounded up to one of a set of size classes, each with its own free list,
+ * so both kmalloc and kfree are O(1). Chunks are carved from the heap in bulk when a class
+ * runs dry. Large requests are whole runs of pages, kept in free lists by length once freed.
  */
-struct IndexEntry
-{
-    uint64_t size;
-    uint8_t* ptr;
-
-    bool operator==(const IndexEntry& entry) const = default;
-
-    bool operator!=(const IndexEntry& entry) const = default;
-
-    bool operator<(const IndexEntry& entry) const
-    {
-        return size < entry.size;
-    }
-
-    bool operator<=(const IndexEntry& entry) const
-    {
-        return size <= entry.size;
-    }
-
-    bool operator>(const IndexEntry& entry) const
-    {
-        return size > entry.size;
-    }
-
-    bool operator>=(const IndexEntry& entry) const
-    {
-        return size >= entry.size;
-    }
-
-}__attribute__((packed));
-
 class HeapManager
 {
 public:
     void* kmalloc(uint64_t size, uint64_t flags);
     void kfree(void* ptr);
-    void verify_integrity();
+    Statistics get_statistics();
     static HeapManager& instance()
     {
         static HeapManager instance;
@@ -100,34 +82,71 @@ public:
     HeapManager(HeapManager const&) = delete;
     HeapManager& operator=(HeapManager const&) = delete;
 private:
-    HeapManager();
-    static HeapManager* m_kernelHeapManager;
+    constexpr HeapManager() = default;
 
-    Common::BinarySearchTree<IndexEntry> m_bst;
+    struct FreeChunk
+    {
+        FreeChunk* next;
+    };
 
-    // Pointer to the next page to allocate for the index (binary search tree).
-    uint8_t* m_nextIndexPagePointer;
-    // Pointer to the next page to allocate for the heap.
-    uint8_t* m_nextHeapPagePointer;
-    
-    void insert_entry_into_tree(IndexEntry entry);
-    void remove_entry_from_tree(IndexEntry entry);
-    void write_entry_tags(IndexEntry entry, bool isHole);
-    ChunkHeader* get_corresponding_header(ChunkFooter* footer);
-    ChunkHeader* get_next_header(ChunkHeader* header);
-    ChunkHeader* get_prev_header(ChunkHeader* header);
-    IndexEntry get_entry(ChunkHeader* header);
-    IndexEntry get_entry(ChunkFooter* footer);
-    ChunkHeader* get_header(IndexEntry entry);
-    void merge_forwards(IndexEntry* entry);
-    void merge_backwards(IndexEntry* entry);
-    void expand();
-    IndexEntry* find_smallest_entry_greater_than(uint64_t size);
-
-    Spinlock m_spinlock;
+    /**
+     * A free run of pages. It is written at the start of the run's first page.
+     */
+    struct FreeRun
+    {
+        FreeRun* next;
+        uint64_t pages;
+    };
+
+    static constexpr uint32_t CHUNK_MAGIC = 0x4B484550;
+    static constexpr uint32_t LARGE_CHUNK = UINT32_MAX;
+    static constexpr std::size_t SIZE_CLASS_COUNT = 16;
+    static constexpr uint32_t SIZE_CLASSES[SIZE_CLASS_COUNT] = {
+        16, 32, 48, 64, 96, 128, 160, 192, 256, 320, 384, 512, 768, 1024, 1536, 2048
+    };
+    static constexpr std::size_t MAX_SMALL_SIZE = 2048;
+    // The heap is grown by at least this many bytes at a time.
+    static constexpr std::size_t GROWTH_SIZE = 0x10000;
+    // Chunks of a size class are carved out of the heap this many bytes at a time.
+    static constexpr std::size_t REFILL_SIZE = 0x4000;
+    // Runs of pages shorter than this are kept in exact-length free lists.
+    // Longer runs go on a single list, and are split when reused.
+    static constexpr std::size_t RUN_BIN_COUNT = 32;
+    // The number of chunks of each size class the processor can hold without taking the heap lock.
+    static constexpr std::size_t FRONT_CAPACITY = 32;
+
+    /**
+     * Chunks freed on the processor, handed out again without taking the heap lock.
+     * The kernel runs on a single processor, so there is one front, protected by disabling interrupts.
+     */
+    struct ProcessorFront
+    {
+        FreeChunk* freeLists[SIZE_CLASS_COUNT] = {};
+        uint32_t counts[SIZE_CLASS_COUNT] = {};
+    };
+
+    void* allocate_small(std::size_t sizeClass);
+    void free_small(ChunkHeader* header);
+    void refill(std::size_t sizeClass);
+    void* allocate_large(uint64_t size);
+    void free_large(ChunkHeader* header);
+    uint64_t take_from_top(uint64_t size);
+    void map_pages(uint64_t start, uint64_t pages);
+
+    ProcessorFront m_front;
+    FreeChunk* m_freeLists[SIZE_CLASS_COUNT] = {};
+    FreeRun* m_runBins[RUN_BIN_COUNT] = {};
+    // Free runs of at least RUN_BIN_COUNT pages.
+    FreeRun* m_longRuns = nullptr;
+
+    // The end of the carved part of the heap, and the end of the mapped part.
+    uint64_t m_heapTop = HEAP_BASE;
+    uint64_t m_mappedTop = HEAP_BASE;
+
+    Statistics m_statistics = {};
+    Spinlock m_spinlock{LOCK_CLASS("Heap::HeapManager::m_spinlock")};
 
     static constexpr uint64_t HEAP_BASE = 0xFFFFDF8000000000;
-    static constexpr uint64_t HEAP_INDEX_SIZE = 0x8000000000;
     static constexpr uint64_t HEAP_END = 0xFFFFFF8000000000;
 };
 
@@ -138,4 +157,4 @@ void* kmalloc(uint64_t size, uint64_t flags = 0);
 void kfree(void* ptr);
 /* new and delete operators for kernel objects */
 
-#endif
\ No newline at end of file
+#endif
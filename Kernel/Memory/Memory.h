@@ -91,9 +91,21 @@ extern "C" inline void* memset(void* str, uint64_t c, uint64_t sz)
     return fast_aligned_wordwise_64_memset(str, c, sz);
 }
 
+extern "C" inline void* fast_wordwise_64_memcpy(void* dst, const void* src, uint64_t sz)
+{
+    void* d = dst;
+    uint64_t words = sz >> 3;
+    uint64_t bytes = sz & 0b111;
+    asm volatile ("cld; rep movsq" : "+D"(d), "+S"(src), "+c"(words) : : "memory");
+    asm volatile ("rep movsb" : "+D"(d), "+S"(src), "+c"(bytes) : : "memory");
+    return dst;
+}
+
 extern "C" inline void* memcpy(void* dst, const void* src, uint64_t sz)
 {
-    return slow_memcpy(dst, src, sz);
+    if (sz < 16)
+        return slow_memcpy(dst, src, sz);
+    return fast_wordwise_64_memcpy(dst, src, sz);
 }
 
 /*void *operator new(std::size_t size) noexcept;
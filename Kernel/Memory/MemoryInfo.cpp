@@ -0,0 +1,131 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "API/MemoryInfo.h"
+#include "Memory/KernelHeap.h"
+#include "Memory/MemoryInfo.h"
+#include "Memory/SharedMemory.h"
+#include "Pipes/Pipe.h"
+#include "Tasks/TaskManager.h"
+
+namespace Memory::Info
+{
+
+namespace
+{
+    struct Reader
+    {
+        bool task;
+        Task::TaskID tid;
+    };
+
+    Pipes::DeviceOperations deviceOperations;
+
+    xpOS::API::MemoryInfo::SystemInfo system_snapshot()
+    {
+        auto physical = Manager::instance().get_statistics();
+        auto heap = Heap::HeapManager::instance().get_statistics();
+        auto shared = Shared::get_statistics();
+
+        return {
+            .pageSize = PAGE_4KiB,
+            .totalPages = physical.totalBlocks,
+            .freePages = physical.freeBlocks,
+            .pageTablePages = physical.pageTableBlocks,
+            .heapBytesMapped = heap.bytesMapped,
+            .heapBytesInUse = heap.bytesInUse,
+            .heapAllocations = heap.allocations,
+            .heapFrees = heap.frees,
+            .heapLargeAllocations = heap.largeAllocations,
+            .sharedObjects = shared.objects,
+            .sharedAttachments = shared.attachments,
+            .sharedBytes = shared.bytes
+        };
+    }
+
+    xpOS::API::MemoryInfo::TaskInfo task_snapshot(Task::TaskID tid)
+    {
+        xpOS::API::MemoryInfo::TaskInfo info = { .tid = tid };
+        auto addressSpace = Task::Manager::instance().find_address_space(tid);
+        if (!addressSpace.has_value())
+            return info;
+
+        auto statistics = Manager::instance().get_address_space_statistics(**addressSpace);
+        info.residentPages = statistics.residentPages;
+        info.pageTablePages = statistics.pageTablePages;
+        return info;
+    }
+
+    std::size_t copy_snapshot(const void* snapshot, std::size_t size, std::size_t offset, std::size_t count, void* buf)
+    {
+        if (offset >= size)
+            return 0;
+        if (count > size - offset)
+            count = size - offset;
+        memcpy(buf, static_cast<const char*>(snapshot) + offset, count);
+        return count;
+    }
+}
+
+void initialise()
+{
+    deviceOperations = {
+        .open = open,
+        .close = close,
+        .read = read,
+        .info = info
+    };
+    Pipes::register_device("sys::meminfo", &deviceOperations);
+}
+
+bool open(void* with, int flags, void*& deviceSpecific)
+{
+    auto* reader = new Reader { .task = false, .tid = 0 };
+    if (flags & xpOS::API::MemoryInfo::Flags::TASK) {
+        reader->task = true;
+        reader->tid = with ? *static_cast<Task::TaskID*>(with) : Task::Manager::instance().get_current_tid();
+    }
+    deviceSpecific = reader;
+    return true;
+}
+
+void close(void*& deviceSpecific)
+{
+    delete static_cast<Reader*>(deviceSpecific);
+}
+
+std::size_t read(std::size_t offset, std::size_t count, void* buf, void*& deviceSpecific)
+{
+    auto* reader = static_cast<Reader*>(deviceSpecific);
+    if (reader->task) {
+        auto snapshot = task_snapshot(reader->tid);
+        return copy_snapshot(&snapshot, sizeof(snapshot), offset, count, buf);
+    }
+    auto snapshot = system_snapshot();
+    return copy_snapshot(&snapshot, sizeof(snapshot), offset, count, buf);
+}
+
+xpOS::API::Pipes::PipeInfo info(void*& deviceSpecific)
+{
+    auto* reader = static_cast<Reader*>(deviceSpecific);
+    return {
+        .size = reader->task ? sizeof(xpOS::API::MemoryInfo::TaskInfo) : sizeof(xpOS::API::MemoryInfo::SystemInfo)
+    };
+}
+
+}
@@ -16,18 +16,29 @@
     xpOS v1.0
 */
 
-#ifndef DLMALLOCHOOK_H
-#define DLMALLOCHOOK_H
+#ifndef MEMORYINFO_H
+#define MEMORYINFO_H
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+#include <cstdint>
 
-void *replacement_sbrk(long size);
+#include "API/Pipes.h"
 
-#ifdef __cplusplus
-}
-#endif
+namespace Memory
+{
 
+/**
+ * Exposes the memory accounting counters through the read-only sys::meminfo device.
+ * Each read takes a fresh snapshot, so seek back to the start to refresh.
+ */
+namespace Info
+{
+    void initialise();
+    bool open(void* with, int flags, void*& deviceSpecific);
+    void close(void*& deviceSpecific);
+    std::size_t read(std::size_t offset, std::size_t count, void* buf, void*& deviceSpecific);
+    xpOS::API::Pipes::PipeInfo info(void*& deviceSpecific);
+};
+
+}
 
 #endif
@@ -19,18 +19,30 @@
 #include "Memory/Address.h"
 #include "Memory/MemoryManager.h"
 #include "panic.h"
+#include "x86_64.h"
 
 namespace Memory {
+
+    constinit Manager Manager::m_instance;
     
     void Manager::init_physical_region(PhysicalAddress base, uint64_t size)
     {
         auto align = reinterpret_cast<uint64_t>(base.get()) / PHYSICAL_BLOCK_SIZE;
         auto blocks = size / PHYSICAL_BLOCK_SIZE;
 
-        for (std::size_t i = 0; i < blocks; i++)
-            m_physicalBitmap.unset(align + i);
+        for (std::size_t i = 0; i < blocks; i++) {
+            if (m_physicalBitmap.is_set(align + i)) {
+                m_physicalBitmap.unset(align + i);
+                m_freePhysicalBlockCount++;
+                m_totalPhysicalBlockCount++;
+            }
+        }
         
-        m_physicalBitmap.set(0);
+        if (!m_physicalBitmap.is_set(0)) {
+            m_physicalBitmap.set(0);
+            m_freePhysicalBlockCount--;
+            m_totalPhysicalBlockCount--;
+        }
     }
 
     void Manager::deinit_physical_region(PhysicalAddress base, uint64_t size)
@@ -45,8 +57,12 @@ namespace Memory {
         if ((size % PHYSICAL_BLOCK_SIZE) + (reinterpret_cast<uint64_t>(base.get()) % PHYSICAL_BLOCK_SIZE) > PHYSICAL_BLOCK_SIZE)
             blocks++;
 
-        for (std::size_t i = 0; i < blocks; i++)
-            m_physicalBitmap.set(align + i);
+        for (std::size_t i = 0; i < blocks; i++) {
+            if (!m_physicalBitmap.is_set(align + i)) {
+                m_physicalBitmap.set(align + i);
+                m_freePhysicalBlockCount--;
+            }
+        }
     }
 
     PhysicalAddress Manager::alloc_physical_block()
@@ -59,16 +75,92 @@ namespace Memory {
             Kernel::panic("Physical memory manager unable to allocate memory, out of memory?");
 
         m_physicalBitmap.set(frame);
+        m_frameReferenceCounts[frame] = 1;
+        m_freePhysicalBlockCount--;
 
         return PhysicalAddress(physAddress);
     }
 
+    PhysicalAddress Manager::alloc_physical_blocks(std::size_t count, std::size_t alignment)
+    {
+        LockAcquirer l(m_physicalBitmapLock);
+        auto frame = m_physicalBitmap.find_unset_run(count, alignment / PHYSICAL_BLOCK_SIZE);
+        if (frame == 0)
+            return PhysicalAddress(static_cast<uint64_t>(0));
+
+        for (std::size_t i = 0; i < count; i++) {
+            m_physicalBitmap.set(frame + i);
+            m_frameReferenceCounts[frame + i] = 1;
+        }
+        m_freePhysicalBlockCount -= count;
+
+        return PhysicalAddress(frame * PHYSICAL_BLOCK_SIZE);
+    }
+
     void Manager::free_physical_block(PhysicalAddress block)
     {
         LockAcquirer l(m_physicalBitmapLock); 
         auto physAddress = reinterpret_cast<uint64_t>(block.get());
         auto frame = physAddress / PHYSICAL_BLOCK_SIZE;
+
+        // Device memory (such as the framebuffer) and reserved regions were never handed out by the allocator.
+        if (frame >= m_physicalBitmap.size() || m_frameReferenceCounts[frame] == 0)
+            return;
+        
+        if (--m_frameReferenceCounts[frame])
+            return;
+
         m_physicalBitmap.unset(frame);
+        m_freePhysicalBlockCount++;
+    }
+
+    void Manager::reference_physical_block(PhysicalAddress block)
+    {
+        LockAcquirer l(m_physicalBitmapLock);
+        auto physAddress = reinterpret_cast<uint64_t>(block.get());
+        auto frame = physAddress / PHYSICAL_BLOCK_SIZE;
+
+        if (frame >= m_physicalBitmap.size() || m_frameReferenceCounts[frame] == 0)
+            return;
+
+        KERNEL_ASSERT(m_frameReferenceCounts[frame] != UINT16_MAX);
+        m_frameReferenceCounts[frame]++;
+    }
+
+    void Manager::free_physical_blocks(PhysicalAddress base, uint64_t size)
+    {
+        auto physAddress = reinterpret_cast<uint64_t>(base.get());
+        for (uint64_t offset = 0; offset < size; offset += PHYSICAL_BLOCK_SIZE)
+            free_physical_block(PhysicalAddress(physAddress + offset));
+    }
+
+    std::size_t Manager::get_free_physical_block_count()
+    {
+        LockAcquirer l(m_physicalBitmapLock);
+        return m_freePhysicalBlockCount;
+    }
+
+    PhysicalAddress Manager::alloc_table_block()
+    {
+        auto block = alloc_physical_block();
+        __atomic_add_fetch(&m_pageTableBlockCount, 1, __ATOMIC_RELAXED);
+        return block;
+    }
+
+    void Manager::free_table_block(PhysicalAddress block)
+    {
+        __atomic_sub_fetch(&m_pageTableBlockCount, 1, __ATOMIC_RELAXED);
+        free_physical_block(block);
+    }
+
+    PhysicalMemoryStatistics Manager::get_statistics()
+    {
+        LockAcquirer l(m_physicalBitmapLock);
+        return {
+            .totalBlocks = m_totalPhysicalBlockCount,
+            .freeBlocks = m_freePhysicalBlockCount,
+            .pageTableBlocks = __atomic_load_n(&m_pageTableBlockCount, __ATOMIC_RELAXED)
+        };
     }
 
     void Manager::protect_physical_regions(PhysicalAddress kernelEnd)
@@ -114,10 +206,14 @@ namespace Memory {
         if (numBytes % PhysicalBitmap::CHAR_BIT)
             numBytes++;
         
-        // We place the bitmap at the end of physical memory.
+        // We place the bitmap at the end of physical memory, with the block reference counts below it.
         m_physicalBitmap.initialise(VirtualAddress(PhysicalAddress(useableMemorySize - numBytes)).get(), numBits);
 
-        auto memoryBitmapPageStart = BYTE_ALIGN_UP(useableMemorySize - numBytes, PHYSICAL_BLOCK_SIZE);
+        auto referenceCountsStart = BYTE_ALIGN_DOWN(useableMemorySize - numBytes - numBits * sizeof(uint16_t), sizeof(uint16_t));
+        m_frameReferenceCounts = static_cast<uint16_t*>(VirtualAddress(PhysicalAddress(referenceCountsStart)).get());
+        memset(m_frameReferenceCounts, 0, numBits * sizeof(uint16_t));
+
+        auto memoryBitmapPageStart = BYTE_ALIGN_DOWN(referenceCountsStart, PHYSICAL_BLOCK_SIZE);
         for (auto entry = tag->entry_start();
             reinterpret_cast<uint64_t>(entry) < reinterpret_cast<uint64_t>(tag) + tag->size;
             entry = reinterpret_cast<multiboot_mmap_entry*>((reinterpret_cast<uint64_t>(entry) + tag->entry_size)))
@@ -150,10 +246,11 @@ namespace Memory {
     {
         if (!get_flag(Flag::PRESENT) || get_flag(Flag::PAGE_SIZE))
         {
-            PhysicalAddress newTable = Manager::instance().alloc_physical_block();
+            PhysicalAddress newTable = Manager::instance().alloc_table_block();
             memset(VirtualAddress(newTable).get(), 0, sizeof(GenericTable));
             set_frame(newTable);
             clear_flag(Flag::PAGE_SIZE);
+            clear_flag(Flag::GLOBAL);
         }
         set_access_flags(request);
     }
@@ -162,8 +259,23 @@ namespace Memory {
     {
         if (request.pageSize != PAGE_4KiB)
             set_flag(Flag::PAGE_SIZE);
+        // The global flag is only meaningful in entries that map a page.
+        if (request.global)
+            set_flag(Flag::GLOBAL);
+        else
+            clear_flag(Flag::GLOBAL);
         set_frame(request.physicalAddress);
         set_access_flags(request);
+        if (request.copyOnWrite) {
+            clear_flag(Flag::WRITEABLE);
+            set_flag(Flag::COPY_ON_WRITE);
+        } else {
+            clear_flag(Flag::COPY_ON_WRITE);
+        }
+        if (request.anonymous)
+            set_flag(Flag::ANONYMOUS);
+        else
+            clear_flag(Flag::ANONYMOUS);
     }
 
     void GenericEntry::free_table()
@@ -171,7 +283,7 @@ namespace Memory {
         // If the PAGE_SIZE flag is set, then this is not a table but rather a page entry.
         if (get_flag(Flag::PRESENT) && !get_flag(Flag::PAGE_SIZE))
         {
-            Manager::instance().free_physical_block(get_frame());
+            Manager::instance().free_table_block(get_frame());
             m_entry = 0;
         }
     }
@@ -238,13 +350,19 @@ namespace Memory {
 
     void Manager::request_virtual_map(VirtualMemoryMapRequest request, VirtualAddressSpace& addressSpace)
     {
+        // Supervisor mappings in the higher half are the same in every address space,
+        // so they are marked global and survive address space switches.
+        if (reinterpret_cast<uint64_t>(request.virtualAddress.get()) >= HIGHER_HALF_START && !request.allowUserAccess)
+            request.global = true;
         static_cast<PML4Table*>(VirtualAddress(addressSpace.get_physical_address()).get())->request_virtual_map(request);
+        invalidate_inactive_address_space(addressSpace);
         Manager::instance().flush_tlb_entry(request.virtualAddress);
     }
 
     void Manager::request_virtual_unmap(VirtualMemoryUnmapRequest request, VirtualAddressSpace& addressSpace)
     {
         static_cast<PML4Table*>(VirtualAddress(addressSpace.get_physical_address()).get())->request_virtual_unmap(request);
+        invalidate_inactive_address_space(addressSpace);
         Manager::instance().flush_tlb_entry(request.virtualAddress);
     }
 
@@ -311,6 +429,71 @@ namespace Memory {
     {
         m_virtualAddressSpace = create_virtual_address_space();
         switch_to_address_space(get_main_address_space());
+        // CR4.PCIDE can only be set while CR3 holds PCID 0, which the main address space uses.
+        enable_tlb_extensions();
+        // Supervisor writes must also fault on read-only pages, so that copy-on-write pages
+        // are never written in place by the kernel on behalf of a task.
+        X86_64::write_cr0(X86_64::read_cr0() | CR0_WP);
+    }
+
+    void Manager::enable_tlb_extensions()
+    {
+        uint32_t eax, ebx, ecx, edx;
+        X86_64::cpuid(1, eax, ebx, ecx, edx);
+
+        auto cr4 = X86_64::read_cr4() | CR4_PGE;
+        if (ecx & CPUID_ECX_PCID) {
+            cr4 |= CR4_PCIDE;
+            m_pcidEnabled = true;
+        }
+        X86_64::write_cr4(cr4);
+    }
+
+    void Manager::flush_tlb_all()
+    {
+        // Toggling CR4.PGE invalidates all TLB entries, regardless of PCID or the global flag.
+        auto cr4 = X86_64::read_cr4();
+        X86_64::write_cr4(cr4 & ~CR4_PGE);
+        X86_64::write_cr4(cr4);
+    }
+
+    void Manager::invalidate_inactive_address_space(VirtualAddressSpace& addressSpace)
+    {
+        // INVLPG only affects the current PCID, so an address space modified while it is not loaded
+        // gives up its PCID. It is assigned a fresh one, which has no cached translations, when next switched to.
+        auto topLevelTable = reinterpret_cast<uint64_t>(addressSpace.get_physical_address().get());
+        if (topLevelTable != (X86_64::read_cr3() & CR3_FRAME_MASK))
+            addressSpace.m_pcidGeneration = 0;
+    }
+
+    uint64_t Manager::get_address_space_switch_value(VirtualAddressSpace& addressSpace)
+    {
+        auto topLevelTable = reinterpret_cast<uint64_t>(addressSpace.get_physical_address().get());
+        if (!m_pcidEnabled)
+            return topLevelTable;
+
+        // Kernel tasks hold copies of the main address space, so they share its tables and PCID.
+        if (topLevelTable == reinterpret_cast<uint64_t>(m_virtualAddressSpace.get_physical_address().get()))
+            return topLevelTable | CR3_NO_FLUSH;
+
+        LockAcquirer l(m_pcidLock);
+        if (addressSpace.m_pcidGeneration != m_pcidGeneration) {
+            // Once every PCID has been handed out, a new generation begins. Address spaces holding
+            // a PCID from an older generation are reassigned one when they are next switched to.
+            if (m_nextPcid > MAX_PCID) {
+                m_pcidGeneration++;
+                m_nextPcid = FIRST_PCID;
+                flush_tlb_all();
+            }
+            addressSpace.m_pcid = m_nextPcid++;
+            addressSpace.m_pcidGeneration = m_pcidGeneration;
+
+            // The PCID was used in an earlier generation, and the CR3 still loaded across a rollover's
+            // flush can have cached entries under it since. Its first load flushes them.
+            return topLevelTable | addressSpace.m_pcid;
+        }
+
+        return topLevelTable | addressSpace.m_pcid | CR3_NO_FLUSH;
     }
 
     // TODO: allow this to accept offsets into a page
@@ -366,6 +549,169 @@ namespace Memory {
         return entry->get_frame();
     }
 
+    GenericEntry* PML4Table::get_page_entry(VirtualAddress virtualAddress)
+    {
+        auto entry = get_entry(virtualAddress);
+        if (!entry->is_present())
+            return nullptr;
+        auto pageDirectoryPointerTable = static_cast<PageDirectoryPointerTable*>(VirtualAddress(PhysicalAddress(entry->get_frame())).get());
+        return pageDirectoryPointerTable->get_page_entry(virtualAddress);
+    }
+
+    GenericEntry* PageDirectoryPointerTable::get_page_entry(VirtualAddress virtualAddress)
+    {
+        auto entry = get_entry(virtualAddress);
+        if (!entry->is_present() || entry->get_flag(GenericEntry::Flag::PAGE_SIZE))
+            return nullptr;
+        auto pageDirectoryTable = static_cast<PageDirectoryTable*>(VirtualAddress(PhysicalAddress(entry->get_frame())).get());
+        return pageDirectoryTable->get_page_entry(virtualAddress);
+    }
+
+    GenericEntry* PageDirectoryTable::get_page_entry(VirtualAddress virtualAddress)
+    {
+        auto entry = get_entry(virtualAddress);
+        if (!entry->is_present() || entry->get_flag(GenericEntry::Flag::PAGE_SIZE))
+            return nullptr;
+        auto pageTable = static_cast<PageTable*>(VirtualAddress(PhysicalAddress(entry->get_frame())).get());
+        return pageTable->get_page_entry(virtualAddress);
+    }
+
+    GenericEntry* PageTable::get_page_entry(VirtualAddress virtualAddress)
+    {
+        auto entry = get_entry(virtualAddress);
+        return entry->is_present() ? entry : nullptr;
+    }
+
+    bool Manager::mirror_main_page(VirtualAddress virtualAddress, VirtualAddressSpace& addressSpace)
+    {
+        auto page = VirtualAddress(BYTE_ALIGN_DOWN(reinterpret_cast<uint64_t>(virtualAddress.get()), PAGE_4KiB));
+        auto entry = static_cast<PML4Table*>(VirtualAddress(m_virtualAddressSpace.get_physical_address()).get())->get_page_entry(page);
+        if (!entry)
+            return false;
+
+        // Read-only kernel pages must stay read-only everywhere, as CR0.WP makes the
+        // kernel's own writes to them fault.
+        VirtualMemoryMapRequest request = {
+            .physicalAddress = entry->get_frame(),
+            .virtualAddress = page,
+            .allowWrite = entry->get_flag(GenericEntry::Flag::WRITEABLE),
+            .global = entry->get_flag(GenericEntry::Flag::GLOBAL)
+        };
+        request_virtual_map(request, addressSpace);
+        return true;
+    }
+
+    bool Manager::resolve_copy_on_write(VirtualAddress virtualAddress, VirtualAddressSpace& addressSpace)
+    {
+        auto page = VirtualAddress(BYTE_ALIGN_DOWN(reinterpret_cast<uint64_t>(virtualAddress.get()), PAGE_4KiB));
+        auto entry = static_cast<PML4Table*>(VirtualAddress(addressSpace.get_physical_address()).get())->get_page_entry(page);
+        if (!entry || !entry->get_flag(GenericEntry::Flag::COPY_ON_WRITE))
+            return false;
+
+        auto original = entry->get_frame();
+        {
+            LockAcquirer l(m_physicalBitmapLock);
+            auto index = reinterpret_cast<uint64_t>(original.get()) / PHYSICAL_BLOCK_SIZE;
+            // Nothing else references the frame any more, for example once a lent page has
+            // been read, so it can be written in place.
+            if (index < m_physicalBitmap.size() && m_frameReferenceCounts[index] == 1) {
+                entry->clear_flag(GenericEntry::Flag::COPY_ON_WRITE);
+                entry->set_flag(GenericEntry::Flag::WRITEABLE);
+                flush_tlb_entry(page);
+                return true;
+            }
+        }
+
+        // The original frame may be shared or not owned by the allocator at all (such as the initrd),
+        // so it is copied and our reference to it dropped.
+        auto copy = alloc_physical_block();
+        memcpy(VirtualAddress(copy).get(), VirtualAddress(original).get(), PAGE_4KiB);
+
+        entry->set_frame(copy);
+        entry->clear_flag(GenericEntry::Flag::COPY_ON_WRITE);
+        entry->set_flag(GenericEntry::Flag::WRITEABLE);
+        flush_tlb_entry(page);
+        free_physical_block(original);
+        return true;
+    }
+
+    bool Manager::is_writeable_user_range(VirtualAddress start, std::size_t count, VirtualAddressSpace& addressSpace)
+    {
+        auto begin = reinterpret_cast<uint64_t>(start.get());
+        if (!is_user_range(start, count))
+            return false;
+        if (count == 0)
+            return true;
+
+        auto* topLevelTable = static_cast<PML4Table*>(VirtualAddress(addressSpace.get_physical_address()).get());
+        for (auto page = BYTE_ALIGN_DOWN(begin, PAGE_4KiB); page < begin + count; page += PAGE_4KiB) {
+            auto entry = topLevelTable->get_page_entry(VirtualAddress(page));
+            if (!entry || !entry->is_present())
+                continue;
+            if (!entry->get_flag(GenericEntry::Flag::USER_ACCESS))
+                return false;
+            if (!entry->get_flag(GenericEntry::Flag::WRITEABLE) && !entry->get_flag(GenericEntry::Flag::COPY_ON_WRITE))
+                return false;
+        }
+        return true;
+    }
+
+    GenericEntry* Manager::get_private_user_page_entry(VirtualAddress page, VirtualAddressSpace& addressSpace)
+    {
+        if (reinterpret_cast<uint64_t>(page.get()) >= HIGHER_HALF_START)
+            return nullptr;
+        auto entry = static_cast<PML4Table*>(VirtualAddress(addressSpace.get_physical_address()).get())->get_page_entry(page);
+        if (!entry || !entry->get_flag(GenericEntry::Flag::USER_ACCESS) || !entry->get_flag(GenericEntry::Flag::ANONYMOUS))
+            return nullptr;
+        return entry;
+    }
+
+    PhysicalAddress Manager::lend_page(VirtualAddress page, VirtualAddressSpace& addressSpace)
+    {
+        // Shared memory and file mappings are left alone, as their frames are written
+        // through other mappings and cannot be made copy-on-write here.
+        auto entry = get_private_user_page_entry(page, addressSpace);
+        if (!entry)
+            return PhysicalAddress();
+
+        auto frame = entry->get_frame();
+        {
+            LockAcquirer l(m_physicalBitmapLock);
+            auto index = reinterpret_cast<uint64_t>(frame.get()) / PHYSICAL_BLOCK_SIZE;
+            // Device memory and reserved regions are never lent, as they are not reference counted.
+            if (index >= m_physicalBitmap.size() || m_frameReferenceCounts[index] == 0)
+                return PhysicalAddress();
+            KERNEL_ASSERT(m_frameReferenceCounts[index] != UINT16_MAX);
+            m_frameReferenceCounts[index]++;
+        }
+
+        if (entry->get_flag(GenericEntry::Flag::WRITEABLE)) {
+            entry->clear_flag(GenericEntry::Flag::WRITEABLE);
+            entry->set_flag(GenericEntry::Flag::COPY_ON_WRITE);
+            flush_tlb_entry(page);
+        }
+        return frame;
+    }
+
+    bool Manager::accept_lent_page(PhysicalAddress frame, VirtualAddress page, VirtualAddressSpace& addressSpace)
+    {
+        // Only a frame nothing else maps may be replaced, or freeing it would pull it out
+        // from under a shared memory object or file mapping.
+        auto entry = get_private_user_page_entry(page, addressSpace);
+        if (!entry)
+            return false;
+        if (!entry->get_flag(GenericEntry::Flag::WRITEABLE) && !entry->get_flag(GenericEntry::Flag::COPY_ON_WRITE))
+            return false;
+
+        auto replaced = entry->get_frame();
+        entry->set_frame(frame);
+        entry->clear_flag(GenericEntry::Flag::WRITEABLE);
+        entry->set_flag(GenericEntry::Flag::COPY_ON_WRITE);
+        flush_tlb_entry(page);
+        free_physical_block(replaced);
+        return true;
+    }
+
     void Manager::alloc_page(VirtualMemoryAllocationRequest request, VirtualAddressSpace& addressSpace)
     {
         auto physicalAddress = alloc_physical_block();
@@ -373,14 +719,180 @@ namespace Memory {
             .physicalAddress = physicalAddress,
             .virtualAddress = request.virtualAddress,
             .allowWrite = request.allowWrite,
-            .allowUserAccess = request.allowUserAccess
+            .allowUserAccess = request.allowUserAccess,
+            .anonymous = true
         };
         request_virtual_map(mapRequest, addressSpace);
     }
 
     void Manager::free_page(VirtualMemoryFreeRequest request, VirtualAddressSpace& addressSpace)
     {
-        //auto physicalAddress = get_physical_address(request.virtualAddress, addressSpace);
+        auto physicalAddress = get_physical_address(request.virtualAddress, addressSpace);
         request_virtual_unmap(VirtualMemoryUnmapRequest(request), addressSpace);
+        free_physical_block(physicalAddress);
+    }
+
+    void Manager::destroy_virtual_address_space(VirtualAddressSpace& addressSpace)
+    {
+        auto topLevelTable = addressSpace.get_physical_address();
+        KERNEL_ASSERT(topLevelTable.get() != m_virtualAddressSpace.get_physical_address().get());
+        KERNEL_ASSERT(reinterpret_cast<uint64_t>(topLevelTable.get()) != (X86_64::read_cr3() & CR3_FRAME_MASK));
+
+        static_cast<PML4Table*>(VirtualAddress(topLevelTable).get())->destroy();
+        free_table_block(topLevelTable);
+    }
+
+    void PML4Table::destroy()
+    {
+        for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+            auto& entry = m_entries[i];
+            if (!entry.is_present())
+                continue;
+            // Frames in the higher half belong to the kernel and are mapped in every address space,
+            // so only the tables mapping them are freed.
+            bool freeFrames = i < ENTRIES_PER_TABLE / 2;
+            auto pageDirectoryPointerTable = static_cast<PageDirectoryPointerTable*>(VirtualAddress(PhysicalAddress(entry.get_frame())).get());
+            pageDirectoryPointerTable->destroy(freeFrames);
+            entry.free_table();
+        }
+    }
+
+    void PageDirectoryPointerTable::destroy(bool freeFrames)
+    {
+        for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+            auto& entry = m_entries[i];
+            if (!entry.is_present())
+                continue;
+            if (entry.get_flag(GenericEntry::Flag::PAGE_SIZE)) {
+                if (freeFrames)
+                    Manager::instance().free_physical_blocks(entry.get_frame(), PAGE_1GiB);
+                entry.clear();
+                continue;
+            }
+            auto pageDirectoryTable = static_cast<PageDirectoryTable*>(VirtualAddress(PhysicalAddress(entry.get_frame())).get());
+            pageDirectoryTable->destroy(freeFrames);
+            entry.free_table();
+        }
+    }
+
+    void PageDirectoryTable::destroy(bool freeFrames)
+    {
+        for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+            auto& entry = m_entries[i];
+            if (!entry.is_present())
+                continue;
+            if (entry.get_flag(GenericEntry::Flag::PAGE_SIZE)) {
+                if (freeFrames)
+                    Manager::instance().free_physical_blocks(entry.get_frame(), PAGE_2MiB);
+                entry.clear();
+                continue;
+            }
+            auto pageTable = static_cast<PageTable*>(VirtualAddress(PhysicalAddress(entry.get_frame())).get());
+            pageTable->destroy(freeFrames);
+            entry.free_table();
+        }
+    }
+
+    void PageTable::destroy(bool freeFrames)
+    {
+        for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+            auto& entry = m_entries[i];
+            if (!entry.is_present())
+                continue;
+            if (freeFrames)
+                Manager::instance().free_physical_block(entry.get_frame());
+            entry.clear();
+        }
+    }
+
+    AddressSpaceStatistics Manager::get_address_space_statistics(VirtualAddressSpace& addressSpace)
+    {
+        AddressSpaceStatistics statistics = {
+            .residentPages = 0,
+            .pageTablePages = 1
+        };
+        // The tables may be changed by the task owning them, so take a consistent snapshot.
+        InterruptDisabler disabler;
+        static_cast<PML4Table*>(VirtualAddress(addressSpace.get_physical_address()).get())->collect_statistics(statistics);
+        return statistics;
+    }
+
+    void PML4Table::collect_statistics(AddressSpaceStatistics& statistics)
+    {
+        for (int i = 0; i < ENTRIES_PER_TABLE / 2; i++) {
+            auto& entry = m_entries[i];
+            if (!entry.is_present())
+                continue;
+            statistics.pageTablePages++;
+            auto pageDirectoryPointerTable = static_cast<PageDirectoryPointerTable*>(VirtualAddress(PhysicalAddress(entry.get_frame())).get());
+            pageDirectoryPointerTable->collect_statistics(statistics);
+        }
+    }
+
+    void PageDirectoryPointerTable::collect_statistics(AddressSpaceStatistics& statistics)
+    {
+        for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+            auto& entry = m_entries[i];
+            if (!entry.is_present())
+                continue;
+            if (entry.get_flag(GenericEntry::Flag::PAGE_SIZE)) {
+                statistics.residentPages += PAGE_1GiB / PAGE_4KiB;
+                continue;
+            }
+            statistics.pageTablePages++;
+            auto pageDirectoryTable = static_cast<PageDirectoryTable*>(VirtualAddress(PhysicalAddress(entry.get_frame())).get());
+            pageDirectoryTable->collect_statistics(statistics);
+        }
+    }
+
+    void PageDirectoryTable::collect_statistics(AddressSpaceStatistics& statistics)
+    {
+        for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+            auto& entry = m_entries[i];
+            if (!entry.is_present())
+                continue;
+            if (entry.get_flag(GenericEntry::Flag::PAGE_SIZE)) {
+                statistics.residentPages += PAGE_2MiB / PAGE_4KiB;
+                continue;
+            }
+            statistics.pageTablePages++;
+            auto pageTable = static_cast<PageTable*>(VirtualAddress(PhysicalAddress(entry.get_frame())).get());
+            pageTable->collect_statistics(statistics);
+        }
+    }
+
+    void PageTable::collect_statistics(AddressSpaceStatistics& statistics)
+    {
+        for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+            if (m_entries[i].is_present())
+                statistics.residentPages++;
+        }
+    }
+
+#ifdef XPOS_MEMORY_LEAK_CHECK
+    void Manager::check_address_space_teardown()
+    {
+        auto baseline = get_free_physical_block_count();
+        {
+            auto addressSpace = create_virtual_address_space();
+
+            // Private pages spread across several page tables.
+            for (uint64_t address = 0x400000; address < 0x400000 + 4 * PAGE_2MiB; address += PAGE_2MiB / 4)
+                alloc_page(VirtualMemoryAllocationRequest(VirtualAddress(address), true, true), addressSpace);
+
+            // A frame shared with another owner, which must survive the teardown.
+            auto shared = alloc_physical_block();
+            reference_physical_block(shared);
+            request_virtual_map({ .physicalAddress = shared, .virtualAddress = VirtualAddress(0x10000000), .allowWrite = true, .allowUserAccess = true }, addressSpace);
+
+            // Device memory above the allocator's range, which must be left alone.
+            request_virtual_map({ .physicalAddress = PhysicalAddress(m_physicalBitmap.size() * PHYSICAL_BLOCK_SIZE), .virtualAddress = VirtualAddress(0x20000000), .allowWrite = true, .allowUserAccess = true }, addressSpace);
+
+            destroy_virtual_address_space(addressSpace);
+            KERNEL_ASSERT(get_free_physical_block_count() == baseline - 1);
+            free_physical_block(shared);
+        }
+        KERNEL_ASSERT(get_free_physical_block_count() == baseline);
     }
+#endif
 } 
\ No newline at end of file
@@ -55,6 +55,23 @@ struct MappedRegion
 
 class Manager;
 
+struct PhysicalMemoryStatistics
+{
+    // 4KiB blocks of usable RAM reported by the bootloader.
+    uint64_t totalBlocks;
+    uint64_t freeBlocks;
+    // Blocks holding page tables of any address space, including top level tables.
+    uint64_t pageTableBlocks;
+};
+
+struct AddressSpaceStatistics
+{
+    // 4KiB pages mapped in the lower half, counting large pages by their size.
+    uint64_t residentPages;
+    // Tables needed to map the lower half.
+    uint64_t pageTablePages;
+};
+
 /**
  * Represents a unique address space, a many-to-one mapping from virtual (logical) addresses
  * to physical memory addresses.
@@ -63,7 +80,7 @@ class VirtualAddressSpace
 {
 friend class Manager;
 public:
-    VirtualAddressSpace(PhysicalAddress topLevelTable)
+    constexpr VirtualAddressSpace(PhysicalAddress topLevelTable)
     : m_physicalAddress(topLevelTable) {}
     PhysicalAddress get_physical_address()
     {
@@ -71,6 +88,13 @@ public:
     }
 protected:
     PhysicalAddress m_physicalAddress;
+    /**
+     * The process-context identifier tags this address space's TLB entries, so they
+     * survive switches to other address spaces. It is only valid while the generation
+     * matches the manager's current PCID generation.
+     */
+    uint16_t m_pcid = 0;
+    uint64_t m_pcidGeneration = 0;
 };
 
 struct VirtualMemoryAllocationRequest
@@ -102,6 +126,11 @@ struct VirtualMemoryMapRequest
     bool allowWrite = false;
     bool allowUserAccess = false;
     PageSize pageSize = PAGE_4KiB;
+    bool global = false;
+    // Maps the page read-only, giving the address space a private copy on the first write.
+    bool copyOnWrite = false;
+    // The frame was allocated for this mapping alone, rather than shared with a file, device or another task.
+    bool anonymous = false;
 };
 
 struct VirtualMemoryUnmapRequest
@@ -122,12 +151,17 @@ class GenericEntry
     static constexpr uint64_t ENTRY_FRAME_MASK = 0xFFFFFFFFFFFFF000;
     uint64_t m_entry = 0;
 public:
-    enum Flag : uint8_t
+    enum Flag : uint64_t
     {
         PRESENT = 0x1,
         WRITEABLE = 0x2,
         USER_ACCESS = 0x4,
-        PAGE_SIZE = 0x80
+        PAGE_SIZE = 0x80,
+        GLOBAL = 0x100,
+        // Ignored by the processor, so available to mark pages that are copied on write.
+        COPY_ON_WRITE = 0x200,
+        // Also ignored, and marks pages backed by anonymous memory private to the address space.
+        ANONYMOUS = 0x400
     };
     bool get_flag(Flag flag) { return m_entry & flag; }
     void set_flag(Flag flag) { m_entry |= flag; }
@@ -182,6 +216,18 @@ public:
     void request_virtual_map(VirtualMemoryMapRequest request);
     void request_virtual_unmap(VirtualMemoryUnmapRequest request);
     PhysicalAddress get_physical_address(VirtualAddress virtualAddress);
+    /**
+     * Returns the entry mapping a 4KiB page, or nullptr if the address is not mapped by one.
+     */
+    GenericEntry* get_page_entry(VirtualAddress virtualAddress);
+    /**
+     * Frees every table below this one, and the frames mapped in the lower (user) half.
+     */
+    void destroy();
+    /**
+     * Counts the pages and tables mapping the lower (user) half.
+     */
+    void collect_statistics(AddressSpaceStatistics& statistics);
 private:
     GenericEntry* get_entry(VirtualAddress virtualAddress)
     {
@@ -197,6 +243,9 @@ public:
     void request_virtual_map(VirtualMemoryMapRequest request);
     bool request_virtual_unmap(VirtualMemoryUnmapRequest request);
     PhysicalAddress get_physical_address(VirtualAddress virtualAddress);
+    GenericEntry* get_page_entry(VirtualAddress virtualAddress);
+    void destroy(bool freeFrames);
+    void collect_statistics(AddressSpaceStatistics& statistics);
 private:
     GenericEntry* get_entry(VirtualAddress virtualAddress)
     {
@@ -211,6 +260,9 @@ public:
     void request_virtual_map(VirtualMemoryMapRequest request);
     bool request_virtual_unmap(VirtualMemoryUnmapRequest request);
     PhysicalAddress get_physical_address(VirtualAddress virtualAddress);
+    GenericEntry* get_page_entry(VirtualAddress virtualAddress);
+    void destroy(bool freeFrames);
+    void collect_statistics(AddressSpaceStatistics& statistics);
 private:
     GenericEntry* get_entry(VirtualAddress virtualAddress)
     {
@@ -225,6 +277,9 @@ public:
     void request_virtual_map(VirtualMemoryMapRequest request);
     bool request_virtual_unmap(VirtualMemoryUnmapRequest request);
     PhysicalAddress get_physical_address(VirtualAddress virtualAddress);
+    GenericEntry* get_page_entry(VirtualAddress virtualAddress);
+    void destroy(bool freeFrames);
+    void collect_statistics(AddressSpaceStatistics& statistics);
 private:
     GenericEntry* get_entry(VirtualAddress virtualAddress)
     {
@@ -268,9 +323,46 @@ public:
     */
     PhysicalAddress alloc_physical_block();
     /**
-     * Frees a previously allocated physical block.
+     * Allocates a physically contiguous run of 4KiB blocks, starting on the given alignment.
+     * Each block is reference counted separately, so the run can be freed block by block.
+     * 
+     * @return the physical address of the first block, or 0 if no such run is free.
+    */
+    PhysicalAddress alloc_physical_blocks(std::size_t count, std::size_t alignment = PHYSICAL_BLOCK_SIZE);
+    /**
+     * Drops a reference to a previously allocated physical block, freeing it when
+     * no references remain. Blocks not owned by the allocator, such as device memory, are ignored.
     */
     void free_physical_block(PhysicalAddress block);
+    /**
+     * Takes an additional reference to a previously allocated physical block,
+     * for when it is mapped in more than one place.
+    */
+    void reference_physical_block(PhysicalAddress block);
+    /**
+     * Drops a reference to every 4KiB block in a contiguous region.
+    */
+    void free_physical_blocks(PhysicalAddress base, uint64_t size);
+    /**
+     * Returns the number of free 4KiB physical blocks.
+    */
+    std::size_t get_free_physical_block_count();
+    /**
+     * Allocates a physical block for a page table, which is accounted for separately.
+    */
+    PhysicalAddress alloc_table_block();
+    /**
+     * Frees a physical block previously allocated for a page table.
+    */
+    void free_table_block(PhysicalAddress block);
+    /**
+     * Returns a snapshot of the physical memory counters.
+    */
+    PhysicalMemoryStatistics get_statistics();
+    /**
+     * Walks the lower half of an address space to count the pages and tables mapping it.
+    */
+    AddressSpaceStatistics get_address_space_statistics(VirtualAddressSpace& addressSpace);
     /**
      * Maps a virtual page in an address space.
     */
@@ -284,7 +376,7 @@ public:
     */
     void alloc_page(VirtualMemoryAllocationRequest request, VirtualAddressSpace& addressSpace = instance().get_main_address_space());
     /**
-     * Frees a previously allocated 4KiB page in an address space.
+     * Unmaps a 4KiB page in an address space and drops a reference to its physical block.
     */
     void free_page(VirtualMemoryFreeRequest request, VirtualAddressSpace& addressSpace = instance().get_main_address_space());
     /**
@@ -292,13 +384,66 @@ public:
     */
     PhysicalAddress get_physical_address(VirtualAddress virtualAddress, VirtualAddressSpace& addressSpace = instance().get_main_address_space());
 
+    /**
+     * Maps a 4KiB page of the main address space into another address space after a
+     * fault, with the same frame and the same write and global flags.
+     *
+     * @return false if the page is not mapped in the main address space.
+    */
+    bool mirror_main_page(VirtualAddress virtualAddress, VirtualAddressSpace& addressSpace);
+
+    /**
+     * Gives an address space its own copy of a copy-on-write page after a write fault.
+     * 
+     * @return false if the page is not copy-on-write, so the fault is not resolved.
+    */
+    bool resolve_copy_on_write(VirtualAddress virtualAddress, VirtualAddressSpace& addressSpace);
+
+    /**
+     * @return whether the range lies wholly in the lower half, where user mappings live.
+    */
+    static bool is_user_range(VirtualAddress start, std::size_t count)
+    {
+        auto begin = reinterpret_cast<uint64_t>(start.get());
+        return begin <= LOWER_HALF_END && count <= LOWER_HALF_END - begin;
+    }
+
+    /**
+     * Checks that the kernel can write to a buffer passed in by userspace. With CR0.WP set,
+     * a kernel write to a read-only page faults, so such buffers must be refused up front.
+     * Copy-on-write pages count as writeable, as the fault resolves them.
+     *
+     * @return false if the range is not in user space, or any page of it is mapped
+     * read-only or for the kernel alone.
+    */
+    bool is_writeable_user_range(VirtualAddress start, std::size_t count, VirtualAddressSpace& addressSpace);
+
+    /**
+     * Takes a reference to the frame behind a 4KiB user page so it can be lent to
+     * another address space. The page becomes copy-on-write, so later writes by its
+     * owner do not change the lent frame. The address space must be the current one.
+     *
+     * @return the frame, or a null address if the page is not a present, private
+     * anonymous user page.
+    */
+    PhysicalAddress lend_page(VirtualAddress page, VirtualAddressSpace& addressSpace);
+
+    /**
+     * Maps a lent frame copy-on-write over a present, writeable, private anonymous 4KiB user page,
+     * taking over the caller's reference and releasing the frame it replaces.
+     * The address space must be the current one.
+     *
+     * @return false if the page cannot be replaced, leaving the reference with the caller.
+    */
+    bool accept_lent_page(PhysicalAddress frame, VirtualAddress page, VirtualAddressSpace& addressSpace);
+
     /**
      * Creates a new virtual address space and allocates a top level table.
      * Physical memory is mapped in the higher half by default.
     */
     VirtualAddressSpace create_virtual_address_space()
     {
-        auto physicalAddress = alloc_physical_block();
+        auto physicalAddress = alloc_table_block();
         auto addressSpace = VirtualAddressSpace(physicalAddress);
         memset(VirtualAddress(physicalAddress).get(), 0, sizeof(PML4Table));
         auto size = 4 * PAGE_1GiB;
@@ -316,12 +461,25 @@ public:
     }
 
     /**
-     * Destroys a new virtual address space. This does not unmap mapped pages in the address space. 
+     * Returns the value to load into CR3 to switch to an address space.
+     * If PCIDs are enabled, the address space is assigned a PCID when it does not
+     * hold one from the current generation, and the load does not flush the TLB.
     */
-    void destroy_virtual_address_space(VirtualAddressSpace& addressSpace)
-    {
-        free_physical_block(addressSpace.get_physical_address().get());
-    }
+    uint64_t get_address_space_switch_value(VirtualAddressSpace& addressSpace);
+
+    /**
+     * Destroys a virtual address space, freeing its page tables and dropping a reference to
+     * each frame mapped in the lower half. The address space must not be loaded.
+    */
+    void destroy_virtual_address_space(VirtualAddressSpace& addressSpace);
+
+#ifdef XPOS_MEMORY_LEAK_CHECK
+    /**
+     * Builds and destroys a scratch address space, asserting that the number of
+     * free physical blocks returns to its baseline.
+    */
+    void check_address_space_teardown();
+#endif
 
     VirtualAddressSpace& get_main_address_space()
     {
@@ -336,15 +494,20 @@ public:
 
     static Manager& instance()
     {
-        static Manager instance;
-        return instance;
+        return m_instance;
     }
 private:
-    Manager() :m_virtualAddressSpace(static_cast<uint64_t>(0)) {}
+    constexpr Manager() :m_virtualAddressSpace(static_cast<uint64_t>(0)) {}
+    static Manager m_instance;
 public:
     Manager(Manager const&) = delete;
     void operator=(Manager const&) = delete;
 private:
+    /**
+     * @return the entry of a present, private anonymous 4KiB page in the lower half, or nullptr.
+    */
+    GenericEntry* get_private_user_page_entry(VirtualAddress page, VirtualAddressSpace& addressSpace);
+
     class PhysicalBitmap
     {
     public:
@@ -362,6 +525,18 @@ private:
             }
         }
 
+        std::size_t size() const
+        {
+            return m_bitmapSize * CHAR_BIT;
+        }
+
+        bool is_set(std::size_t bit) const
+        {
+            if (bit >= m_bitmapSize * CHAR_BIT)
+                return true;
+            return m_bitmap[bit / CHAR_BIT] & (1 << (bit % CHAR_BIT));
+        }
+
         void set(std::size_t bit)
         {
             if (bit >= m_bitmapSize * CHAR_BIT)
@@ -376,6 +551,29 @@ private:
             m_bitmap[bit / CHAR_BIT] &= ~(1 << (bit % CHAR_BIT));
         }
 
+        /**
+         * Finds a run of unset bits starting at a multiple of the alignment, returning 0 if there is none.
+         */
+        std::size_t find_unset_run(std::size_t count, std::size_t alignment)
+        {
+            std::size_t bits = size();
+            // Bit 0 is always set, so it doubles as the failure value.
+            std::size_t start = alignment;
+            while (start + count <= bits) {
+                if (start % CHAR_BIT == 0 && m_bitmap[start / CHAR_BIT] == 0xFF) {
+                    start = BYTE_ALIGN_UP(start + CHAR_BIT, alignment);
+                    continue;
+                }
+                std::size_t length = 0;
+                while (length < count && !is_set(start + length))
+                    length++;
+                if (length == count)
+                    return start;
+                start = BYTE_ALIGN_UP(start + length + 1, alignment);
+            }
+            return 0;
+        }
+
         std::size_t first_unset()
         {
             for (std::size_t i = 0; i < m_bitmapSize; i++) {
@@ -389,7 +587,7 @@ private:
             }
             return 0;
         }
-        PhysicalBitmap() {}
+        constexpr PhysicalBitmap() {}
     private:
         uint8_t* m_bitmap = 0;
         std::size_t m_bitmapSize = 0;
@@ -399,10 +597,46 @@ private:
     };
     static constexpr std::size_t PHYSICAL_BLOCK_SIZE = 0x1000;
     static constexpr VirtualAddress PHYSICAL_MEM_MAP_VIRTUAL_ADDRESS = 0xFFFFFF8000000000;
-    std::size_t m_physicalMemorySize;
+    static constexpr uint64_t HIGHER_HALF_START = 0xFFFF800000000000;
+    static constexpr uint64_t LOWER_HALF_END = 0x0000800000000000;
+    static constexpr uint64_t CR3_FRAME_MASK = 0x000FFFFFFFFFF000;
+    static constexpr uint64_t CR3_NO_FLUSH = 1ull << 63;
+    static constexpr uint64_t CR0_WP = 1 << 16;
+    static constexpr uint64_t CR4_PGE = 1 << 7;
+    static constexpr uint64_t CR4_PCIDE = 1 << 17;
+    static constexpr uint32_t CPUID_ECX_PCID = 1 << 17;
+    // PCID 0 is reserved for the main address space and the kernel tasks sharing it.
+    static constexpr uint16_t FIRST_PCID = 1;
+    static constexpr uint16_t MAX_PCID = 4095;
+    std::size_t m_physicalMemorySize = 0;
     PhysicalBitmap m_physicalBitmap;
+    // One count per physical block. Blocks with a count of zero are not owned by the allocator.
+    uint16_t* m_frameReferenceCounts = nullptr;
+    std::size_t m_freePhysicalBlockCount = 0;
+    std::size_t m_totalPhysicalBlockCount = 0;
+    std::size_t m_pageTableBlockCount = 0;
     VirtualAddressSpace m_virtualAddressSpace;
-    Spinlock m_physicalBitmapLock;
+    Spinlock m_physicalBitmapLock{LOCK_CLASS("Memory::Manager::m_physicalBitmapLock")};
+    bool m_pcidEnabled = false;
+    uint16_t m_nextPcid = FIRST_PCID;
+    uint64_t m_pcidGeneration = 1;
+    Spinlock m_pcidLock{LOCK_CLASS("Memory::Manager::m_pcidLock")};
+
+    /**
+     * Enables global pages and, if the processor supports them, process-context identifiers.
+     */
+    void enable_tlb_extensions();
+
+    /**
+     * Ensures stale translations of an address space that is not currently loaded
+     * are not used when it is switched to again.
+     */
+    void invalidate_inactive_address_space(VirtualAddressSpace& addressSpace);
+
+    /**
+     * Flush every TLB entry, including global entries and entries of all PCIDs.
+     */
+    void flush_tlb_all();
 
     /**
      * Flush the Translation Lookaside Buffer for a given virtual address.
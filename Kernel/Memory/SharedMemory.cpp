@@ -19,6 +19,8 @@
 #include "API/SharedMemory.h"
 #include "Common/Hashmap.h"
 #include "Common/String.h"
+#include "Common/Vector.h"
+#include "Memory/AddressSpace.h"
 #include "Memory/SharedMemory.h"
 #include "Tasks/TaskManager.h"
 #include "Pipes/Pipe.h"
@@ -28,21 +30,32 @@ namespace Memory::Shared
 
 namespace
 {
+    /**
+     * A physically contiguous run of frames backing part of a shared memory object.
+     */
+    struct Extent
+    {
+        PhysicalAddress base;
+        std::size_t length;
+    };
+
+    using VASReference = Common::AutomaticReferenceCountable<RegionableVirtualAddressSpace>;
+
     class MemoryMap
     {
     public:
-        MemoryMap(MappedRegion region, VirtualAddressSpace vas)
+        MemoryMap(MappedRegion region, VASReference vas)
             : MemoryMap(region, vas, ARCBlock(PhysicalMemoryControlBlock(region.length())))
         {}
 
-        MemoryMap(MappedRegion region, VirtualAddressSpace vas, MemoryMap& sharedWith)
+        MemoryMap(MappedRegion region, VASReference vas, MemoryMap& sharedWith)
             : MemoryMap(region, vas, sharedWith.m_physMem)
         {}
 
         MemoryMap(const MemoryMap& other) = default;
         MemoryMap(MemoryMap&& other) = default;
 
-        static MemoryMap reuse_map(MappedRegion region, VirtualAddressSpace vas, MemoryMap& otherMap)
+        static MemoryMap reuse_map(MappedRegion region, VASReference vas, MemoryMap& otherMap)
         {
             return MemoryMap(region, vas, otherMap.m_physMem);
         }
@@ -52,6 +65,11 @@ namespace
             return m_region.length();
         }
 
+        void* start() const
+        {
+            return m_region.start;
+        }
+
         friend void swap(MemoryMap& a, MemoryMap& b)
         {
             using std::swap;
@@ -64,29 +82,80 @@ namespace
         {
             if (!m_physMem.has_value())
                 return;
-            auto regionStart = reinterpret_cast<uint64_t>(m_region.start);
-            auto regionEnd = reinterpret_cast<uint64_t>(m_region.end);
+            unmap();
+            (*m_vas).extract_region(m_region.start);
+        }
 
-            for (auto ptr = regionStart; ptr < regionEnd; ptr += PAGE_4KiB) {
-                auto req = Memory::VirtualMemoryUnmapRequest(VirtualAddress(ptr));
-                Memory::Manager::instance().request_virtual_unmap(req, m_vas);
+        /**
+         * Objects of at least 2MiB are placed on 2MiB boundaries, so their 2MiB extents
+         * can be mapped with large pages.
+         */
+        static uint64_t region_alignment(std::size_t length)
+        {
+            return length >= PAGE_2MiB ? PAGE_2MiB : PAGE_4KiB;
+        }
+
+        /**
+         * Grows or shrinks the frames shared by every mapping of the object. Each mapping
+         * must be unmapped beforehand and remapped afterwards.
+         */
+        void resize_backing(std::size_t alignedLength)
+        {
+            (**m_physMem).resize(alignedLength);
+        }
+
+        /**
+         * Unmaps the object, dropping this mapping's reference to each frame.
+         */
+        void unmap()
+        {
+            auto regionPtr = reinterpret_cast<uint64_t>(m_region.start);
+            for (auto extent : (**m_physMem).get_extents()) {
+                if (is_huge_mapping(extent, regionPtr)) {
+                    auto req = Memory::VirtualMemoryUnmapRequest(VirtualAddress(regionPtr));
+                    req.pageSize = PAGE_2MiB;
+                    Memory::Manager::instance().request_virtual_unmap(req, *m_vas);
+                    Memory::Manager::instance().free_physical_blocks(extent.base, extent.length);
+                    regionPtr += extent.length;
+                    continue;
+                }
+                for (std::size_t offset = 0; offset < extent.length; offset += PAGE_4KiB) {
+                    auto req = Memory::VirtualMemoryFreeRequest(VirtualAddress(regionPtr));
+                    Memory::Manager::instance().free_page(req, *m_vas);
+                    regionPtr += PAGE_4KiB;
+                }
             }
         }
 
+        /**
+         * Maps the object at its new length, in place if the region can grow or shrink
+         * without overlapping another, or otherwise at a new address.
+         */
+        void remap(std::size_t alignedLength)
+        {
+            auto& vas = *m_vas;
+            if (vas.resize_region(m_region.start, alignedLength)) {
+                m_region.end = reinterpret_cast<uint8_t*>(m_region.start) + alignedLength;
+            } else {
+                vas.extract_region(m_region.start);
+                m_region = vas.acquire_available_region(alignedLength, region_alignment(alignedLength));
+            }
+            map();
+        }
+
     private:
         class PhysicalMemoryControlBlock
         {
         public:
             PhysicalMemoryControlBlock(std::size_t alignedLength)
             {
-                for (uint64_t i = 0; i < alignedLength; i += PAGE_4KiB)
-                    m_physicalPages.push_back(Manager::instance().alloc_physical_block());
+                grow(alignedLength);
             }
 
             ~PhysicalMemoryControlBlock()
             {
-                for (auto page : m_physicalPages)
-                    Manager::instance().free_physical_block(page);
+                for (auto& extent : m_extents)
+                    Manager::instance().free_physical_blocks(extent.base, extent.length);
             }
 
             PhysicalMemoryControlBlock(const PhysicalMemoryControlBlock&) = delete;
@@ -100,71 +169,177 @@ namespace
             friend void swap(PhysicalMemoryControlBlock& a, PhysicalMemoryControlBlock& b)
             {
                 using std::swap;
-                swap(a.m_physicalPages, b.m_physicalPages);
+                swap(a.m_extents, b.m_extents);
+                swap(a.m_length, b.m_length);
+            }
+
+            const Common::Vector<Extent>& get_extents() const
+            {
+                return m_extents;
             }
 
-            const Common::List<PhysicalAddress>& get_physical_pages() const
+            void resize(std::size_t alignedLength)
             {
-                return m_physicalPages;
+                if (alignedLength > m_length)
+                    grow(alignedLength - m_length);
+                else
+                    shrink(m_length - alignedLength);
             }
 
         private:
-            Common::List<PhysicalAddress> m_physicalPages;
+            void grow(std::size_t alignedLength)
+            {
+                auto& manager = Manager::instance();
+                std::size_t remaining = alignedLength / PAGE_4KiB;
+                m_length += alignedLength;
+                // Prefer 2MiB runs, then the largest run we can find of what is left,
+                // so large objects need few extents and few page table entries.
+                while (remaining) {
+                    if (remaining >= BLOCKS_PER_2MiB) {
+                        auto base = manager.alloc_physical_blocks(BLOCKS_PER_2MiB, PAGE_2MiB);
+                        if (base.get()) {
+                            m_extents.push_back({ base, PAGE_2MiB });
+                            remaining -= BLOCKS_PER_2MiB;
+                            continue;
+                        }
+                    }
+
+                    auto count = remaining < BLOCKS_PER_2MiB ? remaining : BLOCKS_PER_2MiB;
+                    auto base = PhysicalAddress(static_cast<uint64_t>(0));
+                    while (count > 1 && !(base = manager.alloc_physical_blocks(count)).get())
+                        count /= 2;
+                    if (!base.get())
+                        base = manager.alloc_physical_block();
+                    m_extents.push_back({ base, count * PAGE_4KiB });
+                    remaining -= count;
+                }
+            }
+
+            void shrink(std::size_t alignedLength)
+            {
+                m_length -= alignedLength;
+                while (alignedLength) {
+                    auto& extent = m_extents.back();
+                    if (extent.length <= alignedLength) {
+                        Manager::instance().free_physical_blocks(extent.base, extent.length);
+                        alignedLength -= extent.length;
+                        m_extents.pop_back();
+                        continue;
+                    }
+                    extent.length -= alignedLength;
+                    auto tail = reinterpret_cast<uint64_t>(extent.base.get()) + extent.length;
+                    Manager::instance().free_physical_blocks(PhysicalAddress(tail), alignedLength);
+                    alignedLength = 0;
+                }
+            }
+
+            static constexpr std::size_t BLOCKS_PER_2MiB = PAGE_2MiB / PAGE_4KiB;
+            Common::Vector<Extent> m_extents;
+            std::size_t m_length = 0;
         };
 
         using ARCBlock = Common::AutomaticReferenceCountable<PhysicalMemoryControlBlock>;
 
-        MemoryMap(MappedRegion region, VirtualAddressSpace vas, Common::Optional<ARCBlock> ref)
+        static bool is_huge_mapping(Extent extent, uint64_t virtualAddress)
+        {
+            return extent.length == PAGE_2MiB
+                && CHECK_ALIGN(reinterpret_cast<uint64_t>(extent.base.get()), PAGE_2MiB)
+                && CHECK_ALIGN(virtualAddress, PAGE_2MiB);
+        }
+
+        MemoryMap(MappedRegion region, VASReference vas, Common::Optional<ARCBlock> ref)
             : m_region(region)
             , m_physMem(ref)
             , m_vas(vas)
         {
-            auto regionPtr = reinterpret_cast<uint64_t>(region.start);
             if (!m_physMem.has_value())
                 return;
-            
-            for (auto page : (**m_physMem).get_physical_pages()) {
+            map();
+        }
+
+        /**
+         * Maps the object at the start of the region, taking a reference to each frame.
+         */
+        void map()
+        {
+            auto& manager = Memory::Manager::instance();
+            auto regionPtr = reinterpret_cast<uint64_t>(m_region.start);
+            for (auto extent : (**m_physMem).get_extents()) {
+                auto base = reinterpret_cast<uint64_t>(extent.base.get());
+                for (std::size_t offset = 0; offset < extent.length; offset += PAGE_4KiB)
+                    manager.reference_physical_block(PhysicalAddress(base + offset));
+
                 Memory::VirtualMemoryMapRequest req = {
-                    .physicalAddress = page,
+                    .physicalAddress = extent.base,
                     .virtualAddress = regionPtr,
                     .allowWrite = true,
                     .allowUserAccess = true
                 };
 
-                Memory::Manager::instance().request_virtual_map(req, m_vas);
-                regionPtr += PAGE_4KiB;
+                if (is_huge_mapping(extent, regionPtr)) {
+                    req.pageSize = PAGE_2MiB;
+                    manager.request_virtual_map(req, *m_vas);
+                    regionPtr += extent.length;
+                    continue;
+                }
+
+                for (std::size_t offset = 0; offset < extent.length; offset += PAGE_4KiB) {
+                    req.physicalAddress = PhysicalAddress(base + offset);
+                    req.virtualAddress = regionPtr;
+                    manager.request_virtual_map(req, *m_vas);
+                    regionPtr += PAGE_4KiB;
+                }
             }
         }
 
         MappedRegion m_region;
         Common::Optional<ARCBlock> m_physMem;
-        VirtualAddressSpace m_vas;
+        VASReference m_vas;
+    };
+
+    struct SharedObject
+    {
+        Common::List<MemoryMap> mappings;
+        Pipes::EventListenerList listeners;
     };
 
     struct MapIdentifier
     {
-        Common::HashableString str;
+        Common::String str;
+        SharedObject* object;
         Common::List<MemoryMap>::Iterator mapIt;
     };
 
-    Common::Hashmap<Common::HashableString, Common::List<MemoryMap>>* sharedMaps;
+    Common::Hashmap<Common::String, SharedObject*>* sharedMaps;
+    Mutex sharedMapsLock;
     Pipes::DeviceOperations deviceOperations;
+    Statistics statistics = {};
+}
+
+Statistics get_statistics()
+{
+    InterruptDisabler disabler;
+    return statistics;
 }
 
 void initialise()
 {
-    sharedMaps = new Common::Hashmap<Common::HashableString, Common::List<MemoryMap>>();
+    sharedMaps = new Common::Hashmap<Common::String, SharedObject*>();
     deviceOperations = {
         .open = open,
-        .close = close
+        .close = close,
+        .read = read,
+        .write = write,
+        .notify = notify,
+        .denotify = denotify
     };
     Pipes::register_device("shared_mem", &deviceOperations);
 }
 
 bool open(void* with, int flags, void*& deviceSpecific)
 {
-
     using namespace xpOS::API::SharedMemory;
+    LockAcquirer l(sharedMapsLock);
     LinkRequest* linkRequest = static_cast<LinkRequest*>(with);
     auto mapIt = sharedMaps->find(linkRequest->str);
     
@@ -172,30 +347,35 @@ bool open(void* with, int flags, void*& deviceSpecific)
         if (mapIt != sharedMaps->end())
             return false;
         
-        mapIt = sharedMaps->insert({linkRequest->str, {}}).first;
+        mapIt = sharedMaps->insert({linkRequest->str, new SharedObject()}).first;
     } else {
         if (mapIt == sharedMaps->end())
             return false;
         
-        Common::List<MemoryMap>& mappingList = mapIt->second;
-        linkRequest->length = mappingList.front().length();
+        linkRequest->length = mapIt->second->mappings.front().length();
     }
 
     auto task = Task::Manager::instance().get_current_task();
     auto& vas = (*task->tlTable);
 
-    Common::List<MemoryMap>& mappingList = mapIt->second;
+    Common::List<MemoryMap>& mappingList = mapIt->second->mappings;
 
-    MappedRegion region = vas.acquire_available_region(BYTE_ALIGN_UP(linkRequest->length, 4096));
+    auto length = BYTE_ALIGN_UP(linkRequest->length, PAGE_4KiB);
+    MappedRegion region = vas.acquire_available_region(length, MemoryMap::region_alignment(length));
     linkRequest->mappedTo = region.start;
 
-    if (flags & Flags::CREATE)
-        mappingList.emplace_back(region, vas);
-    else
-        mappingList.emplace_back(region, vas, mappingList.front());
+    if (flags & Flags::CREATE) {
+        mappingList.emplace_back(region, task->tlTable);
+        statistics.objects++;
+        statistics.bytes += region.length();
+    } else {
+        mappingList.emplace_back(region, task->tlTable, mappingList.front());
+    }
+    statistics.attachments++;
     
     deviceSpecific = new MapIdentifier {
         .str = linkRequest->str,
+        .object = mapIt->second,
         .mapIt = --mappingList.end()
     };
     return true;
@@ -204,21 +384,87 @@ bool open(void* with, int flags, void*& deviceSpecific)
 
 void close(void*& deviceSpecific)
 {
+    LockAcquirer l(sharedMapsLock);
     auto* dev = reinterpret_cast<MapIdentifier*>(deviceSpecific);
     auto mapIt = sharedMaps->find(dev->str);
 
     if (mapIt == sharedMaps->end())
         return;
 
-    Common::List<MemoryMap>& mappingList = mapIt->second;
+    Common::List<MemoryMap>& mappingList = mapIt->second->mappings;
+    auto length = dev->mapIt->length();
 
     mappingList.erase(dev->mapIt);
+    statistics.attachments--;
 
     if (mappingList.size() == 0) {
+        delete mapIt->second;
         sharedMaps->erase(mapIt);
+        statistics.objects--;
+        statistics.bytes -= length;
     }
 
     delete dev;
 }
 
+std::size_t read(std::size_t offset, std::size_t count, void* buf, void*& deviceSpecific)
+{
+    using namespace xpOS::API::SharedMemory;
+    if (count < sizeof(MappingInfo))
+        return 0;
+
+    LockAcquirer l(sharedMapsLock);
+    auto* dev = reinterpret_cast<MapIdentifier*>(deviceSpecific);
+    *static_cast<MappingInfo*>(buf) = {
+        .mappedTo = dev->mapIt->start(),
+        .length = dev->mapIt->length()
+    };
+    return sizeof(MappingInfo);
+}
+
+std::size_t write(std::size_t offset, std::size_t count, const void* buf, void*& deviceSpecific)
+{
+    using namespace xpOS::API::SharedMemory;
+    if (count != sizeof(ResizeRequest))
+        return 0;
+
+    uint64_t length = static_cast<const ResizeRequest*>(buf)->length;
+    length = BYTE_ALIGN_UP(length, PAGE_4KiB);
+    if (length == 0)
+        return 0;
+
+    LockAcquirer l(sharedMapsLock);
+    auto* dev = reinterpret_cast<MapIdentifier*>(deviceSpecific);
+    auto& mappingList = dev->object->mappings;
+    auto oldLength = mappingList.front().length();
+    if (length == oldLength)
+        return count;
+
+    // Every mapping drops its frames first, so the backing can be split or extended freely.
+    // Frames that are kept stay alive through the control block, so their contents survive.
+    for (auto& mapping : mappingList)
+        mapping.unmap();
+    mappingList.front().resize_backing(length);
+    for (auto& mapping : mappingList)
+        mapping.remap(length);
+
+    statistics.bytes += length;
+    statistics.bytes -= oldLength;
+    dev->object->listeners.notify(EventTypes::RESIZED);
+    return count;
+}
+
+Pipes::EventListenerList::Receipt notify(void* listener, Pipes::raise_events_callback raise_event, Pipes::EventTypeMask& current, void*& deviceSpecific)
+{
+    auto* dev = reinterpret_cast<MapIdentifier*>(deviceSpecific);
+    current = 0;
+    return dev->object->listeners.add(listener, raise_event);
+}
+
+void denotify(Pipes::EventListenerList::Receipt receipt, void*& deviceSpecific)
+{
+    auto* dev = reinterpret_cast<MapIdentifier*>(deviceSpecific);
+    dev->object->listeners.remove(receipt);
+}
+
 }
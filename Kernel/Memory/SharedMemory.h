@@ -21,14 +21,30 @@
 
 #include <cstdint>
 
+#include "Pipes/EventListenerList.h"
+
 namespace Memory
 {
 
 namespace Shared
 {
+    struct Statistics
+    {
+        // Named objects that are currently attached to at least one address space.
+        uint64_t objects;
+        uint64_t attachments;
+        // Bytes of physical memory backing the objects.
+        uint64_t bytes;
+    };
+
     void initialise();
+    Statistics get_statistics();
     bool open(void* with, int flags, void*& deviceSpecific);
     void close(void*& deviceSpecific);
+    std::size_t read(std::size_t offset, std::size_t count, void* buf, void*& deviceSpecific);
+    std::size_t write(std::size_t offset, std::size_t count, const void* buf, void*& deviceSpecific);
+    Pipes::EventListenerList::Receipt notify(void* listener, Pipes::raise_events_callback raise_event, Pipes::EventTypeMask& current, void*& deviceSpecific);
+    void denotify(Pipes::EventListenerList::Receipt receipt, void*& deviceSpecific);
 };
 
 }
@@ -0,0 +1,167 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "Memory/KernelHeap.h"
+#include "Memory/MemoryManager.h"
+#include "Memory/SlabAllocator.h"
+
+namespace Memory::Slab {
+
+void Cache::SlabList::push(Slab* slab)
+{
+    slab->prev = nullptr;
+    slab->next = head;
+    if (head)
+        head->prev = slab;
+    head = slab;
+    count++;
+}
+
+void Cache::SlabList::remove(Slab* slab)
+{
+    if (slab->prev)
+        slab->prev->next = slab->next;
+    else
+        head = slab->next;
+    if (slab->next)
+        slab->next->prev = slab->prev;
+    slab->next = nullptr;
+    slab->prev = nullptr;
+    count--;
+}
+
+void* Cache::allocate()
+{
+    InterruptDisabler disabler;
+    if (m_magazineCount)
+        return m_magazine[--m_magazineCount];
+
+    if (!is_slab_backed())
+        return kmalloc(m_objectSize);
+
+    refill_magazine();
+    return m_magazine[--m_magazineCount];
+}
+
+void Cache::free(void* object)
+{
+    if (!object)
+        return;
+
+    InterruptDisabler disabler;
+    if (m_magazineCount == m_magazineCapacity)
+        flush_magazine(m_magazineCapacity / 2);
+    m_magazine[m_magazineCount++] = object;
+}
+
+void Cache::reclaim()
+{
+    InterruptDisabler disabler;
+    flush_magazine(m_magazineCount);
+
+    LockAcquirer l(m_slabLock);
+    while (m_emptySlabs.head) {
+        auto* slab = m_emptySlabs.head;
+        m_emptySlabs.remove(slab);
+        Manager::instance().free_physical_block(VirtualAddress(slab).get_low_physical());
+    }
+}
+
+void Cache::refill_magazine()
+{
+    // Only fill half of the magazine, so that a burst of frees that follows does not
+    // immediately have to flush it again.
+    LockAcquirer l(m_slabLock);
+    while (m_magazineCount < m_magazineCapacity / 2)
+        m_magazine[m_magazineCount++] = take_object();
+}
+
+void Cache::flush_magazine(std::size_t count)
+{
+    if (!is_slab_backed()) {
+        while (count--)
+            kfree(m_magazine[--m_magazineCount]);
+        return;
+    }
+
+    LockAcquirer l(m_slabLock);
+    while (count--)
+        return_object(m_magazine[--m_magazineCount]);
+}
+
+Cache::Slab* Cache::create_slab()
+{
+    auto* slab = static_cast<Slab*>(VirtualAddress(Manager::instance().alloc_physical_block()).get());
+    slab->next = nullptr;
+    slab->prev = nullptr;
+    slab->freeList = nullptr;
+    slab->inUse = 0;
+
+    // Thread the free list through the objects, so they are handed out in address order.
+    auto* objects = reinterpret_cast<uint8_t*>(slab) + m_firstObjectOffset;
+    for (std::size_t i = m_objectsPerSlab; i-- > 0;) {
+        void* object = objects + i * m_objectSize;
+        *static_cast<void**>(object) = slab->freeList;
+        slab->freeList = object;
+    }
+    return slab;
+}
+
+void* Cache::take_object()
+{
+    auto* slab = m_partialSlabs.head;
+    if (!slab) {
+        slab = m_emptySlabs.head;
+        if (slab)
+            m_emptySlabs.remove(slab);
+        else
+            slab = create_slab();
+        m_partialSlabs.push(slab);
+    }
+
+    auto* object = slab->freeList;
+    slab->freeList = *static_cast<void**>(object);
+    slab->inUse++;
+
+    // Full slabs are not kept on a list until one of their objects is returned.
+    if (!slab->freeList)
+        m_partialSlabs.remove(slab);
+    return object;
+}
+
+void Cache::return_object(void* object)
+{
+    auto* slab = get_slab(object);
+    if (!slab->freeList)
+        m_partialSlabs.push(slab);
+
+    *static_cast<void**>(object) = slab->freeList;
+    slab->freeList = object;
+
+    if (--slab->inUse)
+        return;
+
+    m_partialSlabs.remove(slab);
+    if (m_emptySlabs.count < MAX_EMPTY_SLABS) {
+        m_emptySlabs.push(slab);
+        return;
+    }
+    Manager::instance().free_physical_block(VirtualAddress(slab).get_low_physical());
+}
+
+}
@@ -0,0 +1,135 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef SLABALLOCATOR_H
+#define SLABALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Tasks/Spinlock.h"
+
+namespace Memory::Slab {
+
+/**
+ * A cache of equally sized objects.
+ *
+ * Small objects are carved out of 4KiB slabs, which are physical blocks accessed through
+ * the physical memory map. Objects too large to share a slab come from the kernel heap.
+ * Freed objects are kept in a magazine and handed straight back out, so most allocations
+ * and frees do not touch the slab lists or their lock.
+ */
+class Cache
+{
+public:
+    constexpr Cache(std::size_t objectSize, std::size_t objectAlignment)
+        : m_objectSize(round_object_size(objectSize, objectAlignment))
+        , m_firstObjectOffset(round_up(sizeof(Slab), objectAlignment))
+        , m_objectsPerSlab(m_objectSize <= MAX_SLAB_OBJECT_SIZE ? (SLAB_SIZE - m_firstObjectOffset) / m_objectSize : 0)
+        , m_magazineCapacity(m_objectSize <= MAX_SLAB_OBJECT_SIZE ? MAGAZINE_SIZE : LARGE_MAGAZINE_SIZE)
+    {}
+
+    Cache(const Cache&) = delete;
+    Cache& operator=(const Cache&) = delete;
+
+    void* allocate();
+    void free(void* object);
+
+    /**
+     * Returns every object held in the magazine and every empty slab.
+     */
+    void reclaim();
+
+    static constexpr std::size_t SLAB_SIZE = 0x1000;
+    static constexpr std::size_t MAX_SLAB_OBJECT_SIZE = SLAB_SIZE / 8;
+
+private:
+    /**
+     * The header at the start of each slab.
+     */
+    struct Slab
+    {
+        Slab* next;
+        Slab* prev;
+        void* freeList;
+        std::size_t inUse;
+    };
+
+    struct SlabList
+    {
+        Slab* head = nullptr;
+        std::size_t count = 0;
+
+        void push(Slab* slab);
+        void remove(Slab* slab);
+    };
+
+    static constexpr std::size_t MAGAZINE_SIZE = 32;
+    static constexpr std::size_t LARGE_MAGAZINE_SIZE = 2;
+    // Empty slabs kept around before their blocks are given back.
+    static constexpr std::size_t MAX_EMPTY_SLABS = 1;
+
+    static constexpr std::size_t round_up(std::size_t value, std::size_t align)
+    {
+        return (value + align - 1) & ~(align - 1);
+    }
+
+    static constexpr std::size_t round_object_size(std::size_t size, std::size_t align)
+    {
+        // Free objects hold a pointer to the next free object.
+        if (align < alignof(void*))
+            align = alignof(void*);
+        if (size < sizeof(void*))
+            size = sizeof(void*);
+        return round_up(size, align);
+    }
+
+    bool is_slab_backed() const
+    {
+        return m_objectsPerSlab != 0;
+    }
+
+    Slab* get_slab(void* object)
+    {
+        return reinterpret_cast<Slab*>(reinterpret_cast<uint64_t>(object) & ~(SLAB_SIZE - 1));
+    }
+
+    Slab* create_slab();
+    void* take_object();
+    void return_object(void* object);
+    void refill_magazine();
+    void flush_magazine(std::size_t count);
+
+    std::size_t m_objectSize;
+    std::size_t m_firstObjectOffset;
+    std::size_t m_objectsPerSlab;
+    std::size_t m_magazineCapacity;
+
+    // The kernel runs on a single processor, so there is one magazine, owned by whoever has
+    // interrupts disabled.
+    void* m_magazine[MAGAZINE_SIZE] = {};
+    std::size_t m_magazineCount = 0;
+
+    SlabList m_partialSlabs;
+    SlabList m_emptySlabs;
+    Spinlock m_slabLock{LOCK_CLASS("Memory::Slab::Cache::m_slabLock")};
+};
+
+}
+
+#endif
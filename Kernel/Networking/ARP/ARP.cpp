@@ -38,13 +38,15 @@ void initialise()
 
 void handle_request(Message* message)
 {
-    Message response(*message);
-    response.operation = OperationValues::REPLY;
-    response.targetHardwareAddress = message->senderHardwareAddress;
-    response.targetProtocolAddress = message->senderProtocolAddress;
-    response.senderHardwareAddress = Ethernet::macAddress;
-    response.senderProtocolAddress = InternetProtocolV4::ipAddress;
-    Ethernet::send(message->senderHardwareAddress, Ethernet::EtherTypeValues::ARP, reinterpret_cast<uint8_t*>(&response), sizeof(Message));
+    PacketHandle packet(PacketBuffer::allocate());
+    auto* response = reinterpret_cast<Message*>(packet->put(sizeof(Message)));
+    *response = *message;
+    response->operation = OperationValues::REPLY;
+    response->targetHardwareAddress = message->senderHardwareAddress;
+    response->targetProtocolAddress = message->senderProtocolAddress;
+    response->senderHardwareAddress = Ethernet::macAddress;
+    response->senderProtocolAddress = InternetProtocolV4::ipAddress;
+    Ethernet::send(message->senderHardwareAddress, Ethernet::EtherTypeValues::ARP, std::move(packet));
 }
 
 void handle_reply(Message* message)
@@ -82,7 +84,9 @@ void receive(uint8_t* payload, std::size_t size)
 
 void send_request(InternetProtocolAddress reqIp)
 {
-    Message message = {
+    PacketHandle packet(PacketBuffer::allocate());
+    auto* message = reinterpret_cast<Message*>(packet->put(sizeof(Message)));
+    *message = {
         .hardwareType = HardwareTypeValues::ETHERNET,
         .protocolType = Ethernet::EtherTypeValues::IPV4,
         .hardwareAddressLen = HardwareAddressLengthValues::ETHERNET,
@@ -94,7 +98,7 @@ void send_request(InternetProtocolAddress reqIp)
         .targetProtocolAddress = reqIp
     };
     
-    Ethernet::send(BROADCAST_MAC, Ethernet::EtherTypeValues::ARP, reinterpret_cast<uint8_t*>(&message), sizeof(Message));
+    Ethernet::send(BROADCAST_MAC, Ethernet::EtherTypeValues::ARP, std::move(packet));
 }
 
 Common::Optional<MediaAccessControlAddress> find_cached_address(InternetProtocolAddress ipAddress)
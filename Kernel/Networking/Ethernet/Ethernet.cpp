@@ -21,7 +21,6 @@
 #include "Networking/NetworkServer.h"
 #include "Networking/IP/IPv4/Receive.h"
 #include "Networking/ARP/Receive.h"
-#include "Memory/KernelHeap.h"
 #include "print.h"
 
 namespace Networking::Ethernet
@@ -34,38 +33,35 @@ void initialise(MediaAccessControlAddress address)
     macAddress = address;
 }
 
-void receive(Common::Vector<uint8_t> data, MediaAccessControlAddress ourMac)
+void receive(PacketHandle frame, MediaAccessControlAddress ourMac)
 {
-    auto* rawDataPtr = data.data();
-    auto* frame = reinterpret_cast<Ethernet::FrameHeader*>(rawDataPtr);
+    if (frame->size() < sizeof(FrameHeader))
+        return;
 
-    if (frame->macDest.get_value() == ourMac.get_value()) {
-        switch (frame->ethertype.get_value()) {
+    auto* header = reinterpret_cast<Ethernet::FrameHeader*>(frame->data());
+
+    if (header->macDest.get_value() == ourMac.get_value()) {
+        auto ethertype = header->ethertype.get_value();
+        frame->pull(sizeof(FrameHeader));
+        switch (ethertype) {
         case EtherTypeValues::IPV4.get_value():
-            InternetProtocolV4::receive(rawDataPtr + sizeof(FrameHeader), data.size() - sizeof(FrameHeader));
+            InternetProtocolV4::receive(std::move(frame));
             break;
         case EtherTypeValues::ARP.get_value():
-            AddressResolutionProtocol::receive(rawDataPtr + sizeof(FrameHeader), data.size() - sizeof(FrameHeader));
+            AddressResolutionProtocol::receive(frame->data(), frame->size());
             break;
         }
     }
 }
 
-void send(MediaAccessControlAddress macDest, EtherType ethertype, uint8_t *buf, std::size_t size)
+void send(MediaAccessControlAddress macDest, EtherType ethertype, PacketHandle packet)
 {
-    size += sizeof(FrameHeader);
-    void* newBuf = static_cast<uint8_t*>(kmalloc(size, 0));
-    auto* frame = static_cast<FrameHeader*>(newBuf);
+    auto* frame = reinterpret_cast<FrameHeader*>(packet->push(sizeof(FrameHeader)));
     frame->macDest = macDest;
     frame->macSource = macAddress;
     frame->ethertype = ethertype;
 
-    memcpy(reinterpret_cast<uint8_t*>(newBuf) + sizeof(FrameHeader), buf, size - sizeof(FrameHeader));
-
-    EthernetServer::instance().send_to_driver(static_cast<uint8_t*>(newBuf), size);
-
-    /// FIXME: we should sent the buffer, not a pointer, to the driver so that it can be deallocated.
-    //kfree(newBuf);
+    EthernetServer::instance().send_to_driver(std::move(packet));
 }
 
 }
\ No newline at end of file
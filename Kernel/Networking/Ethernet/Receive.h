@@ -21,13 +21,13 @@
 
 #include <cstdint>
 
-#include "Common/Vector.h"
 #include "Networking/Ethernet/Common.h"
+#include "Networking/PacketBuffer.h"
 
 namespace Networking::Ethernet
 {
 
-void receive(Common::Vector<uint8_t> data, MediaAccessControlAddress ourMac);
+void receive(PacketHandle frame, MediaAccessControlAddress ourMac);
 
 }
 
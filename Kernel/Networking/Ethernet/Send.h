@@ -20,11 +20,15 @@
 #define ETHERNET_SEND_H
 
 #include "Networking/Ethernet/Common.h"
+#include "Networking/PacketBuffer.h"
 
 namespace Networking::Ethernet
 {
 
-void send(MediaAccessControlAddress destMac, EtherType type, uint8_t* buf, std::size_t size);
+/**
+ * Prepends the frame header in the packet's headroom and hands the frame to the driver.
+ */
+void send(MediaAccessControlAddress destMac, EtherType type, PacketHandle packet);
 
 }
 
@@ -21,7 +21,6 @@
 #include "Networking/Ethernet/Send.h"
 #include "Networking/ARP/Send.h"
 #include "Networking/TCP/Socket.h"
-#include "Memory/KernelHeap.h"
 
 namespace Networking::InternetProtocolV4
 {
@@ -37,37 +36,43 @@ void initialise(InternetProtocolAddress address, InternetProtocolAddress gateway
     subnet = subnetMask;
 }
 
-void receive(uint8_t* buf, std::size_t size)
+void receive(PacketHandle datagram)
 {
-    if (size < sizeof(MessageHeader))
+    if (datagram->size() < sizeof(MessageHeader))
         return;
     
-    auto* message = reinterpret_cast<MessageHeader*>(buf);
+    auto* message = reinterpret_cast<MessageHeader*>(datagram->data());
 
     if (message->get_dest_ip() != ipAddress)
         return;
     
-    if (message->get_length() > size)
-        message->set_length(size);
+    // Drop any padding the link layer added after the datagram.
+    datagram->trim(message->get_length());
+    std::size_t headerLength = 4 * message->get_ihl();
+    if (headerLength > datagram->size())
+        return;
+
+    auto destIp = message->get_dest_ip();
+    auto sourceIp = message->get_source_ip();
+    auto protocol = message->get_protocol();
+    datagram->pull(headerLength);
 
-    switch (message->get_protocol()) {
+    switch (protocol) {
     case Protocol::TCP:
-        TransmissionControlProtocol::Socket::receive_ip(message->get_dest_ip(), message->get_source_ip(), buf + 4 * message->get_ihl(), message->get_length() - 4 * message->get_ihl());
+        TransmissionControlProtocol::Socket::receive_ip(destIp, sourceIp, std::move(datagram));
         break;
     case Protocol::UDP:
         break;
     }
 }
 
-void send(InternetProtocolAddress destIp, uint8_t protocol, uint8_t* buf, std::size_t size)
+void send(InternetProtocolAddress destIp, uint8_t protocol, PacketHandle packet)
 {
-    size += sizeof(MessageHeader);
-    auto* messageBuffer = reinterpret_cast<uint8_t*>(kmalloc(size, 0));
-    auto* message = reinterpret_cast<MessageHeader*>(messageBuffer);
+    auto* message = reinterpret_cast<MessageHeader*>(packet->push(sizeof(MessageHeader)));
 
     message->set_version(Version::IPV4);
     message->set_ihl(sizeof(MessageHeader) / 4);
-    message->set_length(size);
+    message->set_length(packet->size());
     message->set_ident(0x0001);
     message->set_flags(Flags::NO_FRAGMENT);
     message->set_fragment_offset(0);
@@ -80,17 +85,13 @@ void send(InternetProtocolAddress destIp, uint8_t protocol, uint8_t* buf, std::s
     chksum.set_raw_value(checksum(reinterpret_cast<uint16_t*>(message), sizeof(MessageHeader)));
     message->set_header_checksum(chksum.get_value());
 
-    memcpy(messageBuffer + sizeof(MessageHeader), buf, size - sizeof(MessageHeader));
-
     InternetProtocolAddress route = destIp;
 
     if ((destIp.get_value() & subnet) != (message->get_source_ip().get_value() & subnet))
         route = gatewayAddress;
     auto routePhysicalAddress = AddressResolutionProtocol::request_and_wait_for_reply(route);
 
-    Ethernet::send(routePhysicalAddress, Ethernet::EtherTypeValues::IPV4, messageBuffer, size);
-
-    //kfree(buf);   
+    Ethernet::send(routePhysicalAddress, Ethernet::EtherTypeValues::IPV4, std::move(packet));
 }
 
 uint16_t checksum(uint16_t* data, std::size_t size)
@@ -101,7 +102,7 @@ uint16_t checksum(uint16_t* data, std::size_t size)
         temp += ((data[i] & 0xFF00) >> 8) | ((data[i] & 0x00FF) << 8);
 
     if(size % 2)
-        temp += ((uint16_t)((char*)data)[size-1]) << 8;
+        temp += ((uint16_t)((uint8_t*)data)[size-1]) << 8;
     
     while(temp & 0xFFFF0000)
         temp = (temp & 0xFFFF) + (temp >> 16);
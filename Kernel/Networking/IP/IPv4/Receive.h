@@ -20,11 +20,12 @@
 #define IPV4_RECEIVE_H
 
 #include "Networking/IP/IPv4/Common.h"
+#include "Networking/PacketBuffer.h"
 
 namespace Networking::InternetProtocolV4
 {
 
-void receive(uint8_t* buf, std::size_t size);
+void receive(PacketHandle datagram);
 
 }
 
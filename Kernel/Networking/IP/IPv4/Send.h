@@ -20,11 +20,15 @@
 #define IPV4_SEND_H
 
 #include "Networking/IP/IPv4/Common.h"
+#include "Networking/PacketBuffer.h"
 
 namespace Networking::InternetProtocolV4
 {
 
-void send(InternetProtocolAddress destIp, uint8_t protocol, uint8_t* buf, std::size_t size);
+/**
+ * Prepends the IPv4 header in the packet's headroom and sends it on towards the destination.
+ */
+void send(InternetProtocolAddress destIp, uint8_t protocol, PacketHandle packet);
 
 }
 
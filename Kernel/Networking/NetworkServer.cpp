@@ -50,16 +50,16 @@ void EthernetServer::register_device(Drivers::EthernetNetworkDriver* driver)
     m_networkDriver = driver;
 }
 
-void EthernetServer::send_to_driver(uint8_t* buf, std::size_t size)
+void EthernetServer::send_to_driver(PacketHandle frame)
 {
-    instance().m_networkDriver->send_data((buf), size);
+    instance().m_networkDriver->send_data(frame->data(), frame->size());
 }
 
-void EthernetServer::receive_from_driver(Common::Vector<uint8_t> data)
+void EthernetServer::receive_from_driver(PacketHandle frame)
 {
     {
         LockAcquirer l(instance().m_messageQueueLock);
-        instance().m_messageQueue.push_back(std::move(data));
+        instance().m_messageQueue.push_back(std::move(frame));
     }
     instance().m_threadWaitQueue.wake_one();
 }
@@ -87,10 +87,8 @@ void EthernetServer::network_thread(EthernetServer* server)
         }
         server->m_threadWaitQueue.remove_from_queue(wqItem);
 
-        auto messageIt = server->m_messageQueue.begin();
-        auto message = std::move(*messageIt);
-        
-        server->m_messageQueue.erase(messageIt);
+        auto message = std::move(server->m_messageQueue.front());
+        server->m_messageQueue.pop_front();
 
         server->m_messageQueueLock.release();
         auto mac = server->m_networkDriver->get_mac_address();
@@ -19,9 +19,11 @@
 #ifndef NETWORK_SERVER_H
 #define NETWORK_SERVER_H
 
+#include "Common/Deque.h"
 #include "Common/Vector.h"
 #include "Drivers/Network/NetworkDriver.h"
 #include "Memory/KernelHeap.h"
+#include "Networking/PacketBuffer.h"
 #include "Tasks/Mutex.h"
 #include "Tasks/WaitQueue.h"
 
@@ -66,13 +68,17 @@ public:
     }
 
     void register_device(Drivers::EthernetNetworkDriver* ptr);
-    void send_to_driver(uint8_t* buf, std::size_t size);
-    void receive_from_driver(Common::Vector<uint8_t> data);
+    /**
+     * Transmits the frame. Drivers copy it into their transmit ring before returning,
+     * so the buffer is free to go back to the pool afterwards.
+     */
+    void send_to_driver(PacketHandle frame);
+    void receive_from_driver(PacketHandle frame);
     bool has_started();
 private:
     EthernetServer() = default;
     Task::WaitQueue m_threadWaitQueue;
-    Common::List<Common::Vector<uint8_t>> m_messageQueue;
+    Common::Deque<PacketHandle> m_messageQueue;
     Mutex m_messageQueueLock;
     Drivers::EthernetNetworkDriver* m_networkDriver;
     static void network_thread(EthernetServer* server);
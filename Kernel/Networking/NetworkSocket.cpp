@@ -30,7 +30,9 @@ void NetworkSocket::initialise()
         .read = NetworkSocket::read,
         .write = NetworkSocket::write,
         .notify = NetworkSocket::notify,
-        .denotify = NetworkSocket::denotify
+        .denotify = NetworkSocket::denotify,
+        .readv = NetworkSocket::readv,
+        .writev = NetworkSocket::writev
     };
     Pipes::register_device("socket::network", &m_deviceOperations);
 }
@@ -106,7 +108,7 @@ void NetworkSocket::receive(uint8_t* data, uint32_t size)
 {
     LockAcquirer l(m_lock);
     
-    auto socketWasEmpty = m_queue.is_queue_empty();
+    auto socketWasEmpty = m_queue.empty();
     auto writeCount = m_queue.write(size, data);
 
     if (writeCount > 0) {
@@ -117,22 +119,36 @@ void NetworkSocket::receive(uint8_t* data, uint32_t size)
 }
 
 std::size_t NetworkSocket::read(std::size_t offset, std::size_t count, void* buf, void*& deviceSpecific)
+{
+    xpOS::API::Pipes::IOVector vector = { .base = buf, .length = count };
+    return readv(offset, &vector, 1, deviceSpecific);
+}
+
+std::size_t NetworkSocket::readv(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific)
 {
     auto* socket = static_cast<NetworkSocket*>(deviceSpecific);
     LockAcquirer l(socket->m_lock);
 
     Task::WaitQueue::Item wqitem = socket->m_readWaitQueue.add_to_queue();
-    while (socket->m_queue.is_queue_empty()) {
+    while (socket->m_queue.empty()) {
         if (socket->m_shouldNotBlock)
-            return 0;   
+            break;
         socket->m_lock.release();
         Task::Manager::instance().block();
         socket->m_lock.acquire();
+        Task::Manager::instance().about_to_block();
     }
 
     socket->m_readWaitQueue.remove_from_queue(wqitem);
 
-    return socket->m_queue.read(count, buf);
+    std::size_t readCount = 0;
+    for (std::size_t i = 0; i < vectorCount; i++) {
+        auto vectorReadCount = socket->m_queue.read(vectors[i].length, vectors[i].base);
+        readCount += vectorReadCount;
+        if (vectorReadCount < vectors[i].length)
+            break;
+    }
+    return readCount;
 }
 
 std::size_t NetworkSocket::write(std::size_t offset, std::size_t count, const void* buf, void*& deviceSpecific)
@@ -145,6 +161,16 @@ std::size_t NetworkSocket::write(std::size_t offset, std::size_t count, const vo
     return count;
 }
 
+std::size_t NetworkSocket::writev(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific)
+{
+    // The buffers are gathered so that they are sent as one segment.
+    Common::Vector<uint8_t> data;
+    for (std::size_t i = 0; i < vectorCount; i++)
+        data.append(static_cast<const uint8_t*>(vectors[i].base), vectors[i].length);
+
+    return write(offset, data.size(), data.data(), deviceSpecific);
+}
+
 Pipes::EventListenerList::Receipt NetworkSocket::notify(void* listener, Pipes::raise_events_callback raise_event, Pipes::EventTypeMask& current, void*& deviceSpecific)
 {
     auto* socket = static_cast<NetworkSocket*>(deviceSpecific);
@@ -152,7 +178,7 @@ Pipes::EventListenerList::Receipt NetworkSocket::notify(void* listener, Pipes::r
     Pipes::EventTypeMask mask = 0;
 
     LockAcquirer acquire(socket->m_lock);
-    if (!socket->m_queue.is_queue_empty())
+    if (!socket->m_queue.empty())
         mask |= Pipes::EventTypes::READABLE;
     
     if (socket->m_connections > 0)
@@ -19,6 +19,9 @@
 #ifndef NETWORKSOCKET_H
 #define NETWORKSOCKET_H
 
+#include "Common/ObjectCache.h"
+#include "Common/RingBuffer.h"
+#include "Common/Vector.h"
 #include "Pipes/Pipe.h"
 #include "TCP/Socket.h"
 
@@ -35,6 +38,9 @@ public:
     void receive(uint8_t* data, uint32_t size);
     void conn_request();
 
+    static void* operator new(std::size_t) { return Common::ObjectCache<NetworkSocket>::instance().allocate(); }
+    static void operator delete(void* ptr) { Common::ObjectCache<NetworkSocket>::instance().free(ptr); }
+
     enum class Flags : int
     {
         NON_BLOCKING = 1
@@ -54,6 +60,8 @@ private:
     static void close(void*& deviceSpecific);
     static std::size_t read(std::size_t offset, std::size_t count, void* buf, void*& deviceSpecific);
     static std::size_t write(std::size_t offset, std::size_t count, const void* buf, void*& deviceSpecific);
+    static std::size_t readv(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific);
+    static std::size_t writev(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific);
     static Pipes::EventListenerList::Receipt notify(void* listener, Pipes::raise_events_callback raise_event, Pipes::EventTypeMask& current, void*& deviceSpecific);
     static void denotify(Pipes::EventListenerList::Receipt receipt, void*& deviceSpecific);
 
@@ -61,7 +69,7 @@ private:
 
     Mutex m_lock;
 
-    Common::FixedCircularBuffer<QUEUE_SIZE> m_queue;
+    Common::SPSCRing<uint8_t, QUEUE_SIZE> m_queue;
 
     //bool m_binded = false;
     //bool m_connected = false;
@@ -0,0 +1,98 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "Networking/PacketBuffer.h"
+#include "Tasks/Spinlock.h"
+
+namespace Networking
+{
+
+namespace
+{
+    // Enough to fill the driver's receive queue.
+    constexpr std::size_t POOL_SIZE = 64;
+
+    // Only touched with interrupts disabled, as interrupt handlers allocate from it.
+    PacketBuffer* freeList = nullptr;
+    std::size_t freeCount = 0;
+}
+
+void PacketBuffer::initialise()
+{
+    for (std::size_t i = 0; i < POOL_SIZE; i++) {
+        auto* buffer = new PacketBuffer;
+        buffer->m_references = 1;
+        buffer->release();
+    }
+}
+
+PacketBuffer* PacketBuffer::allocate(std::size_t headroom)
+{
+    auto* buffer = try_allocate(headroom);
+    if (buffer)
+        return buffer;
+
+    buffer = new PacketBuffer;
+    buffer->reset(headroom);
+    return buffer;
+}
+
+PacketBuffer* PacketBuffer::try_allocate(std::size_t headroom)
+{
+    PacketBuffer* buffer;
+    {
+        InterruptDisabler disabler;
+        buffer = freeList;
+        if (!buffer)
+            return nullptr;
+        freeList = buffer->m_nextFree;
+        freeCount--;
+    }
+    buffer->reset(headroom);
+    return buffer;
+}
+
+void PacketBuffer::release()
+{
+    if (__atomic_sub_fetch(&m_references, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+
+    {
+        InterruptDisabler disabler;
+        // A buffer an interrupt handler took from the pool always fits back in it, so
+        // interrupt handlers never reach the kernel heap below.
+        if (freeCount < POOL_SIZE) {
+            m_nextFree = freeList;
+            freeList = this;
+            freeCount++;
+            return;
+        }
+    }
+    delete this;
+}
+
+void PacketBuffer::reset(std::size_t headroom)
+{
+    KERNEL_ASSERT(headroom <= CAPACITY);
+    m_references = 1;
+    m_start = headroom;
+    m_end = headroom;
+    m_nextFree = nullptr;
+}
+
+}
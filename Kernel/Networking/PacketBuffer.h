@@ -0,0 +1,225 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef XPOS_NETWORKING_PACKETBUFFER_H
+#define XPOS_NETWORKING_PACKETBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "panic.h"
+
+namespace Networking
+{
+
+/**
+ * A packet, held in one buffer for its whole trip through the network stack.
+ *
+ * The data sits between reserved headroom and tailroom. On the way down, each layer
+ * prepends its header in place with push(), and on the way up each layer strips its
+ * header with pull(), so the data itself is never copied between layers.
+ *
+ * Buffers are reference counted, and are recycled through a pool rather than going
+ * back to the kernel heap, which interrupt handlers can take from.
+ */
+class PacketBuffer
+{
+public:
+    // Large enough for a whole Ethernet frame, and for the driver's receive buffers.
+    static constexpr std::size_t CAPACITY = 2048;
+    // Enough for the Ethernet, IPv4 and TCP headers in front of a segment.
+    static constexpr std::size_t DEFAULT_HEADROOM = 128;
+
+    /**
+     * Fills the pool, so that drivers have buffers to receive into from the start.
+     */
+    static void initialise();
+
+    /**
+     * Takes a buffer from the pool, or from the kernel heap if the pool is empty.
+     * The buffer starts with one reference and no data.
+     */
+    static PacketBuffer* allocate(std::size_t headroom = DEFAULT_HEADROOM);
+
+    /**
+     * Takes a buffer from the pool only, so it can be called from interrupt handlers.
+     *
+     * @return nullptr if the pool is empty.
+     */
+    static PacketBuffer* try_allocate(std::size_t headroom = DEFAULT_HEADROOM);
+
+    void retain()
+    {
+        __atomic_add_fetch(&m_references, 1, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Returns the buffer to the pool once the last reference is dropped.
+     */
+    void release();
+
+    uint8_t* data()
+    {
+        return m_storage + m_start;
+    }
+
+    std::size_t size() const
+    {
+        return m_end - m_start;
+    }
+
+    std::size_t headroom() const
+    {
+        return m_start;
+    }
+
+    std::size_t tailroom() const
+    {
+        return CAPACITY - m_end;
+    }
+
+    /**
+     * Grows the data at the front by count bytes, for a header.
+     *
+     * @return the new start of the data.
+     */
+    uint8_t* push(std::size_t count)
+    {
+        KERNEL_ASSERT(count <= headroom());
+        m_start -= count;
+        return data();
+    }
+
+    /**
+     * Shrinks the data at the front by count bytes, once its header has been read.
+     *
+     * @return the new start of the data.
+     */
+    uint8_t* pull(std::size_t count)
+    {
+        KERNEL_ASSERT(count <= size());
+        m_start += count;
+        return data();
+    }
+
+    /**
+     * Grows the data at the back by count bytes.
+     *
+     * @return where the new bytes go.
+     */
+    uint8_t* put(std::size_t count)
+    {
+        KERNEL_ASSERT(count <= tailroom());
+        auto* end = m_storage + m_end;
+        m_end += count;
+        return end;
+    }
+
+    /**
+     * Shrinks the data at the back to at most size bytes, such as to drop padding.
+     */
+    void trim(std::size_t size)
+    {
+        if (size < this->size())
+            m_end = m_start + size;
+    }
+
+    PacketBuffer(const PacketBuffer&) = delete;
+    PacketBuffer& operator=(const PacketBuffer&) = delete;
+
+private:
+    PacketBuffer() = default;
+
+    void reset(std::size_t headroom);
+
+    std::size_t m_references = 0;
+    std::size_t m_start = 0;
+    std::size_t m_end = 0;
+    PacketBuffer* m_nextFree = nullptr;
+    uint8_t m_storage[CAPACITY];
+};
+
+/**
+ * Holds a reference to a packet buffer, so a layer can keep a packet, such as a
+ * segment received out of order, after the layers below have finished with it.
+ */
+class PacketHandle
+{
+public:
+    PacketHandle() = default;
+
+    /**
+     * Takes over a reference the caller already holds.
+     */
+    explicit PacketHandle(PacketBuffer* buffer)
+        : m_buffer(buffer)
+    {}
+
+    PacketHandle(const PacketHandle& other)
+        : m_buffer(other.m_buffer)
+    {
+        if (m_buffer)
+            m_buffer->retain();
+    }
+
+    PacketHandle(PacketHandle&& other)
+        : m_buffer(other.m_buffer)
+    {
+        other.m_buffer = nullptr;
+    }
+
+    PacketHandle& operator=(PacketHandle other)
+    {
+        std::swap(m_buffer, other.m_buffer);
+        return *this;
+    }
+
+    ~PacketHandle()
+    {
+        if (m_buffer)
+            m_buffer->release();
+    }
+
+    explicit operator bool() const
+    {
+        return m_buffer != nullptr;
+    }
+
+    PacketBuffer* get() const
+    {
+        return m_buffer;
+    }
+
+    PacketBuffer* operator->() const
+    {
+        return m_buffer;
+    }
+
+    PacketBuffer& operator*() const
+    {
+        return *m_buffer;
+    }
+
+private:
+    PacketBuffer* m_buffer = nullptr;
+};
+
+}
+
+#endif
@@ -20,7 +20,6 @@
 #define TCP_COMMON_H
 
 #include "API/Network.h"
-#include "Common/CircularBuffer.h"
 #include "Networking/IP/IPv4/Common.h"
 #include "Pipes/Pipe.h"
 #include "Tasks/WaitQueue.h"
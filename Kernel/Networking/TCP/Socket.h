@@ -19,6 +19,8 @@
 #ifndef TCP_SOCKET_H
 #define TCP_SOCKET_H
 
+#include "Common/Deque.h"
+#include "Networking/PacketBuffer.h"
 #include "Networking/TCP/Common.h"
 
 namespace Networking::TransmissionControlProtocol
@@ -29,6 +31,8 @@ struct Packet
     uint32_t sequenceNumber;
     uint32_t length;
     void* data;
+    // Keeps the buffer data points into, for packets that wait in a queue.
+    PacketHandle buffer;
 };
 
 class Socket
@@ -40,23 +44,24 @@ public:
     void connect(Endpoint to);
     void send(const uint8_t* data, std::size_t size);
     static void initialise();
-    static void receive_ip(InternetProtocolAddress destIp, InternetProtocolAddress sourceIp, uint8_t* payload, uint32_t size);
+    static void receive_ip(InternetProtocolAddress destIp, InternetProtocolAddress sourceIp, PacketHandle segment);
 
 private:
     Socket(void* netSock) : m_netSock(netSock)
     {}
 
     static inline Common::Hashmap<Endpoint, Common::List<Socket*>>* m_globalSocketMap;
-    static inline Mutex m_globalSocketLock;
+    static inline Mutex m_globalSocketLock{LOCK_CLASS("TransmissionControlProtocol::Socket::m_globalSocketLock")};
 
-    void receive(InternetProtocolAddress sourceIp, uint8_t* data, uint16_t size);
+    static bool checksum_valid(InternetProtocolAddress destIp, InternetProtocolAddress sourceIp, const PacketHandle& segment);
+    void receive(InternetProtocolAddress sourceIp, const PacketHandle& segment);
     void accept_on_listen(const Header& header);
-    void receive_on_listen(InternetProtocolAddress sourceIp, const Header& header);
+    void receive_on_listen(InternetProtocolAddress sourceIp, const PacketHandle& segment);
     void receive_on_syn_sent(const Header& header);
     void receive_ack(const Header& header);
     void receive_rst(const Header& header);
     void receive_fin(const Header& header);
-    void receive_data(uint8_t* data, uint16_t size);
+    void receive_data(const PacketHandle& segment);
     void refresh_retransmission_queue();
     void send(uint32_t seq, const uint8_t* data, uint16_t size, uint8_t flags);
 
@@ -82,6 +87,8 @@ private:
 
     // These are variables declared by the TCP specification.
     static constexpr uint32_t WINDOW_SIZE = 8192;
+    // The most data that fits in one segment alongside our header, within a 1500 byte IPv4 datagram.
+    static constexpr std::size_t MAXIMUM_SEGMENT_SIZE = 1500 - sizeof(InternetProtocolV4::MessageHeader) - sizeof(Header);
 
     uint32_t snd_una = 0xbeef0101;
     uint32_t snd_nxt = 0xbeef0101;
@@ -106,8 +113,8 @@ private:
     void* m_netSock = nullptr;
 
     Common::List<Packet> m_retransmissionQueue;
-    Common::List<Packet> m_outOfOrderList;
-    Common::List<std::pair<Endpoint, const Header*>> m_connectionQueue;
+    Common::Deque<Packet> m_outOfOrderList;
+    Common::List<std::pair<Endpoint, PacketHandle>> m_connectionQueue;
 
 };
 
@@ -32,9 +32,29 @@ void Socket::initialise()
     m_globalSocketMap = new Common::Hashmap<Endpoint, Common::List<Socket*>>();
 }
 
-void Socket::receive_ip(InternetProtocolAddress destIp, InternetProtocolAddress sourceIp, uint8_t* payload, uint32_t size)
+bool Socket::checksum_valid(InternetProtocolAddress destIp, InternetProtocolAddress sourceIp, const PacketHandle& segment)
 {
-    auto header = reinterpret_cast<Header*>(payload);
+    // As when sending, the pseudo-header goes in the headroom, here where the IPv4
+    // header was pulled from.
+    auto length = segment->size();
+    auto pseudoHeader = reinterpret_cast<PseudoHeader*>(segment->push(sizeof(PseudoHeader)));
+    pseudoHeader->set_dest_ip(destIp);
+    pseudoHeader->set_source_ip(sourceIp);
+    pseudoHeader->set_length(length);
+    pseudoHeader->set_protocol(InternetProtocolV4::Protocol::TCP);
+
+    // Summing over the checksum field as well gives zero if nothing was corrupted.
+    bool valid = InternetProtocolV4::checksum(reinterpret_cast<uint16_t*>(segment->data()), segment->size()) == 0;
+    segment->pull(sizeof(PseudoHeader));
+    return valid;
+}
+
+void Socket::receive_ip(InternetProtocolAddress destIp, InternetProtocolAddress sourceIp, PacketHandle segment)
+{
+    if (segment->size() < sizeof(Header) || !checksum_valid(destIp, sourceIp, segment))
+        return;
+
+    auto header = reinterpret_cast<Header*>(segment->data());
     uint16_t localPort = header->get_dest_port();
     uint16_t remotePort = header->get_source_port();
 
@@ -65,7 +85,7 @@ void Socket::receive_ip(InternetProtocolAddress destIp, InternetProtocolAddress
     }
 
     if (socket)
-        socket->receive(sourceIp, payload, size);
+        socket->receive(sourceIp, segment);
 }
 
 void Socket::accept_on_listen(const Header& header)
@@ -214,10 +234,12 @@ void Socket::receive_fin(const Header& header)
     }
 }
 
-void Socket::receive_on_listen(InternetProtocolAddress sourceIp, const Header& header)
+void Socket::receive_on_listen(InternetProtocolAddress sourceIp, const PacketHandle& segment)
 {
-    Endpoint remote = {header.get_source_port(), sourceIp};
-    m_connectionQueue.push_back({remote, &header});
+    auto header = reinterpret_cast<const Header*>(segment->data());
+    Endpoint remote = {header->get_source_port(), sourceIp};
+    // The segment is kept until the connection is accepted, as the header is read then.
+    m_connectionQueue.push_back({remote, segment});
     
 }
 
@@ -233,33 +255,37 @@ void Socket::add_to_received(const Packet& packet)
 
 void Socket::process_received()
 {
-    for (auto it = m_outOfOrderList.begin(); it != m_outOfOrderList.end();) {
+    while (!m_outOfOrderList.empty()) {
+        auto& packet = m_outOfOrderList.front();
         // If we now have packets that were previously missing, we can send them to the application.
-        if (rcv_nxt != it->sequenceNumber)
+        if (rcv_nxt != packet.sequenceNumber)
             break;
         
-        rcv_nxt += it->length;
+        rcv_nxt += packet.length;
         
-        reinterpret_cast<NetworkSocket*>(m_netSock)->receive(reinterpret_cast<uint8_t*>(it->data), it->length);
+        reinterpret_cast<NetworkSocket*>(m_netSock)->receive(reinterpret_cast<uint8_t*>(packet.data), packet.length);
         
-        it = m_outOfOrderList.erase(it);
+        m_outOfOrderList.pop_front();
     }
 }
 
-void Socket::receive_data(uint8_t* data, uint16_t size)
+void Socket::receive_data(const PacketHandle& segment)
 {
+    auto data = segment->data();
+    auto size = segment->size();
     auto header = reinterpret_cast<Header*>(data);
-    auto headerSize = header->get_data_offset() * 4;
+    std::size_t headerSize = header->get_data_offset() * 4;
 
     if (headerSize >= size)
         return;
 
     switch(m_state) {
-    case State::ESTABLISHED:
+    case State::ESTABLISHED: {
         Packet packet;
         packet.data = data+headerSize;
         packet.length = size-headerSize;
         packet.sequenceNumber = header->get_sequence_number();
+        packet.buffer = segment;
         // Add to the received queue.
         add_to_received(packet);
         // Check if we can send the received packets to the application layer.
@@ -267,31 +293,19 @@ void Socket::receive_data(uint8_t* data, uint16_t size)
         // Acknowledge the packet.
         send(snd_nxt, 0, 0, Flags::ACK);
         break;
+    }
     default:
         break;
     }
 }
 
-void Socket::receive(InternetProtocolAddress sourceIp, uint8_t* data, uint16_t size)
+void Socket::receive(InternetProtocolAddress sourceIp, const PacketHandle& segment)
 {
-    auto sizeInclPseudoHeader = sizeof(PseudoHeader) + size;
-    auto buf = reinterpret_cast<uint8_t*>(kmalloc(sizeInclPseudoHeader, 0));
-
-    memcpy(buf + sizeof(PseudoHeader), data, size);
-    auto pseudoHeader = reinterpret_cast<PseudoHeader*>(buf);
-    auto header = reinterpret_cast<Header*>(buf + sizeof(PseudoHeader));
-    pseudoHeader->set_dest_ip(InternetProtocolV4::ipAddress);
-    pseudoHeader->set_source_ip(sourceIp);
-    pseudoHeader->set_length(size);
-    pseudoHeader->set_protocol(InternetProtocolV4::Protocol::TCP);
-    
-    //if (InternetProtocolV4::checksum(reinterpret_cast<uint16_t*>(buf), sizeInclPseudoHeader))
-    //    return;
-    header = reinterpret_cast<Header*>(data);
+    auto header = reinterpret_cast<Header*>(segment->data());
 
     switch (m_state) {
     case State::LISTEN:
-        return receive_on_listen(sourceIp, *header);
+        return receive_on_listen(sourceIp, segment);
     case State::SYN_SENT:
         return receive_on_syn_sent(*header);
     default:
@@ -311,7 +325,7 @@ void Socket::receive(InternetProtocolAddress sourceIp, uint8_t* data, uint16_t s
         return;
     
     receive_ack(*header);
-    receive_data(data, size);
+    receive_data(segment);
 
     if (header->get_flags() & Flags::FIN)
         return receive_fin(*header);
@@ -319,10 +333,11 @@ void Socket::receive(InternetProtocolAddress sourceIp, uint8_t* data, uint16_t s
 
 void Socket::send(uint32_t seq, const uint8_t* data, uint16_t size, uint8_t flags)
 {
-    auto sizeInclPseudoHeader = sizeof(PseudoHeader) + sizeof(Header) + size;
-    auto buf = reinterpret_cast<uint8_t*>(kmalloc(sizeInclPseudoHeader, 0));
-    auto pseudoHeader = reinterpret_cast<PseudoHeader*>(buf);
-    auto header = reinterpret_cast<Header*>((buf + sizeof(PseudoHeader))); 
+    // The data is copied once, into a buffer with headroom for every layer's header.
+    PacketHandle packet(PacketBuffer::allocate());
+    if (size)
+        memcpy(packet->put(size), data, size);
+    auto header = reinterpret_cast<Header*>(packet->push(sizeof(Header)));
 
     if (flags & Flags::ACK)
         header->set_ack_number(rcv_nxt);
@@ -344,23 +359,24 @@ void Socket::send(uint32_t seq, const uint8_t* data, uint16_t size, uint8_t flag
         header->set_options(0);
     
     header->set_data_offset(sizeof(Header) / 4);
+
+    // The pseudo-header is only needed for the checksum, so it goes in the headroom
+    // the IPv4 header is later written over.
+    auto pseudoHeader = reinterpret_cast<PseudoHeader*>(packet->push(sizeof(PseudoHeader)));
     pseudoHeader->set_dest_ip(m_remoteIp);
     pseudoHeader->set_source_ip(Networking::InternetProtocolV4::ipAddress);
     pseudoHeader->set_length(sizeof(Header) + size);
     pseudoHeader->set_protocol(InternetProtocolV4::Protocol::TCP);
-    
-    memcpy(buf + sizeof(PseudoHeader) + sizeof(Header), data, size);
 
     Utilities::BigEndian<uint16_t> chksum;
-    chksum.set_raw_value(InternetProtocolV4::checksum(reinterpret_cast<uint16_t*>(buf), sizeInclPseudoHeader));
+    chksum.set_raw_value(InternetProtocolV4::checksum(reinterpret_cast<uint16_t*>(packet->data()), packet->size()));
     header->set_checksum(chksum.get_value());
-    InternetProtocolV4::send(m_remoteIp, InternetProtocolV4::Protocol::TCP, reinterpret_cast<uint8_t*>(header), size + sizeof(Header));
+    packet->pull(sizeof(PseudoHeader));
+    InternetProtocolV4::send(m_remoteIp, InternetProtocolV4::Protocol::TCP, std::move(packet));
 
     snd_nxt += size;
     if (flags & (Flags::FIN | Flags::SYN))
         snd_nxt++;
-    
-    //kfree(buf);
 }
 
 Socket* Socket::create_socket(Endpoint endpoint, void* netSock)
@@ -387,7 +403,7 @@ bool Socket::accept_conn_request(Socket*& newSock, void* netSock)
     
     auto connection = *m_connectionQueue.begin();
     auto endpoint = connection.first;
-    auto header = connection.second;
+    auto header = reinterpret_cast<const Header*>(connection.second->data());
 
     newSock = create_socket({m_localPort, m_localIp}, netSock);
     newSock->m_remotePort = endpoint.first;
@@ -412,7 +428,11 @@ void Socket::connect(Endpoint to)
 
 void Socket::send(const uint8_t* data, std::size_t size)
 {
-    send(snd_nxt, data, size, Flags::ACK);
+    // Each segment has to fit in one packet buffer, and one frame.
+    for (std::size_t sent = 0; sent < size; sent += MAXIMUM_SEGMENT_SIZE) {
+        auto count = size - sent < MAXIMUM_SEGMENT_SIZE ? size - sent : MAXIMUM_SEGMENT_SIZE;
+        send(snd_nxt, data + sent, count, Flags::ACK);
+    }
 }
 
 }
\ No newline at end of file
@@ -44,135 +44,184 @@ void EventListener::close(void*& deviceSpecific)
     delete listener;
 }
 
-void EventListener::inform(void* listener, EventTypeMask mask, uint64_t pipe)
+void EventListener::inform(void* registration, EventTypeMask mask, uint64_t pipe)
 {
-    static_cast<EventListener*>(listener)->inform(mask, pipe);
+    auto* r = static_cast<Registration*>(registration);
+    r->listener->inform(*r, mask);
 }
 
-void EventListener::inform(EventTypeMask mask, uint64_t pipe)
+void EventListener::inform(Registration& registration, EventTypeMask mask)
 {
-    LockAcquirer a(m_taskQueuesLock);
-    bool updatedRaisedEvent = false;
-    // If we already have events on a given pipe, just add the new raised
-    // events to it.
-    for (auto& [oldMask, ipipe] : m_raisedEvents) {
-        if (ipipe == pipe) {
-            oldMask |= mask;
-            updatedRaisedEvent = true;
-            break;
-        }
-    }
+    LockAcquirer a(m_readyLock);
+    registration.pendingEvents |= mask;
+    if (!registration.ready)
+        link_ready(registration);
 
-    if (!updatedRaisedEvent)
-        m_raisedEvents.push_back({mask, pipe});
+    if (!m_waitQueue.empty())
+        m_waitQueue.wake_queue();
+}
 
-    /*if (m_waitQueue.empty())
-        return;
-    
-    for (auto [eventList, max] : m_resultPtrQueue) {
-        int i = 0;
-        for (auto& event : m_raisedEvents) {
-            if (i == max)
-                break;
-            eventList[i] = event;
-            i++;
-        }
-    }
+void EventListener::link_ready(Registration& registration)
+{
+    registration.ready = true;
+    registration.previousReady = m_readyTail;
+    registration.nextReady = nullptr;
+    if (m_readyTail)
+        m_readyTail->nextReady = &registration;
+    else
+        m_readyHead = &registration;
+    m_readyTail = &registration;
+    m_readyCount++;
+}
 
-    m_waitQueue.wake_queue();
+void EventListener::unlink_ready(Registration& registration)
+{
+    if (!registration.ready)
+        return;
 
-    m_raisedEvents.clear();*/
-    wake();
+    if (registration.previousReady)
+        registration.previousReady->nextReady = registration.nextReady;
+    else
+        m_readyHead = registration.nextReady;
+    if (registration.nextReady)
+        registration.nextReady->previousReady = registration.previousReady;
+    else
+        m_readyTail = registration.previousReady;
+
+    registration.ready = false;
+    registration.previousReady = nullptr;
+    registration.nextReady = nullptr;
+    m_readyCount--;
 }
 
 std::size_t EventListener::read(std::size_t offset, std::size_t count, void* buf, void*& deviceSpecific)
 {
+    auto* listener = static_cast<EventListener*>(deviceSpecific);
     int maxEvents = count / sizeof(API::Event);
-    auto listener = reinterpret_cast<EventListener*>(deviceSpecific);
-    API::Event* events = new API::Event[count];
-
-    auto raised = listener->listen(events, maxEvents) * sizeof(API::Event);
-    memcpy(buf, events, raised);
-    delete[] events;
-    return raised;
+    return listener->listen(static_cast<API::Event*>(buf), maxEvents) * sizeof(API::Event);
 }
 
-void EventListener::wake()
+void EventListener::add(Pipe& listener, Pipe* pipe, uint64_t pd, EventTypeMask eventMask, uint64_t cookie)
 {
-    if (m_waitQueue.empty())
+    auto* l = static_cast<EventListener*>(listener.device_specific());
+    LockAcquirer acq(l->m_registrationLock);
+    if (l->m_registrations.find({pipe, eventMask}) != l->m_registrations.end())
         return;
-    for (auto [eventList, max] : m_resultPtrQueue) {
-        int i = 0;
-        for (auto& event : m_raisedEvents) {
-            if (i == max)
-                break;
-            eventList[i] = event;
-            i++;
-        }
-    }
 
-    m_waitQueue.wake_queue();
-}
+    auto* registration = new Registration {
+        .listener = l,
+        .pipe = pipe,
+        .pd = pd,
+        .cookie = cookie,
+        .interestedEvents = eventMask & ~API::EventFlags::LEVEL_TRIGGERED,
+        .levelTriggered = (eventMask & API::EventFlags::LEVEL_TRIGGERED) != 0
+    };
 
-void EventListener::add(Pipe& listener, Pipe* pipe, uint64_t pd, EventTypeMask eventMask)
-{
-    auto* l = static_cast<EventListener*>(listener.device_specific());
-    LockAcquirer acq(l->m_eventNotifRegLock);
-    
-    EventTypeMask currentEvents;
-
-    PipeNotifReg pipeNotifReg = pipe->notify(eventMask, l, inform, pd, currentEvents);
-    l->m_eventNotifRegs.insert(std::pair(std::pair(pipe, eventMask), pipeNotifReg));
-    if (currentEvents & eventMask)
-        l->inform(currentEvents & eventMask, pd);
+    EventTypeMask currentEvents = 0;
+    registration->notifReg = pipe->notify(registration->interestedEvents, registration, inform, pd, currentEvents);
+    if (registration->notifReg == pipe->m_listeners.end()) {
+        delete registration;
+        return;
+    }
+
+    l->m_registrations.insert({{pipe, eventMask}, registration});
+    if (currentEvents & registration->interestedEvents)
+        l->inform(*registration, currentEvents & registration->interestedEvents);
 }
 
 void EventListener::remove(Pipe& listener, Pipe* pipe, uint64_t pd, EventTypeMask event)
 {
     auto* l = static_cast<EventListener*>(listener.device_specific());
-    LockAcquirer acq(l->m_eventNotifRegLock);
-    auto pipeNotifReg = l->m_eventNotifRegs.find({pipe, event});
-    if (pipeNotifReg == l->m_eventNotifRegs.end())
+    LockAcquirer acq(l->m_registrationLock);
+    auto it = l->m_registrations.find({pipe, event});
+    if (it == l->m_registrations.end())
         return;
-    
-    pipe->unnotify(pipeNotifReg->second);
+
+    auto* registration = it->second;
+    l->m_registrations.erase(it);
+    // Once the pipe no longer knows about the registration, it cannot be linked again.
+    pipe->unnotify(registration->notifReg);
+    {
+        LockAcquirer a(l->m_readyLock);
+        l->unlink_ready(*registration);
+    }
+    delete registration;
 }
 
-int EventListener::listen(API::Event* eventListResult, int maxEvents)
+int EventListener::deliver(API::Event* eventListResult, int maxEvents)
 {
-    bool eventQueueEmpty = false;
-    int eventsReceived;
-    Task::WaitQueue::Item wqItem;
-    
-    auto it = m_resultPtrQueue.end();
+    std::size_t remaining;
     {
-        LockAcquirer a(m_taskQueuesLock);
-        wqItem = m_waitQueue.add_to_queue();
-        m_resultPtrQueue.push_back({eventListResult, maxEvents});
-        it = --m_resultPtrQueue.end();
-        eventQueueEmpty = m_raisedEvents.size() == 0;
+        LockAcquirer a(m_readyLock);
+        remaining = m_readyCount;
     }
 
-    if (eventQueueEmpty) {
-        Task::Manager::instance().block();
-        m_taskQueuesLock.acquire();
-    } else {
-        m_taskQueuesLock.acquire();
-        wake();
+    // Level-triggered registrations are linked again after they are delivered, so
+    // only the ones that were ready to begin with are visited.
+    int delivered = 0;
+    for (; remaining > 0 && delivered < maxEvents; remaining--) {
+        Registration* registration;
+        EventTypeMask raised;
+        {
+            LockAcquirer a(m_readyLock);
+            registration = m_readyHead;
+            if (!registration)
+                break;
+            unlink_ready(*registration);
+            raised = registration->pendingEvents;
+            registration->pendingEvents = 0;
+        }
+
+        if (registration->levelTriggered) {
+            // The events may have been consumed since they were raised, so the device
+            // is asked again. This is done without the ready lock, as devices raise
+            // events with their own locks held.
+            raised = registration->pipe->poll() & registration->interestedEvents;
+            if (raised) {
+                LockAcquirer a(m_readyLock);
+                if (!registration->ready)
+                    link_ready(*registration);
+            }
+        }
+
+        if (raised)
+            eventListResult[delivered++] = { .eventsRaised = raised, .pd = registration->pd, .cookie = registration->cookie };
     }
-    eventsReceived = m_raisedEvents.size();
-    m_raisedEvents.clear();
-    m_resultPtrQueue.erase(it);
-    m_waitQueue.remove_from_queue(wqItem);
-    m_taskQueuesLock.release();
+    return delivered;
+}
+
+int EventListener::listen(API::Event* eventListResult, int maxEvents)
+{
+    if (maxEvents <= 0)
+        return 0;
+
+    while (true) {
+        m_readyLock.acquire();
+        if (m_readyCount == 0) {
+            auto wqItem = m_waitQueue.add_to_queue();
+            m_readyLock.release();
+            Task::Manager::instance().block();
+
+            LockAcquirer a(m_readyLock);
+            m_waitQueue.remove_from_queue(wqItem);
+            continue;
+        }
+        m_readyLock.release();
 
-    return eventsReceived;
+        // Registrations cannot be removed while their events are being delivered.
+        LockAcquirer a(m_registrationLock);
+        auto delivered = deliver(eventListResult, maxEvents);
+        if (delivered > 0)
+            return delivered;
+    }
 }
 
 EventListener::~EventListener()
 {
-    for (auto& [pipeWrapped, reg] : m_eventNotifRegs)
-        pipeWrapped.first->unnotify(reg);
+    for (auto& [key, registration] : m_registrations) {
+        key.first->unnotify(registration->notifReg);
+        delete registration;
+    }
 }
 
-}
\ No newline at end of file
+}
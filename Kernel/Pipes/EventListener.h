@@ -33,14 +33,40 @@ using namespace xpOS;
 /**
  * An EventListener can be used to monitor events on multiple pipes 
  * concurrently in an efficient manner. 
+ *
+ * Each registration is linked into a ready list at most once, with the events
+ * raised since it was last delivered merged into it, so raising and delivering
+ * an event are both O(1). Registrations are edge-triggered by default: events
+ * are reported once per time the device raises them. Registrations made with
+ * API::EventFlags::LEVEL_TRIGGERED are instead reported on every listen for as
+ * long as the device still has the events raised.
  */
 class EventListener
 {
-    static void inform(void* listener, EventTypeMask mask, uint64_t pipe);
-
-    void inform(EventTypeMask mask, uint64_t pipe);
-
-    void wake();
+    struct Registration
+    {
+        EventListener* listener;
+        Pipe* pipe;
+        uint64_t pd;
+        uint64_t cookie;
+        EventTypeMask interestedEvents;
+        bool levelTriggered;
+        PipeNotifReg notifReg;
+
+        // These are guarded by the listener's ready lock.
+        EventTypeMask pendingEvents = 0;
+        bool ready = false;
+        Registration* previousReady = nullptr;
+        Registration* nextReady = nullptr;
+    };
+
+    static void inform(void* registration, EventTypeMask mask, uint64_t pipe);
+
+    void inform(Registration& registration, EventTypeMask mask);
+
+    void link_ready(Registration& registration);
+    void unlink_ready(Registration& registration);
+    int deliver(API::Event* eventListResult, int maxEvents);
 
     static bool open(void* with, int flags, void*& deviceSpecific);
     static void close(void*& deviceSpecific);
@@ -49,20 +75,21 @@ class EventListener
 
 public:
     static void initialise();
-    static void add(Pipe& listener, Pipe* pipe, uint64_t pd, EventTypeMask eventMask);
+    static void add(Pipe& listener, Pipe* pipe, uint64_t pd, EventTypeMask eventMask, uint64_t cookie = 0);
 
     static void remove(Pipe& listener, Pipe* pipe, uint64_t pd, EventTypeMask event);
 
 private:
     EventListener() {}
     ~EventListener();
-    Common::Hashmap<std::pair<Pipe*, uint64_t>, PipeNotifReg> m_eventNotifRegs;
-    Mutex m_eventNotifRegLock;
+    Common::Hashmap<std::pair<Pipe*, uint64_t>, Registration*> m_registrations;
+    Mutex m_registrationLock;
 
-    Mutex m_taskQueuesLock;
+    Mutex m_readyLock;
     Task::WaitQueue m_waitQueue;
-    Common::List<std::pair<API::Event*, int>> m_resultPtrQueue;
-    Common::List<API::Event> m_raisedEvents;
+    Registration* m_readyHead = nullptr;
+    Registration* m_readyTail = nullptr;
+    std::size_t m_readyCount = 0;
 
     static inline Pipes::DeviceOperations m_deviceOperations;
 };
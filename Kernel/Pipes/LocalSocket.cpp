@@ -29,11 +29,23 @@ void LocalSocket::initialise()
         .read = LocalSocket::read,
         .write = LocalSocket::write,
         .notify = LocalSocket::notify,
-        .denotify = LocalSocket::denotify
+        .denotify = LocalSocket::denotify,
+        .readv = LocalSocket::readv,
+        .writev = LocalSocket::writev,
+        .space = LocalSocket::space
     };
     Pipes::register_device("socket::local", &m_deviceOperations);
 }
 
+LocalSocket::~LocalSocket()
+{
+    // Frames of loans that were never read are still referenced by the socket.
+    for (auto& loan : m_loans) {
+        for (auto i = loan.released; i < loan.frames.size(); i++)
+            Memory::Manager::instance().free_physical_block(loan.frames[i]);
+    }
+}
+
 bool LocalSocket::open(void* with, int flags, void*& deviceSpecific)
 {
     deviceSpecific = new LocalSocket(flags);
@@ -46,7 +58,8 @@ void LocalSocket::close(void*& deviceSpecific)
     auto* socket = static_cast<LocalSocket*>(deviceSpecific);
     {
         LockAcquirer acquirer(m_mapLock);
-        bind_map().erase(socket->m_identifier);
+        if (socket->m_binded)
+            bind_map().erase(socket->m_identifier);
     }
     deviceSpecific = nullptr;
     
@@ -65,8 +78,8 @@ bool LocalSocket::bind(Pipes::Pipe& pipe, const char* id)
         if (bind_map().find(id) != bind_map().end())
             return false;
         
-        strcpy(socket->m_identifier, id);
-        bind_map().insert({id, socket});
+        socket->m_identifier = id;
+        bind_map().insert({socket->m_identifier, socket});
     }
     
     socket->m_binded = true;
@@ -125,6 +138,8 @@ bool LocalSocket::accept(Pipes::Pipe& pipe, Pipes::Pipe& newPipe)
     LockAcquirer acquirer(socket->m_lock);
     
     auto* newSocket = static_cast<LocalSocket*>(newPipe.device_specific());
+    // Accepted sockets receive messages the same way as the socket they were accepted on.
+    newSocket->m_seqpacket = socket->m_seqpacket;
 
     newSocket->m_endpoint = remoteSocket;
     remoteSocket->m_endpoint = newSocket;
@@ -174,116 +189,317 @@ bool LocalSocket::connect(Pipes::Pipe& pipe, const char* id)
 }
 
 std::size_t LocalSocket::read(std::size_t offset, std::size_t count, void* buf, void*& deviceSpecific)
+{
+    xpOS::API::Pipes::IOVector vector = { .base = buf, .length = count };
+    return readv(offset, &vector, 1, deviceSpecific);
+}
+
+std::size_t LocalSocket::readv(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific)
 {
     auto* socket = static_cast<LocalSocket*>(deviceSpecific);
-    LockAcquirer acquire(socket->m_lock);
+    LockAcquirer acquire(socket->m_readLock);
 
-    Task::WaitQueue::Item wqitem = socket->m_readWaitQueue.add_to_queue();
+    if (!socket->wait_while(socket->m_readWaitQueue, socket->m_shouldNotBlock, [socket] { return socket->queued_bytes() == 0; }))
+        return 0;
 
-    while (socket->m_connected && socket->m_queue.is_queue_empty()) { 
-        if (socket->m_shouldNotBlock)
-            return 0;   
-        socket->m_lock.release();
-        Task::Manager::instance().block();
-        socket->m_lock.acquire();
+    if (socket->m_seqpacket)
+        return socket->read_packet(vectors, vectorCount);
+
+    std::size_t queueReadCount = 0;
+    std::size_t lentReadCount = 0;
+    for (std::size_t i = 0; i < vectorCount; i++) {
+        auto* buf = static_cast<uint8_t*>(vectors[i].base);
+        std::size_t done = 0;
+        while (done < vectors[i].length) {
+            bool fromLoan;
+            auto readCount = socket->read_stream(vectors[i].length - done, buf + done, fromLoan);
+            if (readCount == 0)
+                break;
+            (fromLoan ? lentReadCount : queueReadCount) += readCount;
+            done += readCount;
+        }
+        if (done < vectors[i].length)
+            break;
     }
-    
-    socket->m_readWaitQueue.remove_from_queue(wqitem);
 
-    if (!socket->m_connected)
-        return 0;
+    auto readCount = queueReadCount + lentReadCount;
+    if (readCount > 0) {
+        socket->m_writeWaitQueue.wake_queue();
+        // Only the writer can take free space away, so if the socket was full before
+        // this read, no more than the bytes read can be free now.
+        if ((queueReadCount > 0 && QUEUE_SIZE - socket->m_queue.size() <= queueReadCount)
+            || (lentReadCount > 0 && MAX_LENT_BYTES - socket->lent_bytes() <= lentReadCount))
+            socket->notify_writer();
+    }
+    return readCount;
+}
+
+std::size_t LocalSocket::read_stream(std::size_t count, void* buf, bool& fromLoan)
+{
+    Loan* loan = nullptr;
+    std::size_t available;
+    {
+        LockAcquirer l(m_loanLock);
+        // Bytes queued after the first loan cannot have been written before it was
+        // pushed, so the queue is only read up to the loan's offset.
+        available = m_queue.size();
+        if (!m_loans.empty()) {
+            auto& front = m_loans.front();
+            if (front.streamOffset == m_queueBytesRead)
+                loan = &front;
+            else
+                available = front.streamOffset - m_queueBytesRead;
+        }
+    }
 
-    //std::size_t readCount = 0;
-    auto socketWasFull = socket->m_queue.is_queue_full();
+    fromLoan = loan != nullptr;
+    if (loan) {
+        auto readCount = read_loan(*loan, count, buf);
+        if (loan->consumed == loan->length) {
+            LockAcquirer l(m_loanLock);
+            m_loans.pop_front();
+        }
+        __atomic_fetch_sub(&m_lentBytes, readCount, __ATOMIC_RELEASE);
+        return readCount;
+    }
 
-    /*auto start = socket->m_queueFront;
+    auto readCount = m_queue.read(count < available ? count : available, buf);
+    m_queueBytesRead += readCount;
+    return readCount;
+}
 
-    auto socketWasFull = socket->is_queue_full();
+std::size_t LocalSocket::read_packet(const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount)
+{
+    // Writers publish the length and data together, so a queued length means the
+    // whole message is there.
+    PacketHeader length;
+    if (m_queue.read(sizeof(PacketHeader), &length) != sizeof(PacketHeader))
+        return 0;
 
-    while (!socket->is_queue_empty() && count--) {
-        socket->m_queueFront += 1;
-        socket->m_queueFront %= QUEUE_SIZE;
-        readCount++;
+    std::size_t readCount = 0;
+    for (std::size_t i = 0; i < vectorCount && readCount < length; i++) {
+        auto count = length - readCount;
+        if (count > vectors[i].length)
+            count = vectors[i].length;
+        readCount += m_queue.read(count, vectors[i].base);
     }
-    
-    auto end = socket->m_queueFront;
+    m_queue.discard(length - readCount);
 
-    if (start <= end) {
-        memcpy(buf, socket->m_queue + start, end - start);
-    } else { 
-        memcpy(buf, socket->m_queue + start, QUEUE_SIZE - start);
-        memcpy(static_cast<char*>(buf) + (QUEUE_SIZE - start), socket->m_queue, end);
-    }*/
+    auto consumed = sizeof(PacketHeader) + length;
+    m_queueBytesRead += consumed;
+    m_writeWaitQueue.wake_queue();
+    if (__atomic_exchange_n(&m_writeRefused, false, __ATOMIC_SEQ_CST))
+        notify_writer();
+    return readCount;
+}
 
-   auto readCount = socket->m_queue.read(count, buf);
+std::size_t LocalSocket::space(void*& deviceSpecific)
+{
+    auto* socket = static_cast<LocalSocket*>(deviceSpecific);
+    LocalSocket* remoteSocket;
+    {
+        LockAcquirer acquire(socket->m_lock);
+        if (!socket->m_shouldNotBlock)
+            return SIZE_MAX;
+        remoteSocket = socket->m_endpoint;
+    }
+    if (!remoteSocket)
+        return 0;
 
-    if (readCount > 0) {
-        socket->m_writeWaitQueue.wake_queue();
-        if (socketWasFull)
-            socket->m_eventListenerList.notify(Pipes::EventTypes::WRITEABLE);
+    auto space = remoteSocket->m_queue.space();
+    if (!remoteSocket->m_seqpacket)
+        return space;
+    // Each write becomes one message, which is queued after its length.
+    if (space <= sizeof(PacketHeader))
+        return 0;
+    space -= sizeof(PacketHeader);
+    return space < MAX_PACKET_SIZE ? space : MAX_PACKET_SIZE;
+}
+
+void LocalSocket::notify_writer()
+{
+    // Writers listen on their own end, which reports whether this end has room.
+    LocalSocket* endpoint;
+    {
+        LockAcquirer acquire(m_lock);
+        endpoint = m_endpoint;
     }
-    return readCount;
+    if (endpoint)
+        endpoint->m_eventListenerList.notify(Pipes::EventTypes::WRITEABLE);
 }
 
 std::size_t LocalSocket::write(std::size_t offset, std::size_t count, const void* buf, void*& deviceSpecific)
+{
+    xpOS::API::Pipes::IOVector vector = { .base = const_cast<void*>(buf), .length = count };
+    return writev(offset, &vector, 1, deviceSpecific);
+}
+
+std::size_t LocalSocket::writev(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific)
 {
     auto* socket = static_cast<LocalSocket*>(deviceSpecific);
     LocalSocket* remoteSocket;
     bool shouldNotBlock;
+    bool zeroCopy;
 
     {
         LockAcquirer acquire(socket->m_lock);
         remoteSocket = socket->m_endpoint;
         shouldNotBlock = socket->m_shouldNotBlock;
+        zeroCopy = socket->m_zeroCopy;
     }
 
     if (!remoteSocket)
         return 0;
-    
-    LockAcquirer acquire(remoteSocket->m_lock);
 
-    Task::WaitQueue::Item wqitem = remoteSocket->m_writeWaitQueue.add_to_queue();
-
-    while (remoteSocket->m_connected && remoteSocket->m_queue.is_queue_full()) {
-        if (shouldNotBlock)
-            return 0;    
-        remoteSocket->m_lock.release();
-        Task::Manager::instance().block();
-        remoteSocket->m_lock.acquire();
-    }
-    remoteSocket->m_writeWaitQueue.remove_from_queue(wqitem);
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < vectorCount; i++)
+        count += vectors[i].length;
+    
+    LockAcquirer acquire(remoteSocket->m_writeLock);
 
-    if (!remoteSocket->m_connected)
-        return 0;
-    auto socketWasEmpty = remoteSocket->m_queue.is_queue_empty();
+    if (remoteSocket->m_seqpacket)
+        return remoteSocket->write_packet(vectors, vectorCount, count, shouldNotBlock);
 
-    /*std::size_t writeCount = 0;
-    auto start = remoteSocket->m_queueBack;
+    std::size_t writeCount = 0;
 
-    while (!remoteSocket->is_queue_full() && count--) {
-        remoteSocket->m_queueBack += 1;
-        remoteSocket->m_queueBack %= QUEUE_SIZE;
-        writeCount++;
+    // Only single buffers are lent, as a loan is made of whole pages.
+    if (zeroCopy && vectorCount == 1 && count >= ZERO_COPY_THRESHOLD && reinterpret_cast<uint64_t>(vectors[0].base) % Memory::PAGE_4KiB == 0) {
+        if (!remoteSocket->wait_while(remoteSocket->m_writeWaitQueue, shouldNotBlock, [remoteSocket] { return remoteSocket->lent_bytes() >= MAX_LENT_BYTES; }))
+            return 0;
+        // Buffers that cannot be lent, such as device mappings, fall back to the queue.
+        writeCount = remoteSocket->lend(count, vectors[0].base);
     }
 
-    auto end = remoteSocket->m_queueBack;
+    if (writeCount == 0) {
+        if (!remoteSocket->wait_while(remoteSocket->m_writeWaitQueue, shouldNotBlock, [remoteSocket] { return remoteSocket->m_queue.full(); }))
+            return 0;
 
-    if (start <= end) {
-        memcpy(remoteSocket->m_queue + start, buf, end - start);
-    } else {
-        memcpy(remoteSocket->m_queue + start, buf, QUEUE_SIZE - start);
-        memcpy(remoteSocket->m_queue, static_cast<const char*>(buf) + (QUEUE_SIZE - start), end);
-    }*/
-    auto writeCount = remoteSocket->m_queue.write(count, buf);
+        for (std::size_t i = 0; i < vectorCount; i++) {
+            auto vectorWriteCount = remoteSocket->m_queue.write(vectors[i].length, vectors[i].base);
+            writeCount += vectorWriteCount;
+            if (vectorWriteCount < vectors[i].length)
+                break;
+        }
+        remoteSocket->m_queueBytesWritten += writeCount;
+    }
 
     if (writeCount > 0) {
         remoteSocket->m_readWaitQueue.wake_queue();
-        if (socketWasEmpty)
+        // Only the reader can take data away, so if the socket was empty before this
+        // write, no more than writeCount bytes can be queued now.
+        if (remoteSocket->queued_bytes() <= writeCount)
             remoteSocket->m_eventListenerList.notify(Pipes::EventTypes::READABLE);
     }
     return writeCount;
 }
 
+std::size_t LocalSocket::write_packet(const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, std::size_t count, bool shouldNotBlock)
+{
+    if (count > MAX_PACKET_SIZE)
+        return 0;
+
+    if (!wait_while(m_writeWaitQueue, shouldNotBlock, [this, count] { return m_queue.space() < sizeof(PacketHeader) + count; }))
+        return 0;
+    if (m_queue.space() < sizeof(PacketHeader) + count) {
+        // A non-blocking writer is turned away until the reader frees space, which
+        // may have happened before the reader could see the flag, so check again.
+        __atomic_store_n(&m_writeRefused, true, __ATOMIC_SEQ_CST);
+        if (m_queue.space() < sizeof(PacketHeader) + count)
+            return 0;
+    }
+
+    // The length and every buffer are staged first, so the reader sees the whole
+    // message or none of it.
+    auto length = static_cast<PacketHeader>(count);
+    auto staged = m_queue.stage(0, sizeof(PacketHeader), &length);
+    if (staged == 0)
+        return 0;
+    for (std::size_t i = 0; i < vectorCount; i++)
+        staged += m_queue.stage(staged, vectors[i].length, vectors[i].base);
+    m_queue.publish(staged);
+
+    m_queueBytesWritten += staged;
+    m_readWaitQueue.wake_queue();
+    if (m_queue.size() <= staged)
+        m_eventListenerList.notify(Pipes::EventTypes::READABLE);
+    return count;
+}
+
+std::size_t LocalSocket::lend(std::size_t count, const void* buf)
+{
+    auto& memoryManager = Memory::Manager::instance();
+    auto& addressSpace = *Task::Manager::instance().get_current_task()->tlTable;
+
+    auto limit = MAX_LENT_BYTES - lent_bytes();
+    auto pages = (count < limit ? count : limit) / Memory::PAGE_4KiB;
+    auto base = reinterpret_cast<uint64_t>(buf);
+
+    Loan loan { .streamOffset = m_queueBytesWritten };
+    loan.frames.reserve(pages);
+    for (std::size_t i = 0; i < pages; i++) {
+        auto frame = memoryManager.lend_page(base + i * Memory::PAGE_4KiB, addressSpace);
+        if (frame.get_raw() == 0)
+            break;
+        loan.frames.push_back(frame);
+    }
+
+    if (loan.frames.empty())
+        return 0;
+
+    auto length = loan.frames.size() * Memory::PAGE_4KiB;
+    loan.length = length;
+    {
+        LockAcquirer l(m_loanLock);
+        m_loans.push_back(std::move(loan));
+    }
+    __atomic_fetch_add(&m_lentBytes, length, __ATOMIC_RELEASE);
+    return length;
+}
+
+std::size_t LocalSocket::read_loan(Loan& loan, std::size_t count, void* buf)
+{
+    auto& memoryManager = Memory::Manager::instance();
+    auto remaining = loan.length - loan.consumed;
+    if (count > remaining)
+        count = remaining;
+
+    auto destination = reinterpret_cast<uint64_t>(buf);
+    std::size_t done = 0;
+
+    // Whole pages read to page-aligned buffers are mapped instead of copied.
+    if (destination % Memory::PAGE_4KiB == 0 && loan.consumed % Memory::PAGE_4KiB == 0) {
+        auto& addressSpace = *Task::Manager::instance().get_current_task()->tlTable;
+        while (count - done >= Memory::PAGE_4KiB) {
+            auto index = (loan.consumed + done) / Memory::PAGE_4KiB;
+            if (!memoryManager.accept_lent_page(loan.frames[index], destination + done, addressSpace))
+                break;
+            loan.released = index + 1;
+            done += Memory::PAGE_4KiB;
+        }
+    }
+
+    while (done < count) {
+        auto position = loan.consumed + done;
+        auto index = position / Memory::PAGE_4KiB;
+        auto pageOffset = position % Memory::PAGE_4KiB;
+        auto chunk = Memory::PAGE_4KiB - pageOffset;
+        if (chunk > count - done)
+            chunk = count - done;
+
+        auto* source = static_cast<uint8_t*>(Memory::VirtualAddress(loan.frames[index]).get()) + pageOffset;
+        memcpy(reinterpret_cast<void*>(destination + done), source, chunk);
+        done += chunk;
+
+        if (pageOffset + chunk == Memory::PAGE_4KiB) {
+            memoryManager.free_physical_block(loan.frames[index]);
+            loan.released = index + 1;
+        }
+    }
+
+    loan.consumed += done;
+    return done;
+}
+
 Pipes::EventListenerList::Receipt LocalSocket::notify(void* listener, Pipes::raise_events_callback raise_event, Pipes::EventTypeMask& current, void*& deviceSpecific)
 {
     auto* socket = static_cast<LocalSocket*>(deviceSpecific);
@@ -292,7 +508,7 @@ Pipes::EventListenerList::Receipt LocalSocket::notify(void* listener, Pipes::rai
     LocalSocket* remoteSocket;
     {
         LockAcquirer acquire(socket->m_lock);
-        if (socket->m_connected && !socket->m_queue.is_queue_empty())
+        if (socket->m_connected && socket->queued_bytes() > 0)
             mask |= Pipes::EventTypes::READABLE;
         
         if (socket->m_connectionQueue.size() > 0)
@@ -300,11 +516,8 @@ Pipes::EventListenerList::Receipt LocalSocket::notify(void* listener, Pipes::rai
         remoteSocket = socket->m_endpoint;
     }
 
-    if (remoteSocket) {
-        LockAcquirer acquire(remoteSocket->m_lock);
-        if (remoteSocket->m_connected && !remoteSocket->m_queue.is_queue_full())
-            mask |= Pipes::EventTypes::WRITEABLE;
-    }
+    if (remoteSocket && remoteSocket->m_connected && (!remoteSocket->m_queue.full() || (socket->m_zeroCopy && remoteSocket->lent_bytes() < MAX_LENT_BYTES)))
+        mask |= Pipes::EventTypes::WRITEABLE;
     
     current = mask;
 
@@ -19,10 +19,14 @@
 #ifndef LOCALSOCKET_H
 #define LOCALSOCKET_H
 
-#include "Common/CircularBuffer.h"
+#include "Common/Deque.h"
 #include "Common/Hashmap.h"
+#include "Common/ObjectCache.h"
+#include "Common/RingBuffer.h"
 #include "Common/String.h"
 #include "Common/Expected.h"
+#include "Common/Vector.h"
+#include "Memory/MemoryManager.h"
 #include "Tasks/Mutex.h"
 #include "Tasks/TaskManager.h"
 #include "Tasks/WaitQueue.h"
@@ -43,9 +47,19 @@ namespace Sockets
         static bool listen(Pipes::Pipe& pipe);
         static bool accept(Pipes::Pipe& pipe, Pipes::Pipe& newPipe);
         static void initialise();
+
+        static void* operator new(std::size_t) { return Common::ObjectCache<LocalSocket>::instance().allocate(); }
+        static void operator delete(void* ptr) { Common::ObjectCache<LocalSocket>::instance().free(ptr); }
+
         enum class Flags : int
         {
-            NON_BLOCKING = 1
+            NON_BLOCKING = 1,
+            // Large page-aligned writes lend their pages to the reader instead of
+            // being copied through the queue.
+            ZERO_COPY = 2,
+            // Each write is delivered as one message, and each read returns at most one
+            // message, discarding any part that does not fit in the buffer.
+            SEQPACKET = 4
         };
 
         enum EventTypes : Pipes::EventType
@@ -56,43 +70,111 @@ namespace Sockets
     private:
         LocalSocket(int flags)
             : m_shouldNotBlock(flags & static_cast<int>(Flags::NON_BLOCKING))
+            , m_zeroCopy(flags & static_cast<int>(Flags::ZERO_COPY))
+            , m_seqpacket(flags & static_cast<int>(Flags::SEQPACKET))
         {}
+        ~LocalSocket();
         static bool open(void* with, int flags, void*& deviceSpecific);
         static void close(void*& deviceSpecific);
         static std::size_t read(std::size_t offset, std::size_t count, void* buf, void*& deviceSpecific);
         static std::size_t write(std::size_t offset, std::size_t count, const void* buf, void*& deviceSpecific);
+        static std::size_t readv(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific);
+        static std::size_t writev(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific);
         static Pipes::EventListenerList::Receipt notify(void* listener, Pipes::raise_events_callback raise_event, Pipes::EventTypeMask& current, void*& deviceSpecific);
         static void denotify(Pipes::EventListenerList::Receipt receipt, void*& deviceSpecific);
+        /**
+         * Blocking sockets wait for room, so only non-blocking ones report a limit.
+         */
+        static std::size_t space(void*& deviceSpecific);
 
         static constexpr int QUEUE_SIZE = 65536;
+        static constexpr std::size_t ZERO_COPY_THRESHOLD = 4 * Memory::PAGE_4KiB;
+        static constexpr std::size_t MAX_LENT_BYTES = 4 * 1024 * 1024;
+
+        // Messages are queued after their length.
+        using PacketHeader = uint32_t;
+        static constexpr std::size_t MAX_PACKET_SIZE = QUEUE_SIZE - sizeof(PacketHeader);
+
+        /**
+         * Whole pages lent by a writer, which are read once the first streamOffset
+         * bytes written through the queue have been read.
+         */
+        struct Loan
+        {
+            uint64_t streamOffset;
+            Common::Vector<Memory::PhysicalAddress> frames;
+            std::size_t length = 0;
+            std::size_t consumed = 0;
+            // Frames before this index are no longer referenced by the loan.
+            std::size_t released = 0;
+        };
 
-        static Common::Hashmap<Common::HashableString, LocalSocket*>& bind_map()
+        std::size_t lend(std::size_t count, const void* buf);
+        std::size_t read_loan(Loan& loan, std::size_t count, void* buf);
+        std::size_t read_stream(std::size_t count, void* buf, bool& fromLoan);
+        std::size_t read_packet(const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount);
+        std::size_t write_packet(const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, std::size_t count, bool shouldNotBlock);
+        /**
+         * Raises WRITEABLE for listeners on the other end, once reading has freed space.
+         */
+        void notify_writer();
+
+        std::size_t lent_bytes()
         {
-            static Common::Hashmap<Common::HashableString, LocalSocket*> bindMap;
-            return bindMap;
+            return __atomic_load_n(&m_lentBytes, __ATOMIC_ACQUIRE);
         }
 
-        inline static Mutex m_mapLock;
+        std::size_t queued_bytes()
+        {
+            return m_queue.size() + lent_bytes();
+        }
 
-        /*bool is_queue_empty()
+        /**
+         * Waits on a queue until blocked returns false or the socket disconnects.
+         *
+         * @return whether the socket is still connected.
+         */
+        template<typename F>
+        bool wait_while(Task::WaitQueue& queue, bool shouldNotBlock, F blocked)
         {
-            return m_queueFront == m_queueBack;
+            Task::WaitQueue::Item wqitem = queue.add_to_queue();
+
+            while (m_connected && blocked()) {
+                if (shouldNotBlock)
+                    break;
+                Task::Manager::instance().block();
+                Task::Manager::instance().about_to_block();
+            }
+            queue.remove_from_queue(wqitem);
+            return m_connected;
         }
 
-        bool is_queue_full()
+        static Common::Hashmap<Common::String, LocalSocket*>& bind_map()
         {
-            return (m_queueBack + 1) % QUEUE_SIZE == m_queueFront;
-        }*/
+            static Common::Hashmap<Common::String, LocalSocket*> bindMap;
+            return bindMap;
+        }
+
+        inline static Mutex m_mapLock{LOCK_CLASS("Sockets::LocalSocket::m_mapLock")};
+
+        Mutex m_lock{LOCK_CLASS("Sockets::LocalSocket::m_lock")};
 
-        Mutex m_lock;
+        Common::String m_identifier;
 
-        char m_identifier[256];
+        // The queue is lock-free between one reader and one writer, so these only
+        // serialise readers against readers and writers against writers.
+        Mutex m_readLock{LOCK_CLASS("Sockets::LocalSocket::m_readLock")};
+        Mutex m_writeLock{LOCK_CLASS("Sockets::LocalSocket::m_writeLock")};
 
-        //char m_queue[QUEUE_SIZE];
-        //int m_queueFront = 0;
-        //int m_queueBack = 0;
+        Common::SPSCRing<uint8_t, QUEUE_SIZE> m_queue;
 
-        Common::FixedCircularBuffer<QUEUE_SIZE> m_queue;
+        // Loans are pushed by the writer and popped by the reader. The byte counts
+        // through the queue order them against queued data.
+        Common::Deque<Loan> m_loans;
+        Spinlock m_loanLock{LOCK_CLASS("Sockets::LocalSocket::m_loanLock")};
+        std::size_t m_lentBytes = 0;
+        uint64_t m_queueBytesWritten = 0;
+        uint64_t m_queueBytesRead = 0;
 
         LocalSocket* m_endpoint = nullptr;
 
@@ -100,6 +182,12 @@ namespace Sockets
         bool m_connected = false;
         bool m_listening = false;
         bool m_shouldNotBlock = true;
+        bool m_zeroCopy = false;
+        // Whether the queue holds messages rather than a byte stream. Writers frame
+        // data to match the socket they write to.
+        bool m_seqpacket = false;
+        // Set when a message did not fit, so the reader raises WRITEABLE once it frees space.
+        bool m_writeRefused = false;
         Task::TaskID m_tid = 0;
 
         Task::WaitQueue m_readWaitQueue;
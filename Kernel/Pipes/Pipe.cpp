@@ -26,13 +26,13 @@ namespace Pipes
 
 namespace
 {
-    static Common::Hashmap<Common::HashableString, DeviceOperations*>* pipeDevices;
+    static Common::Hashmap<Common::String, DeviceOperations*>* pipeDevices;
     static Spinlock lock;
 }
 
 void initialise()
 {
-    pipeDevices = new Common::Hashmap<Common::HashableString, DeviceOperations*>();
+    pipeDevices = new Common::Hashmap<Common::String, DeviceOperations*>();
 }
 
 void register_device(const char* device, DeviceOperations* ops)
@@ -115,6 +115,46 @@ std::size_t Pipe::write(std::size_t count, const void* buf)
     return writeCount;
 }
 
+std::size_t Pipe::readv(const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount)
+{
+    if (!has_active_connection())
+        return 0;
+
+    std::size_t readCount = 0;
+    if (m_device->readv) {
+        readCount = m_device->readv(m_offset, vectors, vectorCount, m_deviceSpecific);
+    } else if (m_device->read) {
+        for (std::size_t i = 0; i < vectorCount; i++) {
+            auto count = m_device->read(m_offset + readCount, vectors[i].length, vectors[i].base, m_deviceSpecific);
+            readCount += count;
+            if (count < vectors[i].length)
+                break;
+        }
+    }
+    seek(readCount, xpOS::API::Pipes::SeekType::CUR);
+    return readCount;
+}
+
+std::size_t Pipe::writev(const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount)
+{
+    if (!has_active_connection())
+        return 0;
+
+    std::size_t writeCount = 0;
+    if (m_device->writev) {
+        writeCount = m_device->writev(m_offset, vectors, vectorCount, m_deviceSpecific);
+    } else if (m_device->write) {
+        for (std::size_t i = 0; i < vectorCount; i++) {
+            auto count = m_device->write(m_offset + writeCount, vectors[i].length, vectors[i].base, m_deviceSpecific);
+            writeCount += count;
+            if (count < vectors[i].length)
+                break;
+        }
+    }
+    seek(writeCount, xpOS::API::Pipes::SeekType::CUR);
+    return writeCount;
+}
+
 std::size_t Pipe::seek(long count, xpOS::API::Pipes::SeekType type)
 {
     using T = xpOS::API::Pipes::SeekType;
@@ -131,14 +171,72 @@ std::size_t Pipe::seek(long count, xpOS::API::Pipes::SeekType type)
     return m_offset;
 }
 
+std::size_t Pipe::splice(Pipe& destination, std::size_t count)
+{
+    if (!has_active_connection() || !destination.has_active_connection())
+        return 0;
+
+    if (m_device->resident) {
+        auto available = count;
+        if (auto* data = m_device->resident(m_offset, available, m_deviceSpecific)) {
+            auto writeCount = destination.write(available, data);
+            seek(writeCount, xpOS::API::Pipes::SeekType::CUR);
+            return writeCount;
+        }
+    }
+
+    static constexpr std::size_t CHUNK_SIZE = 16384;
+    auto* buffer = new uint8_t[CHUNK_SIZE];
+    std::size_t splicedCount = 0;
+    while (splicedCount < count) {
+        auto chunk = count - splicedCount < CHUNK_SIZE ? count - splicedCount : CHUNK_SIZE;
+        if (destination.m_device->space) {
+            auto space = destination.m_device->space(destination.m_deviceSpecific);
+            if (space == 0)
+                break;
+            if (chunk > space)
+                chunk = space;
+        }
+        auto readCount = read(chunk, buffer);
+        if (readCount == 0)
+            break;
+
+        // Blocking destinations may still take a chunk a part at a time.
+        std::size_t writeCount = 0;
+        while (writeCount < readCount) {
+            auto written = destination.write(readCount - writeCount, buffer + writeCount);
+            if (written == 0)
+                break;
+            writeCount += written;
+        }
+        splicedCount += writeCount;
+        if (writeCount < readCount) {
+            seek(-static_cast<long>(readCount - writeCount), xpOS::API::Pipes::SeekType::CUR);
+            break;
+        }
+        if (readCount < chunk)
+            break;
+    }
+    delete[] buffer;
+    return splicedCount;
+}
+
 xpOS::API::Pipes::PipeInfo Pipe::info()
 {
-    if (!has_active_connection() || !m_device->write)
+    if (!has_active_connection() || !m_device->info)
         return {};
     
     return m_device->info(m_deviceSpecific);
 }
 
+void* Pipe::mmap(std::size_t offset, std::size_t count, int flags)
+{
+    if (!has_active_connection() || !m_device->mmap)
+        return nullptr;
+
+    return m_device->mmap(offset, count, flags, m_deviceSpecific);
+}
+
 void Pipe::raise_event(void* listener, EventTypeMask event)
 {
     auto* pipe = static_cast<Pipe*>(listener);
@@ -150,6 +248,17 @@ void Pipe::raise_event(void* listener, EventTypeMask event)
     }
 }
 
+EventTypeMask Pipe::poll()
+{
+    if (!has_active_connection() || !m_device->notify)
+        return 0;
+
+    // Devices only report the current events when there is no listener to add.
+    EventTypeMask current = 0;
+    m_device->notify(nullptr, nullptr, current, m_deviceSpecific);
+    return current;
+}
+
 PipeNotifReg Pipe::notify(EventTypeMask eventMask, void* listener, wake_listener_callback callback, uint64_t pd, EventTypeMask& currentMask)
 {
     LockAcquirer a(m_notifyLock);
@@ -20,11 +20,13 @@
 #define PIPE_H
 
 #include <cstdint>
+#include <utility>
 
 #include "API/Pipes.h"
 #include "Pipes/EventType.h"
 #include "Pipes/EventListenerList.h"
 #include "Common/List.h"
+#include "Common/ObjectCache.h"
 #include "Common/Optional.h"
 #include "Tasks/Mutex.h"
 
@@ -41,6 +43,11 @@ typedef std::size_t (*write_callback)(std::size_t offset, std::size_t count, con
 typedef EventListenerList::Receipt (*notify_callback)(void* listener, raise_events_callback raise_event, EventTypeMask& current, void*& deviceSpecific);
 typedef void (*denotify_callback)(EventListenerList::Receipt, void*& deviceSpecific);
 typedef xpOS::API::Pipes::PipeInfo (*info_callback)(void*& deviceSpecific);
+typedef void* (*mmap_callback)(std::size_t offset, std::size_t count, int flags, void*& deviceSpecific);
+typedef std::size_t (*readv_callback)(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific);
+typedef std::size_t (*writev_callback)(std::size_t offset, const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount, void*& deviceSpecific);
+typedef const void* (*resident_callback)(std::size_t offset, std::size_t& count, void*& deviceSpecific);
+typedef std::size_t (*space_callback)(void*& deviceSpecific);
 
 struct Listener
 {
@@ -66,6 +73,15 @@ struct DeviceOperations
     notify_callback notify;
     denotify_callback denotify;
     info_callback info;
+    mmap_callback mmap;
+    readv_callback readv;
+    writev_callback writev;
+    // Returns the device's contents from the offset if they are held in kernel memory,
+    // lowering count to how many bytes of them there are.
+    resident_callback resident;
+    // Returns how many bytes a write would take right now, for devices that can take
+    // less than they are given instead of blocking.
+    space_callback space;
 };
 
 void register_device(const char* device, DeviceOperations* ops);
@@ -88,10 +104,48 @@ public:
     ~Pipe();
 
     friend void swap(Pipe& a, Pipe& b);
+
+    static void* operator new(std::size_t) { return Common::ObjectCache<Pipe>::instance().allocate(); }
+    static void operator delete(void* ptr) { Common::ObjectCache<Pipe>::instance().free(ptr); }
+
     std::size_t read(std::size_t count, void* buf);
     std::size_t write(std::size_t count, const void* buf);
+    /**
+     * Reads into each buffer in turn, stopping at the first one that is not filled.
+     * Devices without a readv operation are read once per buffer.
+     */
+    std::size_t readv(const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount);
+    /**
+     * Writes each buffer in turn, stopping at the first one that is not written
+     * completely. Devices without a writev operation are written once per buffer.
+     */
+    std::size_t writev(const xpOS::API::Pipes::IOVector* vectors, std::size_t vectorCount);
     std::size_t seek(long count, xpOS::API::Pipes::SeekType type);
     xpOS::API::Pipes::PipeInfo info();
+    /**
+     * Asks the device which events are raised now, without registering for them.
+     */
+    EventTypeMask poll();
+    /**
+     * Maps part of the underlying object into the current task's address space.
+     * 
+     * @return the address the byte at the offset is mapped to, or nullptr if the
+     * device does not support mapping.
+     */
+    void* mmap(std::size_t offset, std::size_t count, int flags);
+    /**
+     * Moves up to count bytes from this pipe into the destination without passing
+     * through userspace. Resident devices are written to the destination straight
+     * from memory, and others are read a chunk at a time into a kernel buffer.
+     *
+     * Reads are limited to the space the destination reports, so nothing is read that
+     * it will not take, and what was read is written until the destination stops taking
+     * any. If it stops short, the offset is moved back by the difference, which devices
+     * that ignore the offset, such as sockets, cannot undo.
+     *
+     * @return the number of bytes written to the destination.
+     */
+    std::size_t splice(Pipe& destination, std::size_t count);
 
     bool has_active_connection() 
     {
@@ -103,7 +157,23 @@ public:
         return m_deviceSpecific;
     }
 
+    /**
+     * Pipes start with one reference, held by whoever opened them, and are deleted
+     * when the last is dropped. See PipeHandle.
+     */
+    void retain()
+    {
+        __atomic_add_fetch(&m_references, 1, __ATOMIC_RELAXED);
+    }
+
+    void release()
+    {
+        if (__atomic_sub_fetch(&m_references, 1, __ATOMIC_ACQ_REL) == 0)
+            delete this;
+    }
+
 private:
+    std::size_t m_references = 1;
     void* m_deviceSpecific;
     bool m_isOpen = false;
     DeviceOperations* m_device;
@@ -121,6 +191,71 @@ private:
     Mutex m_notifyLock;
 };
 
+/**
+ * Holds a reference to a pipe, so it stays open for as long as the handle exists
+ * even if its descriptor is closed meanwhile.
+ */
+class PipeHandle
+{
+public:
+    PipeHandle() = default;
+
+    /**
+     * Takes over a reference the caller already holds.
+     */
+    explicit PipeHandle(Pipe* pipe)
+        : m_pipe(pipe)
+    {}
+
+    PipeHandle(const PipeHandle& other)
+        : m_pipe(other.m_pipe)
+    {
+        if (m_pipe)
+            m_pipe->retain();
+    }
+
+    PipeHandle(PipeHandle&& other)
+        : m_pipe(other.m_pipe)
+    {
+        other.m_pipe = nullptr;
+    }
+
+    PipeHandle& operator=(PipeHandle other)
+    {
+        std::swap(m_pipe, other.m_pipe);
+        return *this;
+    }
+
+    ~PipeHandle()
+    {
+        if (m_pipe)
+            m_pipe->release();
+    }
+
+    explicit operator bool() const
+    {
+        return m_pipe != nullptr;
+    }
+
+    Pipe* get() const
+    {
+        return m_pipe;
+    }
+
+    Pipe* operator->() const
+    {
+        return m_pipe;
+    }
+
+    Pipe& operator*() const
+    {
+        return *m_pipe;
+    }
+
+private:
+    Pipe* m_pipe = nullptr;
+};
+
 }
 
 #endif
\ No newline at end of file
@@ -19,7 +19,7 @@
 #ifndef SOCKET_H
 #define SOCKET_H
 
-#include "Common/CircularBuffer.h"
+#include "Common/RingBuffer.h"
 #include "Common/Hashmap.h"
 #include "Common/Expected.h"
 #include "Common/String.h"
@@ -75,7 +75,7 @@ private:
 
     char m_identifier[256];
 
-    Common::FixedCircularBuffer<QUEUE_SIZE> m_queue;
+    Common::SPSCRing<uint8_t, QUEUE_SIZE> m_queue;
 
     LocalSocket* m_endpoint = nullptr;
 
@@ -31,6 +31,47 @@
 
 /// FIXME: Validate these syscalls so that everything is checked
 
+namespace
+{
+    /**
+     * Kernel writes to read-only user pages fault, so buffers the kernel fills in are checked first.
+     */
+    bool is_writeable_user_buffer(uint64_t buf, std::size_t count)
+    {
+        auto task = Task::Manager::instance().get_current_task();
+        return Memory::Manager::instance().is_writeable_user_range(Memory::VirtualAddress(buf), count, *task->tlTable);
+    }
+
+    /**
+     * Buffers the kernel only reads from must still be user memory, or a task could
+     * have kernel memory written out to a pipe.
+     */
+    bool is_user_buffer(uint64_t buf, std::size_t count)
+    {
+        return Memory::Manager::is_user_range(Memory::VirtualAddress(buf), count);
+    }
+
+    /**
+     * Copies in the vectors of a scatter-gather syscall, refusing any that are not in user space.
+     */
+    bool copy_user_vectors(xpOS::API::Pipes::IOVector* copied, uint64_t vectors, uint64_t count)
+    {
+        if (!is_user_buffer(vectors, count * sizeof(xpOS::API::Pipes::IOVector)))
+            return false;
+        memcpy(copied, reinterpret_cast<const void*>(vectors), count * sizeof(xpOS::API::Pipes::IOVector));
+
+        std::size_t total = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            if (!is_user_buffer(reinterpret_cast<uint64_t>(copied[i].base), copied[i].length))
+                return false;
+            if (copied[i].length > SIZE_MAX - total)
+                return false;
+            total += copied[i].length;
+        }
+        return true;
+    }
+}
+
 uint64_t sleep_for_syscall(uint64_t duration)
 {
     Task::Manager::instance().sleep_for(duration);
@@ -41,6 +82,8 @@ uint64_t vmmap_syscall(uint64_t* address, uint64_t size, uint64_t hint, uint64_t
 {
     if (!(flags & 0x08))
         return -1;
+    if (!is_writeable_user_buffer(reinterpret_cast<uint64_t>(address), sizeof(*address)))
+        return -1;
 
     auto currentTask = Task::Manager::instance().get_current_task();
     auto region = (*currentTask->tlTable).acquire_available_region(size);
@@ -75,42 +118,95 @@ uint64_t popen_syscall(uint64_t dev, uint64_t with, uint64_t flags)
 
 uint64_t pread_syscall(uint64_t pd, uint64_t buf, uint64_t count)
 {
+    if (!is_writeable_user_buffer(buf, count))
+        return 0;
+
     auto task = Task::Manager::instance().get_current_task();
-    auto optPipe = (*task->openPipes).get(pd);
-    if (optPipe.has_value())
-        return (*optPipe)->read(count, reinterpret_cast<void*>(buf));
+    auto pipe = (*task->openPipes).get(pd);
+    if (pipe)
+        return pipe->read(count, reinterpret_cast<void*>(buf));
     else
         return 0;
 }
 
 uint64_t pwrite_syscall(uint64_t pd, uint64_t buf, uint64_t count)
 {
+    if (!is_user_buffer(buf, count))
+        return 0;
+
     auto task = Task::Manager::instance().get_current_task();
-    auto optPipe = (*task->openPipes).get(pd);
+    auto pipe = (*task->openPipes).get(pd);
 
-    if (optPipe.has_value())
-        return (*optPipe)->write(count, reinterpret_cast<void*>(buf));
+    if (pipe)
+        return pipe->write(count, reinterpret_cast<void*>(buf));
     else
         return 0;
 }
 
-uint64_t pclose_syscall(uint64_t pd)
+uint64_t preadv_syscall(uint64_t pd, uint64_t vectors, uint64_t count)
 {
+    if (count > xpOS::API::Pipes::MAX_IO_VECTORS)
+        return 0;
+
     auto task = Task::Manager::instance().get_current_task();
-    auto optPipe = (*task->openPipes).get(pd);
-    if (optPipe.has_value()) {
-        delete *optPipe;
-        (*task->openPipes).remove(pd);
+    auto pipe = (*task->openPipes).get(pd);
+    if (!pipe)
+        return 0;
+
+    // The vectors are copied so they cannot change while the device blocks.
+    xpOS::API::Pipes::IOVector copied[xpOS::API::Pipes::MAX_IO_VECTORS];
+    if (!copy_user_vectors(copied, vectors, count))
+        return 0;
+    for (uint64_t i = 0; i < count; i++) {
+        if (!is_writeable_user_buffer(reinterpret_cast<uint64_t>(copied[i].base), copied[i].length))
+            return 0;
     }
+    return pipe->readv(copied, count);
+}
+
+uint64_t pwritev_syscall(uint64_t pd, uint64_t vectors, uint64_t count)
+{
+    if (count > xpOS::API::Pipes::MAX_IO_VECTORS)
+        return 0;
+
+    auto task = Task::Manager::instance().get_current_task();
+    auto pipe = (*task->openPipes).get(pd);
+    if (!pipe)
+        return 0;
+
+    xpOS::API::Pipes::IOVector copied[xpOS::API::Pipes::MAX_IO_VECTORS];
+    if (!copy_user_vectors(copied, vectors, count))
+        return 0;
+    return pipe->writev(copied, count);
+}
+
+uint64_t psplice_syscall(uint64_t inPd, uint64_t outPd, uint64_t count)
+{
+    if (inPd == outPd)
+        return 0;
+
+    auto task = Task::Manager::instance().get_current_task();
+    auto in = (*task->openPipes).get(inPd);
+    auto out = (*task->openPipes).get(outPd);
+    if (!in || !out)
+        return 0;
+
+    return in->splice(*out, count);
+}
+
+uint64_t pclose_syscall(uint64_t pd)
+{
+    auto task = Task::Manager::instance().get_current_task();
+    (*task->openPipes).remove(pd);
     return 0;
 }
 
 long pseek_syscall(uint64_t pd, long offset, int type)
 {
     auto task = Task::Manager::instance().get_current_task();
-    auto optPipe = (*task->openPipes).get(pd);
-    if (optPipe.has_value())
-        return (*optPipe)->seek(offset, static_cast<xpOS::API::Pipes::SeekType>(type));
+    auto pipe = (*task->openPipes).get(pd);
+    if (pipe)
+        return pipe->seek(offset, static_cast<xpOS::API::Pipes::SeekType>(type));
     else
         return 0;
 }
@@ -118,76 +214,88 @@ long pseek_syscall(uint64_t pd, long offset, int type)
 uint64_t pinfo_syscall(uint64_t pd, uint64_t usrptr)
 {
     auto* pipeInfo = reinterpret_cast<xpOS::API::Pipes::PipeInfo*>(usrptr);
+    if (!is_writeable_user_buffer(usrptr, sizeof(*pipeInfo)))
+        return -1;
     auto task = Task::Manager::instance().get_current_task();
-    auto optPipe = (*task->openPipes).get(pd);
-    if (optPipe.has_value()) {
-        *pipeInfo = (*optPipe)->info();
+    auto pipe = (*task->openPipes).get(pd);
+    if (pipe) {
+        *pipeInfo = pipe->info();
         return 0;
     } else {
         return -1;
     }
 }
 
-uint64_t elistener_add_syscall(uint64_t listenerpd, uint64_t targetpd, uint64_t eventMask)
+uint64_t pmmap_syscall(uint64_t pd, uint64_t offset, uint64_t count, uint64_t flags)
+{
+    auto task = Task::Manager::instance().get_current_task();
+    auto pipe = (*task->openPipes).get(pd);
+    if (pipe)
+        return reinterpret_cast<uint64_t>(pipe->mmap(offset, count, flags));
+    else
+        return 0;
+}
+
+uint64_t elistener_add_syscall(uint64_t listenerpd, uint64_t targetpd, uint64_t eventMask, uint64_t cookie)
 {
     auto task = Task::Manager::instance().get_current_task();
-    auto optPipe = (*task->openPipes).get(listenerpd);
-    if (!optPipe.has_value())
+    auto pipe = (*task->openPipes).get(listenerpd);
+    if (!pipe)
         return 0;
     
-    auto optTargetPipe = (*task->openPipes).get(targetpd);
-    if (!optTargetPipe.has_value())
+    auto targetPipe = (*task->openPipes).get(targetpd);
+    if (!targetPipe)
         return 0;
     
-    Pipes::EventListener::add(**optPipe, *optTargetPipe, targetpd, eventMask);
+    Pipes::EventListener::add(*pipe, targetPipe.get(), targetpd, eventMask, cookie);
     return 1;
 }
 
 uint64_t elistener_remove_syscall(uint64_t listenerpd, uint64_t targetpd, uint64_t eventMask)
 {
     auto task = Task::Manager::instance().get_current_task();
-    auto optPipe = (*task->openPipes).get(listenerpd);
-    if (!optPipe.has_value())
+    auto pipe = (*task->openPipes).get(listenerpd);
+    if (!pipe)
         return 0;
     
-    auto optTargetPipe = (*task->openPipes).get(targetpd);
-    if (!optTargetPipe.has_value())
+    auto targetPipe = (*task->openPipes).get(targetpd);
+    if (!targetPipe)
         return 0;
-    Pipes::EventListener::remove(**optPipe, *optTargetPipe, targetpd, eventMask);
+    Pipes::EventListener::remove(*pipe, targetPipe.get(), targetpd, eventMask);
     return 1;
 }
 
 uint64_t nsock_bind(uint64_t pd, Networking::Endpoint endpoint)
 {
     auto task = Task::Manager::instance().get_current_task();
-    auto optPipe = (*task->openPipes).get(pd);
-    if (!optPipe.has_value())
+    auto pipe = (*task->openPipes).get(pd);
+    if (!pipe)
         return 0;
     
-    return Networking::NetworkSocket::bind(**optPipe, endpoint);
+    return Networking::NetworkSocket::bind(*pipe, endpoint);
 }
 
 uint64_t nsock_connect(uint64_t pd, Networking::Endpoint endpoint)
 {
     auto task = Task::Manager::instance().get_current_task();
-    auto optPipe = (*task->openPipes).get(pd);
-    if (!optPipe.has_value())
+    auto pipe = (*task->openPipes).get(pd);
+    if (!pipe)
         return 0;
     
-    return Networking::NetworkSocket::connect(**optPipe, endpoint);
+    return Networking::NetworkSocket::connect(*pipe, endpoint);
 }
 
 uint64_t lsock_accept(uint64_t pd)
 {
     auto task = Task::Manager::instance().get_current_task();
 
-    auto optPipe = (*task->openPipes).get(pd);
-    if (!optPipe.has_value())
+    auto pipe = (*task->openPipes).get(pd);
+    if (!pipe)
         return 0;
 
     auto* newPipe = new Pipes::Pipe("socket::local", nullptr, static_cast<Pipes::EventTypes>(Sockets::LocalSocket::Flags::NON_BLOCKING));
 
-    auto didCreate = Sockets::LocalSocket::accept(**optPipe, *newPipe);
+    auto didCreate = Sockets::LocalSocket::accept(*pipe, *newPipe);
     if (!didCreate) {
         delete newPipe;
         return 0;
@@ -199,33 +307,33 @@ uint64_t lsock_connect(uint64_t pd, const char* id)
 {
     auto task = Task::Manager::instance().get_current_task();
 
-    auto optPipe = (*task->openPipes).get(pd);
-    if (!optPipe.has_value())
+    auto pipe = (*task->openPipes).get(pd);
+    if (!pipe)
         return 0;
     
-    return Sockets::LocalSocket::connect(**optPipe, id);
+    return Sockets::LocalSocket::connect(*pipe, id);
 }
 
 uint64_t lsock_bind(uint64_t pd, const char* id)
 {
     auto task = Task::Manager::instance().get_current_task();
 
-    auto optPipe = (*task->openPipes).get(pd);
-    if (!optPipe.has_value())
+    auto pipe = (*task->openPipes).get(pd);
+    if (!pipe)
         return 0;
     
-    return Sockets::LocalSocket::bind(**optPipe, id);
+    return Sockets::LocalSocket::bind(*pipe, id);
 }
 
 uint64_t lsock_listen(uint64_t pd)
 {
     auto task = Task::Manager::instance().get_current_task();
 
-    auto optPipe = (*task->openPipes).get(pd);
-    if (!optPipe.has_value())
+    auto pipe = (*task->openPipes).get(pd);
+    if (!pipe)
         return 0;
     
-    return Sockets::LocalSocket::listen(**optPipe);
+    return Sockets::LocalSocket::listen(*pipe);
 }
 
 struct ThreadLaunchDescriptor
@@ -350,6 +458,12 @@ uint64_t Processes::syscall_handler(uint64_t arg1, uint64_t arg2, uint64_t arg3,
         return pread_syscall(arg1, arg2, arg3);
     case SYSCALL_PWRITE:
         return pwrite_syscall(arg1, arg2, arg3);
+    case SYSCALL_PREADV:
+        return preadv_syscall(arg1, arg2, arg3);
+    case SYSCALL_PWRITEV:
+        return pwritev_syscall(arg1, arg2, arg3);
+    case SYSCALL_PSPLICE:
+        return psplice_syscall(arg1, arg2, arg3);
     case SYSCALL_PCLOSE:
         return pclose_syscall(arg1);
     case SYSCALL_SLEEP_FOR:
@@ -361,7 +475,7 @@ uint64_t Processes::syscall_handler(uint64_t arg1, uint64_t arg2, uint64_t arg3,
     case SYSCALL_PSEEK:
         return pseek_syscall(arg1, arg2, arg3);
     case SYSCALL_ELISTENER_ADD:
-        return elistener_add_syscall(arg1, arg2, arg3);
+        return elistener_add_syscall(arg1, arg2, arg3, arg4);
     case SYSCALL_ELISTENER_REMOVE:
         return elistener_remove_syscall(arg1, arg2, arg3);
     case SYSCALL_LSOCK_ACCEPT:
@@ -384,6 +498,8 @@ uint64_t Processes::syscall_handler(uint64_t arg1, uint64_t arg2, uint64_t arg3,
         return pinfo_syscall(arg1, arg2);
     case SYSCALL_BOOTTICKS_MS:
         return boot_ticks_ms_syscall();
+    case SYSCALL_PMMAP:
+        return pmmap_syscall(arg1, arg2, arg3, arg4);
     }
     return 0;
 }
@@ -0,0 +1,164 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "Common/Vector.h"
+#include "Pipes/Pipe.h"
+#include "Tasks/LockStatistics.h"
+
+namespace LockStatistics
+{
+
+namespace
+{
+    Pipes::DeviceOperations deviceOperations;
+
+    int bucket_of(uint64_t cycles)
+    {
+        if (!cycles)
+            return 0;
+        int bucket = 63 - __builtin_clzll(cycles);
+        return bucket < xpOS::API::LockStatistics::HISTOGRAM_BUCKETS ? bucket : xpOS::API::LockStatistics::HISTOGRAM_BUCKETS - 1;
+    }
+
+    void update_max(uint64_t& max, uint64_t value)
+    {
+        auto current = __atomic_load_n(&max, __ATOMIC_RELAXED);
+        while (value > current && !__atomic_compare_exchange_n(&max, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    }
+
+    bool open(void*, int, void*&)
+    {
+        return true;
+    }
+
+    void close(void*&)
+    {
+    }
+
+    std::size_t read(std::size_t offset, std::size_t count, void* buf, void*&)
+    {
+        using xpOS::API::LockStatistics::LockInfo;
+
+        Common::Vector<LockInfo> snapshots;
+        LockClass::for_each([&](LockClass& lockClass) {
+            snapshots.push_back(lockClass.snapshot());
+        });
+
+        // Sort by wait time, then by acquisitions, so the most contended locks come first.
+        for (std::size_t i = 1; i < snapshots.size(); i++) {
+            auto info = snapshots[i];
+            auto j = i;
+            for (; j > 0; j--) {
+                auto& previous = snapshots[j - 1];
+                if (previous.waitCycles > info.waitCycles || (previous.waitCycles == info.waitCycles && previous.acquisitions >= info.acquisitions))
+                    break;
+                snapshots[j] = previous;
+            }
+            snapshots[j] = info;
+        }
+
+        auto size = snapshots.size() * sizeof(LockInfo);
+        if (offset >= size)
+            return 0;
+        if (count > size - offset)
+            count = size - offset;
+        memcpy(buf, reinterpret_cast<const char*>(snapshots.data()) + offset, count);
+        return count;
+    }
+
+    xpOS::API::Pipes::PipeInfo info(void*&)
+    {
+        std::size_t classes = 0;
+        LockClass::for_each([&](LockClass&) {
+            classes++;
+        });
+        return {
+            .size = classes * sizeof(xpOS::API::LockStatistics::LockInfo)
+        };
+    }
+}
+
+void LockClass::register_class()
+{
+    if (__atomic_test_and_set(&m_registered, __ATOMIC_RELAXED))
+        return;
+
+    auto* head = __atomic_load_n(&m_head, __ATOMIC_RELAXED);
+    do {
+        m_next = head;
+    } while (!__atomic_compare_exchange_n(&m_head, &head, this, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+void LockClass::record_acquire(uint64_t waitCycles, bool contended)
+{
+    if (!__atomic_load_n(&m_registered, __ATOMIC_RELAXED))
+        register_class();
+
+    __atomic_fetch_add(&m_acquisitions, 1, __ATOMIC_RELAXED);
+    if (!contended)
+        return;
+
+    __atomic_fetch_add(&m_contended, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m_waitCycles, waitCycles, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m_waitHistogram[bucket_of(waitCycles)], 1, __ATOMIC_RELAXED);
+    update_max(m_maxWaitCycles, waitCycles);
+}
+
+void LockClass::record_release(uint64_t holdCycles)
+{
+    __atomic_fetch_add(&m_holdCycles, holdCycles, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m_holdHistogram[bucket_of(holdCycles)], 1, __ATOMIC_RELAXED);
+    update_max(m_maxHoldCycles, holdCycles);
+}
+
+xpOS::API::LockStatistics::LockInfo LockClass::snapshot() const
+{
+    xpOS::API::LockStatistics::LockInfo info = {
+        .name = {},
+        .acquisitions = __atomic_load_n(&m_acquisitions, __ATOMIC_RELAXED),
+        .contended = __atomic_load_n(&m_contended, __ATOMIC_RELAXED),
+        .waitCycles = __atomic_load_n(&m_waitCycles, __ATOMIC_RELAXED),
+        .holdCycles = __atomic_load_n(&m_holdCycles, __ATOMIC_RELAXED),
+        .maxWaitCycles = __atomic_load_n(&m_maxWaitCycles, __ATOMIC_RELAXED),
+        .maxHoldCycles = __atomic_load_n(&m_maxHoldCycles, __ATOMIC_RELAXED),
+        .waitHistogram = {},
+        .holdHistogram = {}
+    };
+
+    for (int i = 0; i < xpOS::API::LockStatistics::NAME_LENGTH - 1 && m_name[i]; i++)
+        info.name[i] = m_name[i];
+
+    for (int i = 0; i < BUCKETS; i++) {
+        info.waitHistogram[i] = __atomic_load_n(&m_waitHistogram[i], __ATOMIC_RELAXED);
+        info.holdHistogram[i] = __atomic_load_n(&m_holdHistogram[i], __ATOMIC_RELAXED);
+    }
+    return info;
+}
+
+void initialise()
+{
+    deviceOperations = {
+        .open = open,
+        .close = close,
+        .read = read,
+        .info = info
+    };
+    Pipes::register_device("sys::lockstat", &deviceOperations);
+}
+
+}
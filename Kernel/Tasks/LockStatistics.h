@@ -0,0 +1,140 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef LOCKSTATISTICS_H
+#define LOCKSTATISTICS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "API/LockStatistics.h"
+
+/**
+ * Optional lock instrumentation, enabled by building with XPOS_LOCK_STATISTICS.
+ *
+ * Locks are grouped into named classes, and every lock in a class adds to the
+ * same counters. A lock is given a class with LOCK_CLASS:
+ *
+ *     Spinlock m_schedulerLock{LOCK_CLASS("Task::Manager::m_schedulerLock")};
+ *
+ * Unnamed locks fall into a "Spinlock" or "Mutex" class. Without
+ * XPOS_LOCK_STATISTICS, LOCK_CLASS is nullptr and locks carry no extra state.
+ */
+namespace LockStatistics
+{
+    /**
+     * A string literal that can be used as a template argument.
+     */
+    template<std::size_t N>
+    struct Name
+    {
+        constexpr Name(const char (&string)[N])
+        {
+            for (std::size_t i = 0; i < N; i++)
+                value[i] = string[i];
+        }
+
+        char value[N];
+    };
+
+#ifdef XPOS_LOCK_STATISTICS
+    static inline uint64_t read_timestamp_counter()
+    {
+        uint32_t low, high;
+        asm volatile ("rdtsc" : "=a"(low), "=d"(high));
+        return (static_cast<uint64_t>(high) << 32) | low;
+    }
+
+    class LockClass
+    {
+    public:
+        constexpr LockClass(const char* name)
+            : m_name(name)
+        {}
+
+        LockClass(const LockClass&) = delete;
+        LockClass& operator=(const LockClass&) = delete;
+
+        /**
+         * Called once the lock is held, with how long it took to acquire.
+         */
+        void record_acquire(uint64_t waitCycles, bool contended);
+
+        /**
+         * Called just before the lock is released, with how long it was held.
+         */
+        void record_release(uint64_t holdCycles);
+
+        xpOS::API::LockStatistics::LockInfo snapshot() const;
+
+        /**
+         * Calls f on every class that has been acquired at least once.
+         */
+        template<typename F>
+        static void for_each(F f)
+        {
+            for (auto* lockClass = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE); lockClass; lockClass = lockClass->m_next)
+                f(*lockClass);
+        }
+
+    private:
+        static constexpr int BUCKETS = xpOS::API::LockStatistics::HISTOGRAM_BUCKETS;
+
+        /**
+         * Classes add themselves to the list on first use, so they can be
+         * constant-initialised and need no registration at boot.
+         */
+        void register_class();
+
+        inline static LockClass* m_head = nullptr;
+
+        const char* m_name;
+        LockClass* m_next = nullptr;
+        bool m_registered = false;
+        uint64_t m_acquisitions = 0;
+        uint64_t m_contended = 0;
+        uint64_t m_waitCycles = 0;
+        uint64_t m_holdCycles = 0;
+        uint64_t m_maxWaitCycles = 0;
+        uint64_t m_maxHoldCycles = 0;
+        uint64_t m_waitHistogram[BUCKETS] = {};
+        uint64_t m_holdHistogram[BUCKETS] = {};
+    };
+
+    /**
+     * The one class for each name, shared by every lock naming it.
+     */
+    template<Name name>
+    inline constinit LockClass lockClass(name.value);
+
+    /**
+     * Registers the sys::lockstat device.
+     */
+    void initialise();
+#else
+    class LockClass;
+#endif
+}
+
+#ifdef XPOS_LOCK_STATISTICS
+#define LOCK_CLASS(name) (&::LockStatistics::lockClass<::LockStatistics::Name(name)>)
+#else
+#define LOCK_CLASS(name) (nullptr)
+#endif
+
+#endif
@@ -21,10 +21,21 @@
 Mutex::Mutex()
     : m_acquired(false) {}
 
+Mutex::Mutex([[maybe_unused]] LockStatistics::LockClass* lockClass)
+    : m_acquired(false)
+#ifdef XPOS_LOCK_STATISTICS
+    , m_class(lockClass)
+#endif
+{}
+
 void Mutex::acquire()
 {
     if (!Task::Manager::is_executing())
         return;
+#ifdef XPOS_LOCK_STATISTICS
+    auto start = LockStatistics::read_timestamp_counter();
+    auto contended = false;
+#endif
     m_lock.acquire();
 
     if (m_acquired) {
@@ -33,17 +44,28 @@ void Mutex::acquire()
         m_waitingTasks.push_back(Task::Manager::instance().get_current_tid());
         m_lock.release();
         Task::Manager::instance().block();
+#ifdef XPOS_LOCK_STATISTICS
+        contended = true;
+#endif
     } else {
         m_acquired = true;
         m_lock.release();
     }
+#ifdef XPOS_LOCK_STATISTICS
+    // The mutex is handed to us by release(), so we own it here either way.
+    m_acquiredAt = LockStatistics::read_timestamp_counter();
+    m_class->record_acquire(m_acquiredAt - start, contended);
+#endif
 }
 
 void Mutex::release()
 {
     if (!Task::Manager::is_executing())
         return;
-    
+
+#ifdef XPOS_LOCK_STATISTICS
+    m_class->record_release(LockStatistics::read_timestamp_counter() - m_acquiredAt);
+#endif
     m_lock.acquire();
 
     auto it = m_waitingTasks.begin();
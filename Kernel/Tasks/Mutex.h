@@ -25,9 +25,18 @@ class Mutex
 {
     Common::List<Task::TaskID> m_waitingTasks;
     bool m_acquired;
-    Spinlock m_lock;
+    Spinlock m_lock{LOCK_CLASS("Mutex::m_lock")};
+#ifdef XPOS_LOCK_STATISTICS
+    LockStatistics::LockClass* m_class = LOCK_CLASS("Mutex");
+    uint64_t m_acquiredAt = 0;
+#endif
 public:
     Mutex();
+
+    /**
+     * Creates a mutex whose statistics are recorded under lockClass. See LOCK_CLASS.
+     */
+    explicit Mutex(LockStatistics::LockClass* lockClass);
     Mutex(const Mutex&) = delete;
     Mutex& operator=(const Mutex&) = delete;
     void acquire();
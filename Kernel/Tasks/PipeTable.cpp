@@ -0,0 +1,124 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "Pipes/Pipe.h"
+#include "Tasks/PipeTable.h"
+
+namespace Task
+{
+
+PipeTable::PipeTable(PipeTable&& other)
+{
+    // Tables are only moved while they are being set up, before anything else can see them.
+    m_slots = other.m_slots;
+    m_capacity = other.m_capacity;
+    m_used = other.m_used;
+    other.m_slots = nullptr;
+    other.m_capacity = 0;
+    other.m_used = nullptr;
+}
+
+PipeTable::~PipeTable()
+{
+    for (std::size_t i = 0; i < m_capacity; i++) {
+        if (m_slots[i])
+            m_slots[i]->release();
+    }
+    delete[] m_slots;
+    delete[] m_used;
+}
+
+uint64_t PipeTable::insert(Pipes::Pipe* pipe)
+{
+    LockAcquirer l(m_lock);
+    std::size_t index = m_capacity;
+    for (std::size_t word = 0; word < m_capacity / BITS_PER_WORD; word++) {
+        if (~m_used[word]) {
+            index = word * BITS_PER_WORD + __builtin_ctzll(~m_used[word]);
+            break;
+        }
+    }
+
+    if (index == m_capacity)
+        grow();
+
+    m_used[index / BITS_PER_WORD] |= 1ull << (index % BITS_PER_WORD);
+    __atomic_store_n(&m_slots[index], pipe, __ATOMIC_RELEASE);
+    return index + FIRST_DESCRIPTOR;
+}
+
+bool PipeTable::remove(uint64_t pipeId)
+{
+    Pipes::Pipe* pipe;
+    {
+        LockAcquirer l(m_lock);
+        auto index = pipeId - FIRST_DESCRIPTOR;
+        if (pipeId < FIRST_DESCRIPTOR || index >= m_capacity || !m_slots[index])
+            return false;
+
+        pipe = m_slots[index];
+        __atomic_store_n(&m_slots[index], nullptr, __ATOMIC_RELEASE);
+        m_used[index / BITS_PER_WORD] &= ~(1ull << (index % BITS_PER_WORD));
+    }
+
+    // Closing the pipe can block, so it is done after the lock is released.
+    pipe->release();
+    return true;
+}
+
+Pipes::PipeHandle PipeTable::get(uint64_t pipeId)
+{
+    // Nothing else can run until the reference is taken, so the pipe cannot be
+    // released and the slots cannot be freed under us.
+    InterruptDisabler disabler;
+    auto index = pipeId - FIRST_DESCRIPTOR;
+    if (pipeId < FIRST_DESCRIPTOR || index >= m_capacity)
+        return {};
+
+    auto* pipe = m_slots[index];
+    if (!pipe)
+        return {};
+
+    pipe->retain();
+    return Pipes::PipeHandle(pipe);
+}
+
+void PipeTable::grow()
+{
+    auto capacity = m_capacity ? m_capacity * 2 : INITIAL_CAPACITY;
+    auto* slots = new Pipes::Pipe*[capacity];
+    auto* used = new uint64_t[capacity / BITS_PER_WORD];
+    for (std::size_t i = 0; i < capacity; i++)
+        slots[i] = i < m_capacity ? m_slots[i] : nullptr;
+    for (std::size_t word = 0; word < capacity / BITS_PER_WORD; word++)
+        used[word] = word < m_capacity / BITS_PER_WORD ? m_used[word] : 0;
+
+    auto* oldSlots = m_slots;
+    auto* oldUsed = m_used;
+    {
+        // Lookups see either the old slots or the new ones, never a mix of the two.
+        InterruptDisabler disabler;
+        m_slots = slots;
+        m_capacity = capacity;
+        m_used = used;
+    }
+    delete[] oldSlots;
+    delete[] oldUsed;
+}
+
+}
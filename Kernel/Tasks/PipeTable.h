@@ -0,0 +1,88 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#ifndef XPOS_TASKS_PIPETABLE_H
+#define XPOS_TASKS_PIPETABLE_H
+
+#include <cstdint>
+
+#include "Tasks/Spinlock.h"
+
+namespace Pipes
+{
+    class Pipe;
+    class PipeHandle;
+}
+
+namespace Task
+{
+
+/**
+ * The pipes a task has open, indexed by their descriptors.
+ *
+ * Descriptors index a dense array of slots, and the lowest free slot is handed out
+ * first, found through a bitmap of the slots in use. Inserting and removing take a
+ * lock, but looking up a pipe does not: it runs with interrupts disabled, so it
+ * cannot be interleaved with a descriptor being closed or the slots being replaced.
+ */
+class PipeTable
+{
+public:
+    PipeTable() = default;
+    PipeTable(const PipeTable&) = delete;
+    PipeTable& operator=(const PipeTable&) = delete;
+    PipeTable(PipeTable&& other);
+    ~PipeTable();
+
+    /**
+     * Takes over the caller's reference to the pipe.
+     *
+     * @return the pipe's descriptor.
+     */
+    uint64_t insert(Pipes::Pipe* pipe);
+
+    /**
+     * Drops the table's reference to the pipe, which is closed once no other
+     * handle to it remains.
+     */
+    bool remove(uint64_t pipeId);
+
+    /**
+     * @return a handle to the pipe, or an empty handle if the descriptor is not open.
+     */
+    Pipes::PipeHandle get(uint64_t pipeId);
+
+private:
+    // 0 is returned when a descriptor cannot be created, and 1 and 2 are kept for
+    // the standard streams.
+    static constexpr uint64_t FIRST_DESCRIPTOR = 3;
+    static constexpr std::size_t INITIAL_CAPACITY = 64;
+    static constexpr std::size_t BITS_PER_WORD = 64;
+
+    void grow();
+
+    Pipes::Pipe** m_slots = nullptr;
+    std::size_t m_capacity = 0;
+    // A set bit marks a slot in use. Only accessed with the lock held.
+    uint64_t* m_used = nullptr;
+    Spinlock m_lock{LOCK_CLASS("Task::PipeTable::m_lock")};
+};
+
+}
+
+#endif
@@ -31,7 +31,16 @@ void Spinlock::acquire()
 {
     // We want to count the number of spinlocks acquired so that we only re-enable interrupts when all are released.
     push_cli();
+#ifdef XPOS_LOCK_STATISTICS
+    auto start = LockStatistics::read_timestamp_counter();
+    auto contended = false;
+    while (__atomic_test_and_set(&m_locked, __ATOMIC_SEQ_CST))
+        contended = true;
+    m_acquiredAt = LockStatistics::read_timestamp_counter();
+    m_class->record_acquire(m_acquiredAt - start, contended);
+#else
     while (__atomic_test_and_set(&m_locked, __ATOMIC_SEQ_CST));
+#endif
 }
 
 bool Spinlock::try_acquire()
@@ -43,11 +52,18 @@ bool Spinlock::try_acquire()
         pop_cli();
         return false;
     }
+#ifdef XPOS_LOCK_STATISTICS
+    m_acquiredAt = LockStatistics::read_timestamp_counter();
+    m_class->record_acquire(0, false);
+#endif
     return true;
 }
 
 void Spinlock::release()
 {
+#ifdef XPOS_LOCK_STATISTICS
+    m_class->record_release(LockStatistics::read_timestamp_counter() - m_acquiredAt);
+#endif
     __atomic_clear(&m_locked, __ATOMIC_SEQ_CST);
     pop_cli();
 }
@@ -21,19 +21,57 @@
 
 #include <cstdint>
 
+#include "Tasks/LockStatistics.h"
+
 class Spinlock
 {
 public:
     static uint64_t m_cli;
     static bool m_shouldRestore;
     volatile uint64_t m_locked = 0;
-    void pop_cli();
-    void push_cli();
+    static void pop_cli();
+    static void push_cli();
 public:
+    constexpr Spinlock() = default;
+
+    /**
+     * Creates a spinlock whose statistics are recorded under lockClass. See LOCK_CLASS.
+     */
+    constexpr explicit Spinlock([[maybe_unused]] LockStatistics::LockClass* lockClass)
+#ifdef XPOS_LOCK_STATISTICS
+        : m_class(lockClass)
+#endif
+    {}
+
     void acquire();
     void release();
     bool try_acquire();
     bool is_acquired();
+#ifdef XPOS_LOCK_STATISTICS
+private:
+    LockStatistics::LockClass* m_class = LOCK_CLASS("Spinlock");
+    uint64_t m_acquiredAt = 0;
+#endif
+};
+
+/**
+ * Disables interrupts on the local processor while in scope, nesting with any spinlocks held.
+ */
+class InterruptDisabler
+{
+public:
+    InterruptDisabler()
+    {
+        Spinlock::push_cli();
+    }
+
+    InterruptDisabler(const InterruptDisabler&) = delete;
+    InterruptDisabler& operator=(const InterruptDisabler&) = delete;
+
+    ~InterruptDisabler()
+    {
+        Spinlock::pop_cli();
+    }
 };
 
 template <typename LockType>
@@ -23,17 +23,14 @@
 
 #include "Common/Hashmap.h"
 #include "Common/List.h"
+#include "Common/ObjectCache.h"
 #include "Common/Optional.h"
 #include "Common/ReferenceCounting.h"
 #include "Memory/AddressSpace.h"
 #include "Memory/MemoryManager.h"
+#include "Tasks/PipeTable.h"
 #include "Tasks/WaitQueue.h"
 
-namespace Pipes
-{
-    class Pipe;
-}
-
 namespace Task
 {
 
@@ -63,34 +60,6 @@ private:
     Common::Hashmap<uint64_t, T> m_hashmap;
 };
 
-class PipeTable
-{
-public:
-    auto insert(Pipes::Pipe* pipe)
-    {
-        auto pair = m_hashmap.insert({m_nextAvailID++, pipe});
-        return pair.first->first;
-    }
-
-    void remove(uint64_t id)
-    {
-        m_hashmap.erase(id);
-    }
-
-    Common::Optional<Pipes::Pipe*> get(uint64_t pipeId)
-    {
-        auto it = m_hashmap.find(pipeId);
-        if (it != m_hashmap.end())
-            return it->second;
-        else
-            return Common::Nullopt;
-    }
-
-private:
-    uint64_t m_nextAvailID = 3;
-    Common::Hashmap<uint64_t, Pipes::Pipe*> m_hashmap;
-};
-
 template <typename T>
 using ARC = Common::AutomaticReferenceCountable<T>;
 
@@ -105,7 +74,8 @@ struct Task
     {
         NOT_STARTED,
         READY,
-        WAIT
+        WAIT,
+        EXITED
     };
 
     ARC<Memory::RegionableVirtualAddressSpace> tlTable;
@@ -123,6 +93,9 @@ struct Task
 
     Spinlock stateLock;
 
+    static void* operator new(std::size_t) { return Common::ObjectCache<Task>::instance().allocate(); }
+    static void operator delete(void* ptr) { Common::ObjectCache<Task>::instance().free(ptr); }
+
 private: 
     Task(
         ARC<Memory::RegionableVirtualAddressSpace> rvas,
@@ -140,10 +113,15 @@ struct Group
     GroupID groupId;
     int priority;
     bool scheduled = false;
+    // Tasks in the group that have not been reaped, whatever their state.
+    std::size_t taskCount = 0;
     Common::List<TaskID> readyTasks;
     
     Common::Hashmap<uintptr_t, WaitQueue*> futexWaitQueues;
     Spinlock futexLock;
+
+    static void* operator new(std::size_t) { return Common::ObjectCache<Group>::instance().allocate(); }
+    static void operator delete(void* ptr) { Common::ObjectCache<Group>::instance().free(ptr); }
 };
 
 }
@@ -19,6 +19,10 @@
 #include "Arch/CPU.h"
 #include "Arch/IO/PIT.h"
 #include "Arch/TSS.h"
+#ifdef XPOS_MEMORY_LEAK_CHECK
+#include "API/SharedMemory.h"
+#include "Pipes/Pipe.h"
+#endif
 #include "Memory/AddressSpace.h"
 #include "Memory/MemoryManager.h"
 #include "Tasks/Scheduler.h"
@@ -31,25 +35,33 @@ namespace Task
 
 extern "C" void enable_syscall_sysret();
 
-extern "C" void switch_to_not_started_task(void** kstack, void* tlTable, void* entryPoint, void** kstackOld, void* cleanUpCallback, void* launchParam);
-extern "C" void switch_to_ready_task(void** kstack, void* tlTable, void** kstackOld);
+extern "C" void switch_to_not_started_task(void** kstack, uint64_t tlTable, void* entryPoint, void** kstackOld, void* cleanUpCallback, void* launchParam);
+extern "C" void switch_to_ready_task(void** kstack, uint64_t tlTable, void** kstackOld);
 
+constinit Manager Manager::m_instance;
 bool Manager::m_isActive = false;
 
+namespace
+{
+    // Reaping runs ahead of ordinary tasks, so an exited task's memory is returned
+    // before anything else can run short of it.
+    constexpr int REAPER_PRIORITY = 128;
+}
+
 void Manager::initialise(Scheduler* scheduler)
 {
     enable_syscall_sysret();
-    constexpr int sizeOfStack = Memory::PAGE_4KiB * 32;
     auto stackBottom = START_OF_PROCESS_KSTACKS;
     // Allocate a safe kernel stack for processes to use.
-    for (int i = 0; i < sizeOfStack; i += Memory::PAGE_4KiB) {
+    for (int i = 0; i < SIZE_OF_KSTACK; i += Memory::PAGE_4KiB) {
         Memory::VirtualMemoryAllocationRequest request(Memory::VirtualAddress(stackBottom + i), true);
         Memory::Manager::instance().alloc_page(request);
     }
 
-    CPU::set_ring_stack_pointer(Memory::VirtualAddress(START_OF_PROCESS_KSTACKS + sizeOfStack).get(), CPU::Ring::KERNEL);
+    CPU::set_ring_stack_pointer(Memory::VirtualAddress(START_OF_PROCESS_KSTACKS + SIZE_OF_KSTACK).get(), CPU::Ring::KERNEL);
     CPU::refresh_task_state_segment();
     m_scheduler = scheduler;
+    m_reaperTid = launch_kernel_process(reinterpret_cast<void*>(&reap_exited_tasks), nullptr, REAPER_PRIORITY);
 }
 
 TaskID Manager::launch_task(TaskDescriptor taskDescriptor)
@@ -64,13 +76,12 @@ TaskID Manager::launch_task(TaskDescriptor taskDescriptor)
 
     // At the moment, task stacks are allocated contiguously so we can allocate the stack at a position based on the task id.
     /// FIXME: We should have 8MiB stacks in some region of the address space, and the page fault handler should allocate pages for this.
-    constexpr int sizeOfStack = Memory::PAGE_4KiB * 32;
-    auto stackBottom = (START_OF_PROCESS_KSTACKS + sizeOfStack * (task->tid));
-    for (int i = 0; i < sizeOfStack; i += Memory::PAGE_4KiB)
+    auto stackBottom = (START_OF_PROCESS_KSTACKS + SIZE_OF_KSTACK * (task->tid));
+    for (int i = 0; i < SIZE_OF_KSTACK; i += Memory::PAGE_4KiB)
         Memory::Manager::instance().alloc_page(Memory::VirtualMemoryAllocationRequest(Memory::VirtualAddress(stackBottom + i), true));
 
     // We need to map a safe kernel stack and the task's kernel stack into the task's address space.
-    for (int i = 0; i < sizeOfStack; i += Memory::PAGE_4KiB) {
+    for (int i = 0; i < SIZE_OF_KSTACK; i += Memory::PAGE_4KiB) {
         Memory::VirtualMemoryMapRequest memoryMapRequest = {
             .physicalAddress = Memory::Manager::instance().get_physical_address(START_OF_PROCESS_KSTACKS + i),
             .virtualAddress = Memory::VirtualAddress(START_OF_PROCESS_KSTACKS + i),
@@ -85,7 +96,7 @@ TaskID Manager::launch_task(TaskDescriptor taskDescriptor)
         Memory::Manager::instance().request_virtual_map(memoryMapRequest, *task->tlTable);
     }
     
-    task->kstack = reinterpret_cast<void*>(stackBottom + sizeOfStack);
+    task->kstack = reinterpret_cast<void*>(stackBottom + SIZE_OF_KSTACK);
     task->groupId = taskDescriptor.groupId;
     task->entryPoint = taskDescriptor.entryPoint;
     task->launchParam = taskDescriptor.launchParam;
@@ -105,6 +116,7 @@ TaskID Manager::launch_task(TaskDescriptor taskDescriptor)
             group = get_group_from_gid(task->groupId);
         }
 
+        group->taskCount++;
         group->readyTasks.push_back(task->tid);
 
         m_taskHashmap.insert({task->tid, task});
@@ -189,35 +201,36 @@ void Manager::refresh()
     Task* lastTask = nullptr;
     {
         LockAcquirer acquirer(Manager::instance().m_schedulerLock);
-        if (Manager::instance().m_schedulerChangingTask)
+        auto& processor = *m_processor;
+        if (processor.schedulerChangingTask)
             return;
         
-        if (Manager::instance().get_current_tid()) 
-            lastTask = Manager::instance().get_current_task();
-        
+        lastTask = processor.currentTask;
         
-        Manager::instance().m_schedulerChangingTask = true;
-        m_currentTask = Manager::instance().m_scheduler->get_next_task();
+        processor.schedulerChangingTask = true;
+        auto nextTid = Manager::instance().m_scheduler->get_next_task();
 
-        while (!m_currentTask) {
+        while (!nextTid) {
             // If no tasks are runnable, we enable interrupts as this is the only way a task can become runnable.
             m_schedulerLock.release();
             X86_64::sti();
             X86_64::hlt();
             X86_64::cli();
             m_schedulerLock.acquire();
-            m_currentTask = Manager::instance().m_scheduler->get_next_task();
+            nextTid = Manager::instance().m_scheduler->get_next_task();
         }
 
-        Manager::instance().m_schedulerChangingTask = false;
+        processor.currentTid = nextTid;
+        processor.currentTask = get_task_from_tid(nextTid);
+        processor.schedulerChangingTask = false;
     }
 
-    void* tlTable;
+    uint64_t tlTable;
     Task* task;
 
     task = get_current_task();
     
-    tlTable = (*task->tlTable).get_physical_address().get();
+    tlTable = Memory::Manager::instance().get_address_space_switch_value(*task->tlTable);
 
     Memory::VirtualAddress stackPointer = START_OF_PROCESS_KSTACKS + Memory::PAGE_4KiB * task->tid + Memory::PAGE_4KiB;
     CPU::set_ring_stack_pointer(stackPointer.get(), CPU::Ring::KERNEL);
@@ -283,7 +296,7 @@ void Manager::unblock(TaskID tid)
     LockAcquirer l(task->stateLock);
     task->blockFlag = false;
 
-    if (task->state == Task::State::READY) 
+    if (task->state == Task::State::READY || task->state == Task::State::EXITED)
         return;
     
     task->state = Task::State::READY;
@@ -301,7 +314,7 @@ void Manager::lockless_unblock(TaskID tid)
     LockAcquirer l(task->stateLock);
     task->blockFlag = false;
 
-    if (task->state == Task::State::READY)
+    if (task->state == Task::State::READY || task->state == Task::State::EXITED)
         return;
     
     task->state = Task::State::READY;
@@ -318,9 +331,155 @@ void Manager::task_cleanup()
 
 void Manager::terminate_task()
 {
-    /// FIXME: We should free up resources here.
-    about_to_block();
-    block();
+    auto* task = get_current_task();
+    // The pipes are shared by the whole group, so the last task to exit closes them.
+    // Closing returns the frames held by shared memory, mapped files and socket loans.
+    task->openPipes.reset();
+
+    {
+        // Holding the state lock keeps this task from being switched away from before
+        // the reaper is woken.
+        LockAcquirer l(task->stateLock);
+        task->state = Task::State::EXITED;
+        {
+            LockAcquirer acquirer(m_schedulerLock);
+            auto group = get_group_from_gid(task->groupId);
+            for (auto it = group->readyTasks.begin(); it != group->readyTasks.end(); it++) {
+                if (*it == task->tid) {
+                    group->readyTasks.erase(it);
+                    break;
+                }
+            }
+            m_scheduler->deschedule_current_task();
+            m_exitedTasks.push_back(task);
+        }
+        unblock(m_reaperTid);
+    }
+    refresh();
+}
+
+void Manager::reap_exited_tasks(void*)
+{
+    auto& manager = instance();
+    while (true) {
+        manager.about_to_block();
+        while (true) {
+            Task* task;
+            {
+                LockAcquirer acquirer(manager.m_schedulerLock);
+                if (manager.m_exitedTasks.size() == 0)
+                    break;
+                task = *manager.m_exitedTasks.begin();
+                manager.m_exitedTasks.erase(manager.m_exitedTasks.begin());
+            }
+            manager.reap(task);
+        }
+        manager.block();
+    }
+}
+
+void Manager::reap(Task* task)
+{
+    // The exited task has been switched away from, so nothing runs on its kernel stack.
+    // Other tasks in its group may still use its address space, which maps the stack.
+    auto& memoryManager = Memory::Manager::instance();
+    auto sharesMainTables = (*task->tlTable).get_physical_address().get() == memoryManager.get_main_address_space().get_physical_address().get();
+    auto stackBottom = START_OF_PROCESS_KSTACKS + SIZE_OF_KSTACK * task->tid;
+    for (int i = 0; i < SIZE_OF_KSTACK; i += Memory::PAGE_4KiB) {
+        if (!sharesMainTables)
+            memoryManager.request_virtual_unmap(Memory::VirtualMemoryUnmapRequest(Memory::VirtualAddress(stackBottom + i)), *task->tlTable);
+        memoryManager.free_page(Memory::VirtualMemoryFreeRequest(Memory::VirtualAddress(stackBottom + i)));
+    }
+
+    Group* emptyGroup = nullptr;
+    {
+        LockAcquirer acquirer(m_schedulerLock);
+        m_taskHashmap.erase(task->tid);
+        auto* group = get_group_from_gid(task->groupId);
+        if (--group->taskCount == 0) {
+            m_groupHashmap.erase(group->groupId);
+            emptyGroup = group;
+        }
+    }
+
+    // Dropping the last reference to the address space destroys it. The reaper runs in
+    // the main address space, so it is never the one loaded.
+    delete task;
+    if (emptyGroup) {
+        for (auto& futex : emptyGroup->futexWaitQueues)
+            delete futex.second;
+        delete emptyGroup;
+    }
+    m_reapedWaitQueue.wake_queue();
+}
+
+void Manager::join(TaskID tid)
+{
+    while (true) {
+        auto wqItem = m_reapedWaitQueue.add_to_queue();
+        bool reaped;
+        {
+            LockAcquirer acquirer(m_schedulerLock);
+            reaped = m_taskHashmap.find(tid) == m_taskHashmap.end();
+        }
+        if (!reaped)
+            block();
+        m_reapedWaitQueue.remove_from_queue(wqItem);
+        if (reaped)
+            return;
+    }
+}
+
+#ifdef XPOS_MEMORY_LEAK_CHECK
+namespace
+{
+    // Ahead of ordinary tasks, which would otherwise allocate while the check counts.
+    constexpr int LEAK_CHECK_PRIORITY = REAPER_PRIORITY;
+    constexpr std::size_t LEAK_CHECK_PAGES = 16;
+
+    void leak_check_task(void*)
+    {
+        auto* task = Manager::instance().get_current_task();
+        auto& addressSpace = *task->tlTable;
+        auto region = addressSpace.acquire_available_region(LEAK_CHECK_PAGES * Memory::PAGE_4KiB);
+        auto start = reinterpret_cast<uint64_t>(region.start);
+        for (auto page = start; page < start + LEAK_CHECK_PAGES * Memory::PAGE_4KiB; page += Memory::PAGE_4KiB)
+            Memory::Manager::instance().alloc_page(Memory::VirtualMemoryAllocationRequest(page, true, true), addressSpace);
+
+        // Left open for the task's exit to close.
+        xpOS::API::SharedMemory::LinkRequest request = {
+            .str = "leak-check",
+            .mappedTo = nullptr,
+            .length = LEAK_CHECK_PAGES * Memory::PAGE_4KiB
+        };
+        (*task->openPipes).insert(new Pipes::Pipe("shared_mem", &request, xpOS::API::SharedMemory::Flags::CREATE));
+    }
+
+    void run_leak_check_task()
+    {
+        auto tid = Manager::instance().launch_task({
+            .addressSpace = Memory::RegionableVirtualAddressSpace::create(),
+            .openPipes = ARC<PipeTable>(PipeTable()),
+            .entryPoint = reinterpret_cast<void*>(&leak_check_task),
+            .taskPriority = LEAK_CHECK_PRIORITY
+        });
+        Manager::instance().join(tid);
+    }
+
+    void check_task_teardown_task(void*)
+    {
+        // The first run fills the caches and heap that task bookkeeping comes from.
+        run_leak_check_task();
+        auto baseline = Memory::Manager::instance().get_free_physical_block_count();
+        run_leak_check_task();
+        KERNEL_ASSERT(Memory::Manager::instance().get_free_physical_block_count() == baseline);
+    }
+}
+
+void Manager::check_task_teardown()
+{
+    launch_kernel_process(reinterpret_cast<void*>(&check_task_teardown_task), nullptr, LEAK_CHECK_PRIORITY);
 }
+#endif
 
 }
@@ -19,6 +19,7 @@
 #ifndef TASKMANAGER_H
 #define TASKMANAGER_H
 
+#include "Arch/PerCPU.h"
 #include "Common/PriorityQueue.h"
 #include "Tasks/Scheduler.h"
 #include "Tasks/Task.h"
@@ -64,6 +65,19 @@ public:
         return m_taskHashmap.find(tid)->second;
     }
 
+    /**
+     * Returns the address space of a task, if it exists. The reference keeps the
+     * address space alive while the caller uses it.
+     */
+    Common::Optional<ARC<Memory::RegionableVirtualAddressSpace>> find_address_space(TaskID tid)
+    {
+        LockAcquirer acquirer(m_schedulerLock);
+        auto it = m_taskHashmap.find(tid);
+        if (it == m_taskHashmap.end())
+            return Common::Nullopt;
+        return it->second->tlTable;
+    }
+
     Group* get_group_from_gid(GroupID gid)
     {
         return m_groupHashmap.find(gid)->second;
@@ -75,12 +89,12 @@ public:
 
     TaskID get_current_tid()
     {
-        return m_currentTask;
+        return m_processor->currentTid;
     }
 
     Task* get_current_task()
     {
-        return m_currentTask != 0 ? get_task_from_tid(m_currentTask) : nullptr;
+        return m_processor->currentTask;
     }
 
     Group* get_current_group()
@@ -97,7 +111,17 @@ public:
 
     static void task_cleanup();
 
+    /**
+     * Ends the current task. Its pipes are closed once the rest of its group has
+     * exited, and its kernel stack and address space are freed once it has been
+     * switched away from for the last time.
+     */
     void terminate_task();
+
+    /**
+     * Blocks until the task has exited and been reaped.
+     */
+    void join(TaskID tid);
     /**
      * Put current task to sleep until a later time. 
      */ 
@@ -108,29 +132,59 @@ public:
     static void sleep_for(uint64_t duration);
 
     void initialise(Scheduler* scheduler);
+
+#ifdef XPOS_MEMORY_LEAK_CHECK
+    /**
+     * Launches a task that starts and ends tasks in address spaces of their own,
+     * asserting that the number of free physical blocks returns to its baseline
+     * once each has been reaped.
+     */
+    void check_task_teardown();
+#endif
     
     static Manager& instance()
     {
-        static Manager instance;
-        return instance;
+        return m_instance;
     }
 
 private:
-    Manager() {}
+    constexpr Manager() = default;
     void lockless_unblock(TaskID tid);
 
-    Scheduler* m_scheduler;
+    /**
+     * Frees exited tasks, which cannot free their own kernel stack or address
+     * space while still running on them.
+     */
+    static void reap_exited_tasks(void*);
+    void reap(Task* task);
+
+    /**
+     * The scheduling state of a processor.
+     */
+    struct ProcessorState
+    {
+        TaskID currentTid = 0;
+        Task* currentTask = nullptr;
+        bool schedulerChangingTask = false;
+    };
+
+    static Manager m_instance;
+
+    Scheduler* m_scheduler = nullptr;
     static bool m_isActive;
-    bool m_schedulerChangingTask = false;
+    PerCPU<ProcessorState> m_processor;
     std::size_t m_taskCount = 0;
     std::size_t m_groupCount = 0;
 
-    Spinlock m_sleepingTasksLock;
-    Spinlock m_schedulerLock;
+    Spinlock m_sleepingTasksLock{LOCK_CLASS("Task::Manager::m_sleepingTasksLock")};
+    Spinlock m_schedulerLock{LOCK_CLASS("Task::Manager::m_schedulerLock")};
 
-    TaskID m_currentTask = 0;
     Common::Hashmap<TaskID, Task*> m_taskHashmap;
     Common::Hashmap<GroupID, Group*> m_groupHashmap;
+    // Guarded by the scheduler lock.
+    Common::List<Task*> m_exitedTasks;
+    TaskID m_reaperTid = 0;
+    WaitQueue m_reapedWaitQueue;
 
     struct SleepingTask
     {
@@ -165,6 +219,7 @@ private:
     Common::PriorityQueue<SleepingTask> m_sleepingTasks;
     
     static constexpr uint64_t START_OF_PROCESS_KSTACKS = 0xFFFFCF8000000000;
+    static constexpr int SIZE_OF_KSTACK = Memory::PAGE_4KiB * 32;
 };
 }
 
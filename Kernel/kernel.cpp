@@ -20,6 +20,7 @@
 #include "Arch/Interrupts/Interrupts.h"
 #include "Arch/IO/PCI.h"
 #include "Arch/IO/PIT.h"
+#include "Benchmarks/Benchmark.h"
 #include "Boot/Modules/ModuleManager.h"
 #include "Boot/MultibootManager.h"
 #include "Drivers/Graphics/VMWare/SVGAII.h"
@@ -28,12 +29,15 @@
 #include "Drivers/Initrd/TARinitrd.h"
 #include "Filesystem/VFS.h"
 #include "Loader/ELF.h"
+#include "Memory/MemoryInfo.h"
 #include "Memory/MemoryManager.h"
 #include "Memory/SharedMemory.h"
 #include "Networking/NetworkSocket.h"
+#include "Networking/PacketBuffer.h"
 #include "Pipes/LocalSocket.h"
 #include "Pipes/EventListener.h"
 #include "Pipes/Pipe.h"
+#include "Tasks/LockStatistics.h"
 #include "Tasks/TaskManager.h"
 #include "Tasks/MasterScheduler.h"
 
@@ -87,6 +91,7 @@ extern "C" void pre_kernel(void* multibootStructure,
                             void* gdtPtr, void* tssPtr)
 {
     clear_screen_and_init_serial();
+    CPU::initialise_local_area(0);
     call_constructors();
 
     auto multibootVirtualAddress = Memory::VirtualAddress(Memory::PhysicalAddress(multibootStructure));
@@ -98,6 +103,9 @@ extern "C" void pre_kernel(void* multibootStructure,
 
     Memory::Manager::instance().remap_pages();
     Modules::map_virtual();
+#ifdef XPOS_MEMORY_LEAK_CHECK
+    Memory::Manager::instance().check_address_space_teardown();
+#endif
 
     auto* gdt = static_cast<X86_64::GlobalDescriptorTable*>(Memory::VirtualAddress(gdtPtr).get());
     auto* tss = static_cast<X86_64::TaskStateSegment*>(Memory::VirtualAddress(tssPtr).get());
@@ -108,12 +116,11 @@ extern "C" void pre_kernel(void* multibootStructure,
     X86_64::Interrupts::Manager::instance().initialise();
     X86_64::ProgrammableIntervalTimer::instance().initialise();
 
-    //Memory::Heap::HeapManager::instance();
-
     Pipes::initialise();
     Task::MasterScheduler sch; 
     Task::Manager::instance().initialise(&sch);
     //Events::EventDispatcher::instance();
+    Networking::PacketBuffer::initialise();
     PCI::initialise();
     Sockets::LocalSocket::initialise();
     Networking::NetworkSocket::initialise();
@@ -122,11 +129,9 @@ extern "C" void pre_kernel(void* multibootStructure,
     Filesystem::VirtualFilesystem::instance();
     Filesystem::TarReader::instance().load_initrd();
 
-    auto newAddrSpace = Memory::Manager::instance().create_virtual_address_space();
-
     Task::TaskDescriptor tdesc1
     {
-        .addressSpace = Memory::RegionableVirtualAddressSpace(std::move(newAddrSpace)),
+        .addressSpace = Memory::RegionableVirtualAddressSpace::create(),
         .openPipes = Common::AutomaticReferenceCountable<Task::PipeTable>(Task::PipeTable()),
         .entryPoint = (void*)&window_server_launch,
         .taskPriority = 300
@@ -136,7 +141,21 @@ extern "C" void pre_kernel(void* multibootStructure,
     Devices::HID::Mouse::initialise();
     Drivers::Graphics::VMWareSVGAII::Device::instance().initialise();
     Memory::Shared::initialise();
+    Memory::Info::initialise();
+#ifdef XPOS_LOCK_STATISTICS
+    LockStatistics::initialise();
+#endif
+
+#ifdef XPOS_KERNEL_BENCHMARKS
+    Benchmarks::run_memory_benchmarks();
+    Benchmarks::run_hashmap_benchmarks();
+    Benchmarks::run_local_socket_benchmarks();
+    Benchmarks::run_network_benchmarks();
+#endif
     
+#ifdef XPOS_MEMORY_LEAK_CHECK
+    Task::Manager::instance().check_task_teardown();
+#endif
     Task::Manager::instance().launch_task(tdesc1);
     
     Task::Manager::instance().begin();
@@ -60,11 +60,15 @@ extern isr_def_32
 
 %macro error_isr 1
 isr_def_%+%1:
-    pop rsi
+    ; The error code is read in place rather than popped, so that RSI is preserved.
     pushaq
     mov rdi, %1
+    mov rsi, [rsp + 15 * 8]
+    sub rsp, 8
     call _ZN6X86_6410Interrupts7Manager20handle_err_interruptEhh
+    add rsp, 8
     popaq
+    add rsp, 8
     iretq
 %endmacro
 
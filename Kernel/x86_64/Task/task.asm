@@ -125,8 +125,11 @@ switch_to_not_started_task:
     mov [rcx], rsp
 .skip_save_stack:
     mov rsp, [rdi]
+    ; Bit 63 of the new CR3 value (do not flush the PCID's entries) is not stored in CR3.
     mov rcx, cr3
-    cmp rsi, rcx
+    mov rax, rsi
+    btr rax, 63
+    cmp rax, rcx
     je .virtaddrspace_changed
     mov cr3, rsi
 .virtaddrspace_changed:
@@ -143,8 +146,11 @@ switch_to_ready_task:
     mov [rdx], rsp
 .skip_save_stack:
     mov rsp, [rdi]
+    ; Bit 63 of the new CR3 value (do not flush the PCID's entries) is not stored in CR3.
     mov rcx, cr3
-    cmp rsi, rcx
+    mov rax, rsi
+    btr rax, 63
+    cmp rax, rcx
     je .virtaddrspace_changed
     mov cr3, rsi
 .virtaddrspace_changed:
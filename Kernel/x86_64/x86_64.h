@@ -51,6 +51,42 @@ namespace X86_64
         asm volatile ("mov %%CS, %0" : "=r"(cs));
         return cs;
     }
+
+    static inline uint64_t read_cr0()
+    {
+        uint64_t cr0;
+        asm volatile ("mov %%cr0, %0" : "=r"(cr0));
+        return cr0;
+    }
+
+    static inline void write_cr0(uint64_t cr0)
+    {
+        asm volatile ("mov %0, %%cr0" : : "r"(cr0) : "memory");
+    }
+
+    static inline uint64_t read_cr3()
+    {
+        uint64_t cr3;
+        asm volatile ("mov %%cr3, %0" : "=r"(cr3));
+        return cr3;
+    }
+
+    static inline uint64_t read_cr4()
+    {
+        uint64_t cr4;
+        asm volatile ("mov %%cr4, %0" : "=r"(cr4));
+        return cr4;
+    }
+
+    static inline void write_cr4(uint64_t cr4)
+    {
+        asm volatile ("mov %0, %%cr4" : : "r"(cr4) : "memory");
+    }
+
+    static inline void cpuid(uint32_t leaf, uint32_t& eax, uint32_t& ebx, uint32_t& ecx, uint32_t& edx)
+    {
+        asm volatile ("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(leaf), "c"(0));
+    }
 }
 
 
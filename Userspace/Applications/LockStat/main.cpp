@@ -0,0 +1,80 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "API/LockStatistics.h"
+#include "API/Syscall.h"
+#include "Libraries/OSLib/Pipe.h"
+
+using namespace xpOS;
+
+namespace
+{
+    static constexpr int TOP_LOCKS = 10;
+
+    void print_field(const char* name, uint64_t value, const char* unit = "")
+    {
+        API::kern_print(name);
+        API::kern_print_num(value);
+        API::kern_print(unit);
+        API::kern_print("\n");
+    }
+
+    /**
+     * Prints the non-empty histogram buckets as "2^i: count".
+     */
+    void print_histogram(const char* name, const uint64_t (&histogram)[API::LockStatistics::HISTOGRAM_BUCKETS])
+    {
+        API::kern_print(name);
+        for (int i = 0; i < API::LockStatistics::HISTOGRAM_BUCKETS; i++) {
+            if (!histogram[i])
+                continue;
+            API::kern_print(" 2^");
+            API::kern_print_num(i);
+            API::kern_print(":");
+            API::kern_print_num(histogram[i]);
+        }
+        API::kern_print("\n");
+    }
+}
+
+int main()
+{
+    static API::LockStatistics::LockInfo locks[TOP_LOCKS];
+    auto pd = OSLib::popen("sys::lockstat");
+    auto count = OSLib::pread(pd, locks, sizeof(locks)) / sizeof(API::LockStatistics::LockInfo);
+    OSLib::pclose(pd);
+    if (!count) {
+        API::kern_print("lockstat: unable to read sys::lockstat, is the kernel built with XPOS_LOCK_STATISTICS?\n");
+        return 1;
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+        auto& lock = locks[i];
+        API::kern_print(lock.name);
+        API::kern_print("\n");
+        print_field("  Acquisitions:  ", lock.acquisitions);
+        print_field("  Contended:     ", lock.contended);
+        print_field("  WaitTotal:     ", lock.waitCycles, " cycles");
+        print_field("  WaitMax:       ", lock.maxWaitCycles, " cycles");
+        print_field("  HoldTotal:     ", lock.holdCycles, " cycles");
+        print_field("  HoldMax:       ", lock.maxHoldCycles, " cycles");
+        print_histogram("  WaitHistogram:", lock.waitHistogram);
+        print_histogram("  HoldHistogram:", lock.holdHistogram);
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "API/MemoryInfo.h"
+#include "API/Syscall.h"
+#include "Libraries/OSLib/Pipe.h"
+
+using namespace xpOS;
+
+namespace
+{
+    void print_field(const char* name, uint64_t value, const char* unit = "")
+    {
+        API::kern_print(name);
+        API::kern_print_num(value);
+        API::kern_print(unit);
+        API::kern_print("\n");
+    }
+}
+
+int main()
+{
+    API::MemoryInfo::SystemInfo system;
+    auto pd = OSLib::popen("sys::meminfo");
+    if (OSLib::pread(pd, &system, sizeof(system)) != sizeof(system)) {
+        API::kern_print("meminfo: unable to read sys::meminfo\n");
+        return 1;
+    }
+    OSLib::pclose(pd);
+
+    auto kib = system.pageSize / 1024;
+    print_field("MemTotal:        ", system.totalPages * kib, " KiB");
+    print_field("MemFree:         ", system.freePages * kib, " KiB");
+    print_field("PageTables:      ", system.pageTablePages * kib, " KiB");
+    print_field("HeapMapped:      ", system.heapBytesMapped / 1024, " KiB");
+    print_field("HeapInUse:       ", system.heapBytesInUse / 1024, " KiB");
+    print_field("HeapAllocations: ", system.heapAllocations);
+    print_field("HeapFrees:       ", system.heapFrees);
+    print_field("HeapLargeRuns:   ", system.heapLargeAllocations);
+    print_field("SharedObjects:   ", system.sharedObjects);
+    print_field("SharedMappings:  ", system.sharedAttachments);
+    print_field("Shared:          ", system.sharedBytes / 1024, " KiB");
+
+    API::MemoryInfo::TaskInfo task;
+    pd = OSLib::popen("sys::meminfo", nullptr, API::MemoryInfo::Flags::TASK);
+    if (OSLib::pread(pd, &task, sizeof(task)) == sizeof(task)) {
+        print_field("Task:            ", task.tid);
+        print_field("  Resident:      ", task.residentPages * kib, " KiB");
+        print_field("  PageTables:    ", task.pageTablePages * kib, " KiB");
+    }
+    OSLib::pclose(pd);
+    return 0;
+}
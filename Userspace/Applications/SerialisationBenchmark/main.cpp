@@ -0,0 +1,226 @@
+/**
+    Copyright 2023-2025 Praveen Balakrishnan
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+    xpOS v1.0
+*/
+
+#include "API/Syscall.h"
+#include "Libraries/SerialisationLib/DeserialisedData.h"
+#include "Libraries/SerialisationLib/SerialisedData.h"
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace xpOS;
+
+namespace
+{
+    static constexpr int ITERATIONS = 10000;
+    static constexpr std::size_t PIXELS = 1024;
+
+    uint64_t read_timestamp_counter()
+    {
+        uint32_t low, high;
+        asm volatile ("lfence; rdtsc" : "=a"(low), "=d"(high) : : "memory");
+        return (static_cast<uint64_t>(high) << 32) | low;
+    }
+
+    void report(const char* name, uint64_t cycles)
+    {
+        API::kern_print("serialisation: ");
+        API::kern_print(name);
+        API::kern_print(": ");
+        API::kern_print_num(cycles / ITERATIONS);
+        API::kern_print(" cycles/message\n");
+    }
+
+    struct Resize
+    {
+        int width;
+        int height;
+
+        template<typename Archive>
+        constexpr void define_archivable(Archive& ar)
+        {
+            ar(width, height);
+        }
+    };
+
+    struct Blit
+    {
+        std::string title;
+        std::vector<uint32_t> pixels;
+
+        template<typename Archive>
+        void define_archivable(Archive& ar)
+        {
+            ar(title, pixels);
+        }
+    };
+
+    /**
+     * Blit as a receiver that only looks at the data would decode it, pointing
+     * into the message instead of copying out of it.
+     */
+    struct BlitView
+    {
+        std::string_view title;
+        std::span<const uint32_t> pixels;
+
+        template<typename Archive>
+        void define_archivable(Archive& ar)
+        {
+            ar(title, pixels);
+        }
+    };
+
+    /**
+     * The archive as it was before encoding became schema driven: every value is
+     * appended a byte at a time and every element decoded on its own.
+     */
+    struct ByteEncoder
+    {
+        std::vector<uint8_t> bytes;
+
+        template<typename... Args>
+        void operator()(Args&... args)
+        {
+            (encode(args), ...);
+        }
+
+        void push(const void* values, std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; i++)
+                bytes.push_back(static_cast<const uint8_t*>(values)[i]);
+        }
+
+        void encode(const auto& value) { push(&value, sizeof(value)); }
+
+        void encode(const std::string& value)
+        {
+            std::size_t sz = value.size();
+            push(&sz, sizeof(sz));
+            for (char c : value)
+                encode(c);
+        }
+
+        void encode(const std::vector<uint32_t>& value)
+        {
+            std::size_t sz = value.size();
+            push(&sz, sizeof(sz));
+            for (auto item : value)
+                encode(item);
+        }
+    };
+
+    struct ByteDecoder
+    {
+        const uint8_t* bytes;
+        std::size_t offset = 0;
+
+        template<typename... Args>
+        void operator()(Args&... args)
+        {
+            (decode(args), ...);
+        }
+
+        void decode(auto& value)
+        {
+            value = *reinterpret_cast<const std::remove_reference_t<decltype(value)>*>(bytes + offset);
+            offset += sizeof(value);
+        }
+
+        void decode(std::string& value)
+        {
+            std::size_t sz;
+            decode(sz);
+            value.clear();
+            for (std::size_t i = 0; i < sz; i++) {
+                char c;
+                decode(c);
+                value += c;
+            }
+        }
+
+        void decode(std::vector<uint32_t>& value)
+        {
+            std::size_t sz;
+            decode(sz);
+            value.clear();
+            value.reserve(sz);
+            for (std::size_t i = 0; i < sz; i++) {
+                uint32_t item;
+                decode(item);
+                value.push_back(item);
+            }
+        }
+    };
+
+    template <typename Message>
+    void run_baseline(const char* name, Message& message)
+    {
+        uint64_t encodeCycles = 0, decodeCycles = 0;
+        for (int i = 0; i < ITERATIONS; i++) {
+            auto start = read_timestamp_counter();
+            ByteEncoder encoder;
+            message.define_archivable(encoder);
+            auto encoded = read_timestamp_counter();
+            ByteDecoder decoder{encoder.bytes.data()};
+            Message decoded;
+            decoded.define_archivable(decoder);
+            decodeCycles += read_timestamp_counter() - encoded;
+            encodeCycles += encoded - start;
+        }
+        API::kern_print(name);
+        API::kern_print("\n");
+        report("  bytewise encode", encodeCycles);
+        report("  bytewise decode", decodeCycles);
+    }
+
+    template <typename Message, typename Decoded = Message>
+    void run_archive(Message& message)
+    {
+        uint64_t encodeCycles = 0, decodeCycles = 0;
+        for (int i = 0; i < ITERATIONS; i++) {
+            auto start = read_timestamp_counter();
+            std::array<uint8_t, Serialisation::SerialisedData::DEFAULT_CAPACITY> buffer;
+            Serialisation::SerialisedData serialised(buffer.data(), buffer.size());
+            message >> serialised;
+            auto encoded = read_timestamp_counter();
+            auto deserialised = Serialisation::DeserialisedData::view(serialised.bytes(), serialised.length());
+            Decoded decoded;
+            decoded << deserialised;
+            decodeCycles += read_timestamp_counter() - encoded;
+            encodeCycles += encoded - start;
+        }
+        report("  archive encode", encodeCycles);
+        report(std::is_same_v<Message, Decoded> ? "  archive decode" : "  archive decode in place", decodeCycles);
+    }
+}
+
+int main()
+{
+    Resize resize = { .width = 640, .height = 480 };
+    run_baseline("Resize", resize);
+    run_archive(resize);
+
+    Blit blit = { .title = "SerialisationBenchmark", .pixels = std::vector<uint32_t>(PIXELS, 0xff00ff) };
+    run_baseline("Blit", blit);
+    run_archive(blit);
+    run_archive<Blit, BlitView>(blit);
+    return 0;
+}
@@ -90,9 +90,11 @@ void* receive_events(void*) {
 
 extern "C" void DG_Init()
 {
-    int serverPd = OSLib::popen("socket::local", 0, static_cast<API::EventType>(OSLib::LocalSocket::Flags::NON_BLOCKING));
+    int serverPd = OSLib::popen("socket::local", 0, static_cast<API::EventType>(OSLib::LocalSocket::Flags::NON_BLOCKING) | static_cast<API::EventType>(OSLib::LocalSocket::Flags::SEQPACKET));
     while (!OSLib::LocalSocket::connect(serverPd, "xp::WindowServer"));
     conn = new IPC::Connection<ClientEndpoint>(serverPd);
+    // Flushes are sent every frame and key events on every press, so keep them out of the kernel.
+    conn->offer_shared_rings();
 
     CreateWindow cw = {
         .width = DOOMGENERIC_RESX,
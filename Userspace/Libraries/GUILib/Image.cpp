@@ -18,14 +18,17 @@
 
 #include "Libraries/GraphicsLib/stb_image.h"
 #include "Image.h"
+#include "Libraries/OSLib/MappedFile.h"
 
 namespace xpOS::GUILib
 {
 
 ImageView::ImageView(std::string path)
 {
-    unsigned char *data = stbi_load(
-        path.c_str(),
+    OSLib::MappedFile file(path.c_str());
+    unsigned char *data = stbi_load_from_memory(
+        file.data(),
+        file.size(),
         &m_width,
         &m_height,
         nullptr,
@@ -25,9 +25,11 @@ namespace xpOS::GUILib
 
 std::optional<Window> Window::create(int width, int height)
 {
-    int serverPd = OSLib::popen("socket::local", 0, static_cast<API::EventType>(OSLib::LocalSocket::Flags::NON_BLOCKING));
+    int serverPd = OSLib::popen("socket::local", 0, static_cast<API::EventType>(OSLib::LocalSocket::Flags::NON_BLOCKING) | static_cast<API::EventType>(OSLib::LocalSocket::Flags::SEQPACKET));
     while (!OSLib::LocalSocket::connect(serverPd, "xp::WindowServer"));
     auto wsconn = IPC::Connection<ClientEndpoint>(serverPd);
+    // Flushes are sent every frame, so keep them out of the kernel.
+    wsconn.offer_shared_rings();
 
     CreateWindow cw = {
         .width = width,
@@ -44,7 +46,28 @@ std::optional<Window> Window::create(int width, int height)
     int sharedMemPd = OSLib::popen("shared_mem", &req);
     auto framebuffer = static_cast<uint32_t*>(req.mappedTo);
 
-    return Window(framebuffer, Size(width, height), std::move(wsconn));
+    return Window(framebuffer, Size(width, height), sharedMemPd, std::move(wsconn));
+}
+
+bool Window::resize(int width, int height)
+{
+    ResizeWindow rw = {
+        .width = width,
+        .height = height
+    };
+
+    auto callback = m_wsconn.send_and_wait_for_reply<ResizeWindow, ResizeWindowCallback>(rw);
+    if (!callback.resized)
+        return false;
+
+    // The object was resized in place, but our mapping of it may have moved to fit.
+    API::SharedMemory::MappingInfo info;
+    if (OSLib::pread(m_sharedMemoryPd, &info, sizeof(info)) != sizeof(info))
+        return false;
+
+    m_framebuffer = static_cast<uint32_t*>(info.mappedTo);
+    m_size = Size(width, height);
+    return true;
 }
 
 
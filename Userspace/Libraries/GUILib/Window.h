@@ -35,17 +35,26 @@ using namespace xpOS::System::WindowServer;
 class Window
 {
 private:
-    Window(uint32_t* framebuffer, Size size, IPC::Connection<ClientEndpoint> wsconn)
+    Window(uint32_t* framebuffer, Size size, uint64_t sharedMemoryPd, IPC::Connection<ClientEndpoint> wsconn)
     : m_framebuffer(framebuffer)
     , m_size(size)
+    , m_sharedMemoryPd(sharedMemoryPd)
     , m_wsconn(std::move(wsconn))
     {}
 
     uint32_t* m_framebuffer;
     Size m_size;
+    uint64_t m_sharedMemoryPd;
     IPC::Connection<ClientEndpoint> m_wsconn;
 public:
     static std::optional<Window> create(int width, int height);
+
+    /**
+     * Asks the WindowServer to resize the window's framebuffer in place. The window
+     * must be redrawn afterwards, and contexts taken before the resize are stale.
+     */
+    bool resize(int width, int height);
+
     Context context()
     {
         Context context {
@@ -3,10 +3,20 @@
 
 #include "Libraries/SerialisationLib/DeserialisedData.h"
 #include "Libraries/SerialisationLib/SerialisedData.h"
+#include "Libraries/IPCLib/SharedRing.h"
 #include "Libraries/OSLib/EventListener.h"
 #include "Libraries/OSLib/Pipe.h"
 #include "Libraries/OSLib/Socket.h"
+#include "API/SharedMemory.h"
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <functional>
 #include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace xpOS::IPC
@@ -22,13 +32,43 @@ void receive_ipc_message(Serialisation::DeserialisedData& m, Connection<ReceiveE
 {
     SpecificMessage s;
     s << m;
-    Handler::handle_ipc_message(std::move(s), c);
+    // A message cut short by its sender is dropped rather than handled half decoded.
+    if (!m.failed())
+        Handler::handle_ipc_message(std::move(s), c);
 }
 
 template <typename... MessageTypes>
 struct Endpoint
 {};
 
+// Makes the names of the shared memory behind each offer unique within the process.
+inline std::atomic<int> sharedRingsOffered = 0;
+
+/**
+ * The reply to a request sent with Connection::send_request. It is filled in when
+ * the connection reads the reply, whether in poll, wait_for or while handling messages.
+ */
+template <typename Reply>
+class PendingReply
+{
+public:
+    bool ready() const
+    {
+        return m_slot->has_value();
+    }
+
+    Reply take()
+    {
+        return std::move(**m_slot);
+    }
+
+private:
+    template <typename ReceiveEndpointDefinition>
+    friend class Connection;
+
+    std::shared_ptr<std::optional<Reply>> m_slot = std::make_shared<std::optional<Reply>>();
+};
+
 // conn should be able to read a message when we know we have one
 // i.e. read_as_many_as_possible_without_blocking
 
@@ -36,16 +76,38 @@ struct Endpoint
 // should be able to process a message and switch on it..
 
 
-// MUST BE USED WITH NONBLOCKING SOCKETS
+// MUST BE USED WITH NONBLOCKING SEQPACKET SOCKETS, so each read returns one whole message
+//
+// Either side can move the connection onto a pair of SharedRings with offer_shared_rings.
+// Messages then bypass the kernel, and the socket is only used to wake a peer that
+// has run out of messages, or of room to send them, and is waiting for the socket to
+// become readable.
 template <typename ReceiveEndpointDefinition>
 class Connection
 {
+    struct MessageHeader
+    {
+        int messageId;
+        std::size_t length;
+        // Non-zero if the sender expects a reply naming this ID.
+        uint32_t requestId = 0;
+        // Non-zero if this is the reply to the request with this ID.
+        uint32_t inReplyTo = 0;
+    }__attribute__((packed));
+
 public:
     Connection(uint64_t nonBlockingSocket)
         : m_socket(nonBlockingSocket)
+        , m_receiveBuffer(OSLib::LocalSocket::MAX_PACKET_SIZE)
     {
     }
 
+    ~Connection()
+    {
+        if (m_sharedMemory)
+            OSLib::pclose(m_sharedMemory);
+    }
+
     Connection(Connection&) = delete;
     Connection& operator=(Connection&) = delete;
 
@@ -66,6 +128,34 @@ public:
         using std::swap;
         swap(a.m_socket, b.m_socket);
         swap(a.m_unprocessedMessages, b.m_unprocessedMessages);
+        swap(a.m_receiveBuffer, b.m_receiveBuffer);
+        swap(a.m_sharedMemory, b.m_sharedMemory);
+        swap(a.m_sendRing, b.m_sendRing);
+        swap(a.m_receiveRing, b.m_receiveRing);
+        swap(a.m_sendOnRing, b.m_sendOnRing);
+        swap(a.m_receiveOnRing, b.m_receiveOnRing);
+        swap(a.m_pendingRequests, b.m_pendingRequests);
+        swap(a.m_nextRequestId, b.m_nextRequestId);
+        swap(a.m_handlingRequestId, b.m_handlingRequestId);
+        swap(a.m_listener, b.m_listener);
+        swap(a.m_writeListener, b.m_writeListener);
+    }
+
+    /**
+     * Creates a ring for each direction and asks the peer to use them. Messages sent
+     * from now on go through the ring, and the peer's do once it has accepted.
+     */
+    bool offer_shared_rings()
+    {
+        SharedRingsOffer offer = {
+            .sharedMemoryId = "ipc::" + std::to_string(API::Syscalls::syscall(SYSCALL_GETTID)) + "::" + std::to_string(sharedRingsOffered++)
+        };
+        if (!attach_shared_rings(offer.sharedMemoryId.c_str(), true))
+            return false;
+
+        send_on_socket(offer);
+        m_sendOnRing = true;
+        return true;
     }
 
     /*Connection(Connection&& conn)
@@ -87,18 +177,111 @@ public:
         swap(a.m_unprocessedMessages, b.m_unprocessedMessages);
     }*/
 
+    /**
+     * @return false if the message is too large to send.
+     */
     template <typename MessageType>
-    void send_message(MessageType m)
+    bool send_message(MessageType m)
+    {
+        return send(m, { .messageId = MessageType::MessageId });
+    }
+
+    /**
+     * Sends a message the peer is expected to answer with Connection::reply.
+     * Any number of requests can be outstanding at once, including several of
+     * the same type, as each reply names the request it answers. A request too
+     * large to send never gets a reply.
+     */
+    template <typename Reply, typename MessageType>
+    PendingReply<Reply> send_request(MessageType m)
+    {
+        PendingReply<Reply> pending;
+        send_request<Reply>(m, [slot = pending.m_slot](Reply reply) {
+            *slot = std::move(reply);
+        });
+        return pending;
+    }
+
+    /**
+     * As above, but calls onReply with the reply as soon as it is read.
+     *
+     * @return false if the request is too large to send.
+     */
+    template <typename Reply, typename MessageType, typename Callback>
+    bool send_request(MessageType m, Callback&& onReply)
+    {
+        auto requestId = m_nextRequestId++;
+        if (m_nextRequestId == 0)
+            m_nextRequestId = 1;
+
+        m_pendingRequests[requestId] = [onReply = std::forward<Callback>(onReply)](Serialisation::DeserialisedData& data) mutable {
+            Reply reply;
+            reply << data;
+            if (!data.failed())
+                onReply(std::move(reply));
+        };
+        if (send(m, { .messageId = MessageType::MessageId, .requestId = requestId }))
+            return true;
+        m_pendingRequests.erase(requestId);
+        return false;
+    }
+
+    /**
+     * Answers the request being handled. Outside of a handler, or if the message
+     * being handled was not a request, this is the same as send_message.
+     */
+    template <typename MessageType>
+    bool reply(MessageType m)
+    {
+        return send(m, { .messageId = MessageType::MessageId, .inReplyTo = m_handlingRequestId });
+    }
+
+    /**
+     * Reads messages, blocking while there are none, until the reply arrives.
+     * Other messages read in the meantime are queued to be handled later.
+     */
+    template <typename Reply>
+    Reply wait_for(PendingReply<Reply>& pending)
+    {
+        while (!pending.ready()) {
+            if (!try_to_read_message() && !pending.ready())
+                wait_until_readable();
+        }
+        return pending.take();
+    }
+
+    /**
+     * Reads whatever messages are available without blocking, completing any
+     * requests they answer. Meant to be called when an EventListener reports the
+     * socket readable.
+     *
+     * @return true if messages were queued to be handled.
+     */
+    bool poll()
+    {
+        auto queued = m_unprocessedMessages.size();
+        read_maximal_messages();
+        return m_unprocessedMessages.size() != queued;
+    }
+
+    uint64_t socket() const
+    {
+        return m_socket;
+    }
+
+    template <typename MessageType>
+    bool send_serialised(MessageHeader header, MessageType& m, Serialisation::SerialisedData& serialised, bool useRing = true)
     {
-        Serialisation::SerialisedData serialised;
         m >> serialised;
-        MessageHeader header = {
-            .messageId = MessageType::MessageId,
-            .length = serialised.length()
+        header.length = serialised.length();
+
+        API::Pipes::IOVector vectors[] = {
+            { .base = &header, .length = sizeof(MessageHeader) },
+            { .base = const_cast<uint8_t*>(serialised.bytes()), .length = serialised.length() }
         };
-        
-        force_write(sizeof(MessageHeader), &header);
-        force_write(serialised.length(), serialised.bytes());
+        if (useRing && m_sendOnRing)
+            return force_write_ring(vectors, 2, sizeof(MessageHeader) + serialised.length());
+        return force_write(vectors, 2, sizeof(MessageHeader) + serialised.length());
     }
 
     void read_maximal_messages()
@@ -108,17 +291,32 @@ public:
 
     bool try_to_read_message()
     {
-        MessageHeader header;
-        
-        /// FIXME: We might unfortunately read less than the sizeof(MessageHeader).
-        if (xpOS::OSLib::pread(m_socket, &header, sizeof(MessageHeader)) == 0)
+        // The socket is read first, as the peer only moves onto the ring after the
+        // control message saying so, and sends nothing but wake ups on the socket after.
+        while (true) {
+            auto length = xpOS::OSLib::pread(m_socket, m_receiveBuffer.data(), m_receiveBuffer.size());
+            if (length == 0)
+                break;
+            if (parse_message(length))
+                return true;
+        }
+
+        if (!m_receiveOnRing)
             return false;
-        
-        std::vector<uint8_t> dataBuffer(header.length);
-        force_read(header.length, dataBuffer.data());
-        
-        m_unprocessedMessages.push_back({header.messageId, Serialisation::DeserialisedData(dataBuffer.data(), header.length)});
-        return true;
+
+        while (true) {
+            auto length = m_receiveRing.read(m_receiveBuffer.data(), m_receiveBuffer.size());
+            if (m_receiveRing.should_wake_producer())
+                wake_peer();
+            if (length) {
+                if (parse_message(length))
+                    return true;
+                continue;
+            }
+            // Only wait for a wake up once the peer has seen that we are about to.
+            if (m_receiveRing.prepare_to_sleep())
+                return false;
+        }
     }
 
     /*void wait_for_new_message()
@@ -136,30 +334,71 @@ public:
         m_unprocessedMessages.push_back({header.messageId, Serialisation::DeserialisedData(dataBuffer.data(), header.length)});
     }*/
 
+    /**
+     * Reads and handles at most budget messages, so one busy connection cannot
+     * hold up the others served by the same thread.
+     *
+     * @return true if the budget ran out before the messages did.
+     */
+    template <class Handler>
+    bool receive_messages(std::size_t budget)
+    {
+        for (std::size_t handled = 0; handled < budget; handled++) {
+            if (m_unprocessedMessages.empty() && !try_to_read_message())
+                return false;
+
+            auto queued = std::move(m_unprocessedMessages.front());
+            m_unprocessedMessages.pop_front();
+            dispatch<Handler>(queued);
+        }
+        return true;
+    }
+
     template <class Handler>
     void receive_message()
     {
         read_maximal_messages();
         for (auto it = m_unprocessedMessages.begin(); it != m_unprocessedMessages.end();) {
-            handle_message<Handler>(it->messageId, it->message);
+            dispatch<Handler>(*it);
             it = m_unprocessedMessages.erase(it);
         }
     }
 
-    void force_read(std::size_t size, void* buf)
+    /**
+     * Writes a whole message, waiting while the peer has no room for it.
+     *
+     * @return false if the message is larger than the socket accepts.
+     */
+    bool force_write(const API::Pipes::IOVector* vectors, std::size_t count, std::size_t size)
     {
-        std::size_t totalBytesRead = 0;
-        while (totalBytesRead < size) {
-            totalBytesRead += xpOS::OSLib::pread(m_socket, static_cast<uint8_t*>(buf) + totalBytesRead, size - totalBytesRead);
-        }
+        if (size > OSLib::LocalSocket::MAX_PACKET_SIZE)
+            return false;
+        // A message is written whole or not at all, so retry once the peer has read.
+        while (xpOS::OSLib::pwritev(m_socket, vectors, count) != size)
+            wait_until_writeable();
+        return true;
     }
 
-    void force_write(std::size_t size, const void* buf)
+    /**
+     * Writes a whole message to the shared ring, waiting while it is full. Messages
+     * read in the meantime are queued to be handled later.
+     *
+     * @return false if the message is larger than the ring accepts.
+     */
+    bool force_write_ring(const API::Pipes::IOVector* vectors, std::size_t count, std::size_t size)
     {
-        std::size_t totalBytesWritten = 0;
-        while (totalBytesWritten < size) {
-            totalBytesWritten += xpOS::OSLib::pwrite(m_socket, static_cast<const uint8_t*>(buf) + totalBytesWritten, size - totalBytesWritten);
+        if (size > SharedRing::MAX_MESSAGE_SIZE)
+            return false;
+        while (!m_sendRing.try_write(vectors, count, size)) {
+            // The peer may be waiting for room in our ring too, so empty it before sleeping.
+            read_maximal_messages();
+            // Only wait for a wake up once the peer has seen that we are about to.
+            if (m_sendRing.prepare_to_wait_for_space(size))
+                wait_until_readable();
         }
+        if (m_sendRing.should_wake_consumer())
+            wake_peer();
+        return true;
     }
 
     /*template <class Handler>
@@ -189,7 +428,9 @@ public:
                 m_unprocessedMessages.erase(it);
                 MessageType message;
                 message << data;
-                return message;
+                if (!data.failed())
+                    return message;
+                continue;
             }
 
             read_maximal_messages();
@@ -200,8 +441,8 @@ public:
     template <typename MessageType, typename ReplyMessageType>
     ReplyMessageType send_and_wait_for_reply(MessageType& m)
     {
-        send_message(m);
-        return get_message_of_type<ReplyMessageType>();
+        auto pending = send_request<ReplyMessageType>(m);
+        return wait_for(pending);
     }
 
     template <class Handler>
@@ -237,17 +478,190 @@ private:
     struct QueuedMessage
     {
         int messageId;
+        uint32_t requestId;
         Serialisation::DeserialisedData message;
     };
 
-    struct MessageHeader
+    // Negative message IDs are used by the connection itself and never handled.
+    static constexpr int SHARED_RINGS_OFFER_MESSAGE_ID = -1;
+    static constexpr int SHARED_RINGS_ACCEPT_MESSAGE_ID = -2;
+    static constexpr int WAKE_UP_MESSAGE_ID = -3;
+
+    struct SharedRingsOffer
     {
-        int messageId;
-        std::size_t length;
-    }__attribute__((packed));
+        static constexpr int MessageId = SHARED_RINGS_OFFER_MESSAGE_ID;
+        std::string sharedMemoryId;
+
+        template<typename Archive>
+        void define_archivable(Archive& ar)
+        {
+            ar(sharedMemoryId);
+        }
+    };
+
+    struct SharedRingsAccept
+    {
+        static constexpr int MessageId = SHARED_RINGS_ACCEPT_MESSAGE_ID;
+
+        template<typename Archive>
+        constexpr void define_archivable(Archive& ar)
+        {
+            ar();
+        }
+    };
+
+    template <typename MessageType>
+    bool send(MessageType& m, MessageHeader header, bool useRing = true)
+    {
+        if constexpr (Serialisation::FixedSize<MessageType>) {
+            // The size is known up front, so encode on the stack rather than the heap.
+            std::array<uint8_t, Serialisation::fixed_encoded_size<MessageType>() + 1> buffer;
+            Serialisation::SerialisedData serialised(buffer.data(), buffer.size());
+            return send_serialised(header, m, serialised, useRing);
+        } else {
+            Serialisation::SerialisedData serialised;
+            return send_serialised(header, m, serialised, useRing);
+        }
+    }
+
+    template <typename MessageType>
+    bool send_on_socket(MessageType m)
+    {
+        return send(m, { .messageId = MessageType::MessageId }, false);
+    }
+
+    template <class Handler>
+    void dispatch(QueuedMessage& queued)
+    {
+        m_handlingRequestId = queued.requestId;
+        handle_message<Handler>(queued.messageId, queued.message);
+        m_handlingRequestId = 0;
+    }
+
+    void wait_until_readable()
+    {
+        if (!m_listener) {
+            m_listener = std::make_unique<OSLib::EventListener>();
+            m_listener->add(m_socket, static_cast<API::EventTypeMask>(API::EventTypes::READABLE) | API::EventFlags::LEVEL_TRIGGERED);
+        }
+        API::Event event;
+        m_listener->listen(&event, 1);
+    }
+
+    void wake_peer()
+    {
+        // If the socket is full the peer already has something to wake it.
+        MessageHeader header = { .messageId = WAKE_UP_MESSAGE_ID, .length = 0 };
+        xpOS::OSLib::pwrite(m_socket, &header, sizeof(MessageHeader));
+    }
+
+    /**
+     * Blocks until the peer reads from a socket that turned a message away.
+     */
+    void wait_until_writeable()
+    {
+        if (!m_writeListener) {
+            m_writeListener = std::make_unique<OSLib::EventListener>();
+            m_writeListener->add(m_socket, API::EventTypes::WRITEABLE);
+        }
+        API::Event event;
+        m_writeListener->listen(&event, 1);
+    }
+
+    /**
+     * Queues the message in the receive buffer, or acts on it if it is one of ours.
+     *
+     * @return true if a message was queued.
+     */
+    bool parse_message(std::size_t length)
+    {
+        if (length < sizeof(MessageHeader))
+            return false;
+
+        MessageHeader header;
+        memcpy(&header, m_receiveBuffer.data(), sizeof(MessageHeader));
+        if (header.length != length - sizeof(MessageHeader))
+            return false;
+
+        auto data = Serialisation::DeserialisedData(m_receiveBuffer.data() + sizeof(MessageHeader), header.length);
+        switch (header.messageId) {
+        case SHARED_RINGS_OFFER_MESSAGE_ID: {
+            SharedRingsOffer offer;
+            offer << data;
+            if (data.failed() || !attach_shared_rings(offer.sharedMemoryId.c_str(), false))
+                return false;
+            m_receiveOnRing = true;
+            send_on_socket(SharedRingsAccept());
+            m_sendOnRing = true;
+            return false;
+        }
+        case SHARED_RINGS_ACCEPT_MESSAGE_ID:
+            m_receiveOnRing = true;
+            return false;
+        case WAKE_UP_MESSAGE_ID:
+            return false;
+        }
+
+        if (header.inReplyTo) {
+            auto it = m_pendingRequests.find(header.inReplyTo);
+            if (it != m_pendingRequests.end()) {
+                auto complete = std::move(it->second);
+                m_pendingRequests.erase(it);
+                complete(data);
+                return false;
+            }
+        }
+        m_unprocessedMessages.push_back({header.messageId, header.requestId, std::move(data)});
+        return true;
+    }
+
+    /**
+     * The side that creates the shared memory sends on the first ring and receives
+     * on the second, and the other side the other way round.
+     */
+    bool attach_shared_rings(const char* sharedMemoryId, bool create)
+    {
+        API::SharedMemory::LinkRequest req = {
+            .str = sharedMemoryId,
+            .mappedTo = nullptr,
+            .length = 2 * SharedRing::SIZE
+        };
+        int pd = OSLib::popen("shared_mem", &req, create ? API::SharedMemory::Flags::CREATE : 0);
+        if (!req.mappedTo) {
+            OSLib::pclose(pd);
+            return false;
+        }
+
+        m_sharedMemory = pd;
+        auto* first = static_cast<uint8_t*>(req.mappedTo);
+        auto* second = first + SharedRing::SIZE;
+        if (create) {
+            m_sendRing = SharedRing::create(first);
+            m_receiveRing = SharedRing::create(second);
+        } else {
+            m_sendRing = SharedRing(second);
+            m_receiveRing = SharedRing(first);
+        }
+        return true;
+    }
 
     uint64_t m_socket;
     std::list<QueuedMessage> m_unprocessedMessages;
+    std::vector<uint8_t> m_receiveBuffer;
+
+    uint64_t m_sharedMemory = 0;
+    SharedRing m_sendRing;
+    SharedRing m_receiveRing;
+    bool m_sendOnRing = false;
+    bool m_receiveOnRing = false;
+
+    std::unordered_map<uint32_t, std::function<void(Serialisation::DeserialisedData&)>> m_pendingRequests;
+    uint32_t m_nextRequestId = 1;
+    uint32_t m_handlingRequestId = 0;
+    // Only opened if something has to wait for the socket to become readable.
+    std::unique_ptr<OSLib::EventListener> m_listener;
+    // Only opened if a message has to wait for room in the socket.
+    std::unique_ptr<OSLib::EventListener> m_writeListener;
 };
 
 }
@@ -3,7 +3,6 @@
 
 #include <cstdint>
 #include <list>
-#include <optional>
 #include "Libraries/OSLib/Pipe.h"
 #include "Libraries/OSLib/Socket.h"
 #include "Libraries/OSLib/EventListener.h"
@@ -21,6 +20,7 @@ public:
             "socket::local",
             nullptr,
             static_cast<xpOS::API::EventType>(xpOS::OSLib::LocalSocket::Flags::NON_BLOCKING)
+                | static_cast<xpOS::API::EventType>(xpOS::OSLib::LocalSocket::Flags::SEQPACKET)
         ))
     {
         xpOS::OSLib::LocalSocket::bind(m_listeningSocket, listenOn);
@@ -36,48 +36,72 @@ public:
         xpOS::OSLib::EventListener listener;
         static constexpr int MAX_EVENTS = 10;
         xpOS::API::Event events[MAX_EVENTS];
-        listener.add(m_listeningSocket, static_cast<xpOS::API::EventTypeMask>(xpOS::OSLib::LocalSocket::EventTypes::SOCK_REQUEST_CONN));
+        // Both registrations are level-triggered, so connections and messages left over
+        // when a batch or budget runs out are reported again on the next listen.
+        listener.add(
+            m_listeningSocket,
+            static_cast<xpOS::API::EventTypeMask>(xpOS::OSLib::LocalSocket::EventTypes::SOCK_REQUEST_CONN) | xpOS::API::EventFlags::LEVEL_TRIGGERED,
+            LISTENING_SOCKET_COOKIE
+        );
         int noRaised = 0;
         while (true) {
             noRaised = listener.listen(events, MAX_EVENTS);
             for (int i = 0; i < noRaised; i++) {
-                if (events[i].pd == m_listeningSocket) {
+                if (events[i].cookie == LISTENING_SOCKET_COOKIE)
                     accept_new_connections(listener);
-                } else {
-                    for (auto& client : m_clientSockets) {
-                        if (client.pd == events[i].pd) {
-                            (*client.connection).template receive_message<Handler>();
-                        }
-                    }
-                }
+                else
+                    receive_messages<Handler>(listener, *reinterpret_cast<Client*>(events[i].cookie));
             }
-
         }
     }
 
 private:
-    struct PipeConnectionPair
+    struct Client
     {
         uint64_t pd;
-        std::optional<Connection<ReceiveEndpoint>> connection;
+        Connection<ReceiveEndpoint> connection;
+        bool backlogged = false;
     };
 
+    static constexpr uint64_t LISTENING_SOCKET_COOKIE = 0;
+    static constexpr int ACCEPT_BATCH = 16;
+    static constexpr std::size_t MESSAGE_BUDGET = 32;
+
     void accept_new_connections(xpOS::OSLib::EventListener& listener)
     {
-        uint64_t newClient = 0;
-        do {
-            newClient = xpOS::OSLib::LocalSocket::accept(m_listeningSocket);
-            if (newClient > 0) {
-                m_clientSockets.push_back({newClient, std::nullopt});
-                auto it = --m_clientSockets.end();
-                listener.add(it->pd, xpOS::API::EventTypes::READABLE);
-                it->connection = std::optional(Connection<ReceiveEndpoint>(it->pd));
-            }
-        } while (newClient > 0);
+        for (int i = 0; i < ACCEPT_BATCH; i++) {
+            uint64_t newClient = xpOS::OSLib::LocalSocket::accept(m_listeningSocket);
+            if (newClient == 0)
+                break;
+
+            // Clients never move once they are in the list, so the cookie is the client.
+            auto& client = m_clients.emplace_back(newClient, Connection<ReceiveEndpoint>(newClient));
+            listener.add(client.pd, static_cast<xpOS::API::EventTypeMask>(xpOS::API::EventTypes::READABLE) | xpOS::API::EventFlags::LEVEL_TRIGGERED, reinterpret_cast<uint64_t>(&client));
+        }
+    }
+
+    /**
+     * Messages left in a shared ring when the budget runs out do not make the socket
+     * readable, so until they are handled the client is also registered for its socket
+     * being writeable, which it almost always is.
+     */
+    template <class Handler>
+    void receive_messages(xpOS::OSLib::EventListener& listener, Client& client)
+    {
+        static constexpr auto BACKLOG_EVENTS = static_cast<xpOS::API::EventTypeMask>(xpOS::API::EventTypes::WRITEABLE) | xpOS::API::EventFlags::LEVEL_TRIGGERED;
+        bool backlogged = client.connection.template receive_messages<Handler>(MESSAGE_BUDGET);
+        if (backlogged == client.backlogged)
+            return;
+
+        if (backlogged)
+            listener.add(client.pd, BACKLOG_EVENTS, reinterpret_cast<uint64_t>(&client));
+        else
+            listener.remove(client.pd, BACKLOG_EVENTS);
+        client.backlogged = backlogged;
     }
 
     uint64_t m_listeningSocket;
-    std::list<PipeConnectionPair> m_clientSockets;
+    std::list<Client> m_clients;
 };
 
 }
@@ -0,0 +1,244 @@
+#ifndef IPCLIB_SHAREDRING_H
+#define IPCLIB_SHAREDRING_H
+
+#include "API/Pipes.h"
+#include "Libraries/OSLib/Socket.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace xpOS::IPC
+{
+
+/**
+ * A single-producer single-consumer ring of messages kept in shared memory, so two
+ * processes can exchange messages without entering the kernel.
+ *
+ * Each message is stored as its length followed by its bytes, padded to eight bytes.
+ * A message that does not fit before the end of the ring is preceded by a wrap marker
+ * and stored at the start instead, so every message can be read with one copy.
+ *
+ * The producer's side of the shared memory is not trusted. A record that would run
+ * past the published messages or the end of the ring empties the ring, and one too
+ * large for the reader's buffer is skipped.
+ *
+ * The ring does not block. A consumer about to wait for messages sets
+ * consumerSleeping, and the producer tells its caller to wake the consumer by some
+ * other means when it publishes a message while that is set. A producer about to
+ * wait for space sets producerWaiting in the same way, for the consumer to see
+ * once it has read.
+ */
+class SharedRing
+{
+public:
+    static constexpr std::size_t CAPACITY = 128 * 1024;
+    // Capped to what the socket carries, so a connection can receive either into the same buffer.
+    static constexpr std::size_t MAX_MESSAGE_SIZE = OSLib::LocalSocket::MAX_PACKET_SIZE;
+
+    struct Header
+    {
+        alignas(64) std::atomic<uint64_t> head;
+        alignas(64) std::atomic<uint64_t> tail;
+        alignas(64) std::atomic<uint32_t> consumerSleeping;
+        alignas(64) std::atomic<uint32_t> producerWaiting;
+    };
+
+    // The bytes of shared memory each ring takes up.
+    static constexpr std::size_t SIZE = sizeof(Header) + CAPACITY;
+
+    SharedRing() = default;
+
+    explicit SharedRing(void* memory)
+        : m_header(static_cast<Header*>(memory))
+        , m_data(static_cast<uint8_t*>(memory) + sizeof(Header))
+    {}
+
+    /**
+     * Sets up an empty ring in memory that has not been used for one before.
+     */
+    static SharedRing create(void* memory)
+    {
+        new (memory) Header{};
+        return SharedRing(memory);
+    }
+
+    /**
+     * Gathers the vectors into one message.
+     *
+     * @return false if there is not enough space for it yet, or ever if it is
+     * larger than MAX_MESSAGE_SIZE.
+     */
+    bool try_write(const API::Pipes::IOVector* vectors, std::size_t count, std::size_t length)
+    {
+        if (length > MAX_MESSAGE_SIZE)
+            return false;
+
+        if (!has_space(length))
+            return false;
+
+        auto head = m_header->head.load(std::memory_order_relaxed);
+        auto recordLength = record_length(length);
+        auto untilEnd = CAPACITY - head % CAPACITY;
+        if (recordLength > untilEnd) {
+            store_length(head, WRAP_MARKER);
+            head += untilEnd;
+        }
+
+        store_length(head, length);
+        auto* out = m_data + head % CAPACITY + sizeof(uint32_t);
+        for (std::size_t i = 0; i < count; i++) {
+            std::memcpy(out, vectors[i].base, vectors[i].length);
+            out += vectors[i].length;
+        }
+        m_header->head.store(head + recordLength, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Copies out the oldest message that fits in the buffer, skipping any that do not.
+     *
+     * @return the length of the message, or 0 if there is none.
+     */
+    std::size_t read(void* buf, std::size_t capacity)
+    {
+        while (true) {
+            auto tail = m_header->tail.load(std::memory_order_relaxed);
+            auto head = m_header->head.load(std::memory_order_acquire);
+            if (tail == head)
+                return 0;
+            if (head - tail > CAPACITY)
+                return discard_malformed(head);
+
+            auto length = load_length(tail);
+            if (length == WRAP_MARKER) {
+                auto untilEnd = CAPACITY - tail % CAPACITY;
+                // The marker is only ever published together with the message after it.
+                if (untilEnd >= head - tail)
+                    return discard_malformed(head);
+                tail += untilEnd;
+                length = load_length(tail);
+            }
+
+            auto recordLength = record_length(length);
+            if (recordLength > head - tail || recordLength > CAPACITY - tail % CAPACITY)
+                return discard_malformed(head);
+
+            if (length > capacity) {
+                m_header->tail.store(tail + recordLength, std::memory_order_release);
+                continue;
+            }
+
+            std::memcpy(buf, m_data + tail % CAPACITY + sizeof(uint32_t), length);
+            m_header->tail.store(tail + recordLength, std::memory_order_release);
+            return length;
+        }
+    }
+
+    bool empty() const
+    {
+        return m_header->tail.load(std::memory_order_relaxed) == m_header->head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Called by the producer after writing. If the consumer was waiting, it is now
+     * the caller's job to wake it.
+     */
+    bool should_wake_consumer()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return m_header->consumerSleeping.load(std::memory_order_relaxed)
+            && m_header->consumerSleeping.exchange(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * Called by the consumer before it waits to be woken.
+     *
+     * @return false if a message arrived in the meantime, so it should not wait.
+     */
+    bool prepare_to_sleep()
+    {
+        m_header->consumerSleeping.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!empty()) {
+            m_header->consumerSleeping.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Called by the consumer after reading. If the producer was waiting for space,
+     * it is now the caller's job to wake it.
+     */
+    bool should_wake_producer()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return m_header->producerWaiting.load(std::memory_order_relaxed)
+            && m_header->producerWaiting.exchange(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * Called by the producer before it waits to be woken.
+     *
+     * @return false if space for the message was freed in the meantime, so it
+     * should not wait.
+     */
+    bool prepare_to_wait_for_space(std::size_t length)
+    {
+        m_header->producerWaiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (has_space(length)) {
+            m_header->producerWaiting.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr uint32_t WRAP_MARKER = UINT32_MAX;
+
+    static constexpr std::size_t record_length(std::size_t length)
+    {
+        return (sizeof(uint32_t) + length + 7) & ~static_cast<std::size_t>(7);
+    }
+
+    bool has_space(std::size_t length) const
+    {
+        auto head = m_header->head.load(std::memory_order_relaxed);
+        auto tail = m_header->tail.load(std::memory_order_acquire);
+        auto recordLength = record_length(length);
+        auto untilEnd = CAPACITY - head % CAPACITY;
+        auto needed = recordLength > untilEnd ? untilEnd + recordLength : recordLength;
+        return CAPACITY - (head - tail) >= needed;
+    }
+
+    /**
+     * Drops everything published so far, as the records can no longer be told apart.
+     */
+    std::size_t discard_malformed(uint64_t head)
+    {
+        m_header->tail.store(head, std::memory_order_release);
+        return 0;
+    }
+
+    void store_length(uint64_t position, uint32_t length)
+    {
+        std::memcpy(m_data + position % CAPACITY, &length, sizeof(length));
+    }
+
+    uint32_t load_length(uint64_t position) const
+    {
+        uint32_t length;
+        std::memcpy(&length, m_data + position % CAPACITY, sizeof(length));
+        return length;
+    }
+
+    Header* m_header = nullptr;
+    uint8_t* m_data = nullptr;
+};
+
+}
+
+#endif
@@ -10,9 +10,9 @@ namespace xpOS::OSLib
         m_pd = xpOS::OSLib::popen("elistener");
     }
 
-    void EventListener::add(uint64_t targetPd, xpOS::API::EventTypeMask mask)
+    void EventListener::add(uint64_t targetPd, xpOS::API::EventTypeMask mask, uint64_t cookie)
     {
-        xpOS::API::Syscalls::syscall(SYSCALL_ELISTENER_ADD, m_pd, targetPd, mask);
+        xpOS::API::Syscalls::syscall(SYSCALL_ELISTENER_ADD, m_pd, targetPd, mask, cookie);
     }
     
     void EventListener::remove(uint64_t targetPd, xpOS::API::EventTypeMask mask)
@@ -11,7 +11,11 @@ class EventListener
 public:
     EventListener();
     EventListener(const EventListener&) = delete;
-    void add(uint64_t pd, xpOS::API::EventTypeMask mask);
+    /**
+     * Registers for events on a pipe. Events raised on it are reported with the
+     * cookie, so callers can find their state for the pipe without a lookup.
+     */
+    void add(uint64_t pd, xpOS::API::EventTypeMask mask, uint64_t cookie = 0);
     void remove(uint64_t pd, xpOS::API::EventTypeMask mask);
     int listen(xpOS::API::Event* resultOut, int maxEvents);
     
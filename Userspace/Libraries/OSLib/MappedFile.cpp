@@ -0,0 +1,35 @@
+#include "MappedFile.h"
+#include "Pipe.h"
+
+namespace xpOS::OSLib
+{
+
+MappedFile::MappedFile(const char* path, int flags)
+{
+    int pd = popen("vfs", const_cast<char*>(path));
+    if (pd < 0)
+        return;
+
+    m_size = pinfo(pd).size;
+    if (m_size) {
+        m_data = static_cast<uint8_t*>(pmmap(pd, 0, m_size, flags));
+        m_mapped = m_data != nullptr;
+        if (!m_mapped) {
+            m_data = new uint8_t[m_size];
+            pread(pd, m_data, m_size);
+        }
+    }
+
+    // The mapping stays valid once the pipe is closed.
+    pclose(pd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_mapped)
+        pmunmap(m_data, m_size);
+    else
+        delete[] m_data;
+}
+
+}
@@ -0,0 +1,35 @@
+#ifndef XPOSLIB_MAPPEDFILE_H
+#define XPOSLIB_MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace xpOS::OSLib
+{
+
+/**
+ * Maps a whole file from the VFS into memory for as long as the object lives.
+ * Falls back to reading the file into a buffer if it cannot be mapped.
+ */
+class MappedFile
+{
+public:
+    MappedFile(const char* path, int flags = 0);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool valid() const { return m_data != nullptr; }
+    const uint8_t* data() const { return m_data; }
+    uint8_t* data() { return m_data; }
+    std::size_t size() const { return m_size; }
+
+private:
+    uint8_t* m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_mapped = false;
+};
+
+}
+
+#endif
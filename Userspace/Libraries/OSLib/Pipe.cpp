@@ -43,6 +43,36 @@ namespace xpOS::OSLib
         );
     }
 
+    std::size_t preadv(uint64_t pd, const API::Pipes::IOVector* vectors, std::size_t count)
+    {
+        return Syscalls::syscall(
+            SYSCALL_PREADV,
+            pd,
+            reinterpret_cast<uint64_t>(vectors),
+            count
+        );
+    }
+
+    std::size_t pwritev(uint64_t pd, const API::Pipes::IOVector* vectors, std::size_t count)
+    {
+        return Syscalls::syscall(
+            SYSCALL_PWRITEV,
+            pd,
+            reinterpret_cast<uint64_t>(vectors),
+            count
+        );
+    }
+
+    std::size_t psplice(uint64_t inPd, uint64_t outPd, std::size_t count)
+    {
+        return Syscalls::syscall(
+            SYSCALL_PSPLICE,
+            inPd,
+            outPd,
+            count
+        );
+    }
+
     std::size_t pseek(uint64_t pd, long count)
     {
         return Syscalls::syscall(
@@ -51,4 +81,39 @@ namespace xpOS::OSLib
             count
         );
     }
+
+    API::Pipes::PipeInfo pinfo(uint64_t pd)
+    {
+        API::Pipes::PipeInfo info;
+        Syscalls::syscall(
+            SYSCALL_PINFO,
+            pd,
+            reinterpret_cast<uint64_t>(&info)
+        );
+        return info;
+    }
+
+    void* pmmap(uint64_t pd, std::size_t offset, std::size_t count, int flags)
+    {
+        return reinterpret_cast<void*>(Syscalls::syscall(
+            SYSCALL_PMMAP,
+            pd,
+            offset,
+            count,
+            flags
+        ));
+    }
+
+    void pmunmap(void* addr, std::size_t count)
+    {
+        // Mappings cover whole pages, starting at the page containing the mapped data.
+        constexpr uint64_t pageSize = 0x1000;
+        auto start = reinterpret_cast<uint64_t>(addr) & ~(pageSize - 1);
+        auto end = (reinterpret_cast<uint64_t>(addr) + count + pageSize - 1) & ~(pageSize - 1);
+        Syscalls::syscall(
+            SYSCALL_VMUNMAP,
+            start,
+            end - start
+        );
+    }
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define XPOSLIB_PIPE_H
 
 #include <cstdint>
+#include "API/Pipes.h"
 
 namespace xpOS::OSLib
 {
@@ -9,7 +10,16 @@ namespace xpOS::OSLib
     bool pclose(uint64_t pd);
     std::size_t pread(uint64_t pd, void* buf, std::size_t count);
     std::size_t pwrite(uint64_t pd, const void* buf, std::size_t count);
+    std::size_t preadv(uint64_t pd, const API::Pipes::IOVector* vectors, std::size_t count);
+    std::size_t pwritev(uint64_t pd, const API::Pipes::IOVector* vectors, std::size_t count);
+    /**
+     * Moves up to count bytes from one pipe to another inside the kernel.
+     */
+    std::size_t psplice(uint64_t inPd, uint64_t outPd, std::size_t count);
     std::size_t pseek(uint64_t pd, long count);
+    API::Pipes::PipeInfo pinfo(uint64_t pd);
+    void* pmmap(uint64_t pd, std::size_t offset, std::size_t count, int flags = 0);
+    void pmunmap(void* addr, std::size_t count);
 }
 
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "API/Syscall.h"
 #include "API/Network.h"
+#include <cstddef>
 
 namespace xpOS::OSLib::LocalSocket
 {
@@ -13,9 +14,14 @@ namespace xpOS::OSLib::LocalSocket
 
     enum class Flags : int
     {
-        NON_BLOCKING = 1
+        NON_BLOCKING = 1,
+        ZERO_COPY = 2,
+        SEQPACKET = 4
     };
 
+    // The largest message a SEQPACKET socket accepts.
+    inline constexpr std::size_t MAX_PACKET_SIZE = 65536 - sizeof(uint32_t);
+
     enum class EventTypes : int
     {
         SOCK_REQUEST_CONN = 0x4
@@ -1,7 +1,11 @@
 #ifndef ARCHIVE_H
 #define ARCHIVE_H
 
+#include <array>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 
 namespace Serialisation
 {
@@ -12,6 +16,72 @@ concept ArchivableTo = requires(D d, Archive ar)
     d.define_archivable(ar);
 };
 
+/**
+ * Types encoded as their object representation, so they are copied with a single
+ * memcpy. A trivially copyable struct without pointers can opt in by declaring
+ * `static constexpr bool BitwiseArchivable = true`.
+ */
+template <typename T>
+inline constexpr bool is_bitwise_archivable = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+template <typename T> requires std::is_class_v<T> && requires { requires T::BitwiseArchivable; }
+inline constexpr bool is_bitwise_archivable<T> = std::is_trivially_copyable_v<T>;
+
+template <typename T, std::size_t N>
+inline constexpr bool is_bitwise_archivable<T[N]> = is_bitwise_archivable<T>;
+
+template <typename T, std::size_t N>
+inline constexpr bool is_bitwise_archivable<std::array<T, N>> = is_bitwise_archivable<T>;
+
+template <typename T>
+concept BitwiseArchivable = is_bitwise_archivable<std::remove_cv_t<T>>;
+
+/**
+ * An archive that only adds up how many bytes a message encodes to, which it
+ * can only do if every member is bitwise archivable.
+ */
+struct SizeArchive
+{
+    std::size_t size = 0;
+    bool fixed = true;
+
+    template <typename... Args>
+    constexpr void operator()(Args&... args)
+    {
+        ([&]
+        {
+            if constexpr (BitwiseArchivable<Args>)
+                size += sizeof(Args);
+            else if constexpr (ArchivableTo<Args, SizeArchive>)
+                args.define_archivable(*this);
+            else
+                fixed = false;
+        } (), ...);
+    }
+};
+
+inline constexpr std::size_t VARIABLE_SIZE = SIZE_MAX;
+
+template <typename Message>
+constexpr std::size_t fixed_encoded_size()
+{
+    Message message{};
+    SizeArchive ar;
+    message.define_archivable(ar);
+    return ar.fixed ? ar.size : VARIABLE_SIZE;
+}
+
+/**
+ * Messages that always encode to the same number of bytes, known at compile time,
+ * so they can be encoded without allocating. This needs define_archivable to be
+ * constexpr.
+ */
+template <typename Message>
+concept FixedSize = requires
+{
+    typename std::integral_constant<std::size_t, fixed_encoded_size<Message>()>;
+} && (fixed_encoded_size<Message>() != VARIABLE_SIZE);
+
 }
 
-#endif
\ No newline at end of file
+#endif
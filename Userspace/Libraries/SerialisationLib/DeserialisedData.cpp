@@ -5,15 +5,20 @@ namespace Serialisation
 
 void decode(std::string& decodable, DeserialisedData& msg)
 {
-    std::size_t sz;
+    std::size_t sz = 0;
     decode(sz, msg);
-    decodable.clear();
-    for (std::size_t i = 0; i < sz; i++) {
-        /// FIXME: We do not want to require that T is default constructible.
-        char c;
-        decode(c, msg);
-        decodable += c;
-    }
+    if (auto* bytes = msg.pop(sz))
+        decodable.assign(reinterpret_cast<const char*>(bytes), sz);
+    else
+        decodable.clear();
 }
 
-}
\ No newline at end of file
+void decode(std::string_view& decodable, DeserialisedData& msg)
+{
+    std::size_t sz = 0;
+    decode(sz, msg);
+    auto* bytes = msg.pop(sz);
+    decodable = bytes ? std::string_view(reinterpret_cast<const char*>(bytes), sz) : std::string_view();
+}
+
+}
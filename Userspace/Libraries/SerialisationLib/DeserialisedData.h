@@ -4,7 +4,9 @@
 #include "Archive.h"
 #include <cstdint>
 #include <cstring>
+#include <span>
 #include <string>
+#include <string_view>
 #include <list>
 #include <vector>
 
@@ -19,13 +21,34 @@ public:
         const uint8_t* buf,
         std::size_t count
     )
+        : m_rawBytes(buf, buf + count)
+        , m_data(m_rawBytes.data())
+        , m_size(count)
+    {}
+
+    /**
+     * Takes ownership of an already received buffer without copying it.
+     */
+    DeserialisedData(std::vector<uint8_t>&& bytes)
+        : m_rawBytes(std::move(bytes))
+        , m_data(m_rawBytes.data())
+        , m_size(m_rawBytes.size())
+    {}
+
+    /**
+     * Decodes straight out of a buffer owned by the caller, which must outlive
+     * any string_view or span decoded from it.
+     */
+    static DeserialisedData view(const uint8_t* buf, std::size_t count)
     {
-        //m_rawBytes = reinterpret_cast<uint8_t*>(kmalloc(count, 0));
-        m_rawBytes.reserve(count);
-        m_currentOffset = 0;
-        std::memcpy(m_rawBytes.data(), buf, count);
+        return DeserialisedData(buf, count, View{});
     }
 
+    DeserialisedData(const DeserialisedData&) = delete;
+    DeserialisedData& operator=(const DeserialisedData&) = delete;
+    DeserialisedData(DeserialisedData&&) = default;
+    DeserialisedData& operator=(DeserialisedData&&) = default;
+
     friend auto& operator<<(ArchivableTo<DeserialisedData> auto& data, DeserialisedData& self)
     {
         data.define_archivable(self);
@@ -44,51 +67,124 @@ public:
     template <typename T>
     void decode(T& decodable);
 
+    /**
+     * @return the next count bytes, or nullptr if the message is shorter than that,
+     * which fails the decoding.
+     */
     const uint8_t* pop(std::size_t count)
     {
-        m_currentOffset += count;
-        return m_rawBytes.data() + m_currentOffset - count;
+        if (m_failed || count > remaining()) {
+            m_failed = true;
+            return nullptr;
+        }
+        m_offset += count;
+        return m_data + m_offset - count;
+    }
+
+    /**
+     * As above, for count elements of type T.
+     */
+    template <typename T>
+    const T* pop_elements(std::size_t count)
+    {
+        if (count > remaining() / sizeof(T)) {
+            m_failed = true;
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(pop(count * sizeof(T)));
+    }
+
+    /**
+     * Skips the padding SerialisedData::align wrote.
+     */
+    void align(std::size_t alignment)
+    {
+        pop((alignment - m_offset % alignment) % alignment);
+    }
+
+    std::size_t remaining() const
+    {
+        return m_size - m_offset;
+    }
+
+    /**
+     * Whether a value ran past the end of the message. Whatever was decoded since
+     * is left default initialised, and should be discarded.
+     */
+    bool failed() const
+    {
+        return m_failed;
     }
 
 private:
+    struct View {};
+
+    DeserialisedData(const uint8_t* buf, std::size_t count, View)
+        : m_data(buf)
+        , m_size(count)
+    {}
+
     std::vector<uint8_t> m_rawBytes;
-    int m_currentOffset;
+    const uint8_t* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::size_t m_offset = 0;
+    bool m_failed = false;
 };
 
-void decode(std::integral auto& decodable, DeserialisedData& msg)
+void decode(BitwiseArchivable auto& decodable, DeserialisedData& msg)
 {
-    decodable = *reinterpret_cast<const std::remove_reference_t<std::remove_cv_t<decltype(decodable)>>*>(msg.pop(sizeof(decodable)));
+    if (auto* bytes = msg.pop(sizeof(decodable)))
+        std::memcpy(&decodable, bytes, sizeof(decodable));
 }
 
-void decode(std::floating_point auto& decodable, DeserialisedData& msg)
+void decode(std::string& decodable, DeserialisedData& msg);
+void decode(std::string_view& decodable, DeserialisedData& msg);
+
+/**
+ * Points the span at the elements inside the message rather than copying them.
+ */
+template <BitwiseArchivable T>
+void decode(std::span<const T>& decodable, DeserialisedData& msg)
 {
-    decodable = *reinterpret_cast<const std::remove_reference_t<std::remove_cv_t<decltype(decodable)>>*>(msg.pop(sizeof(decodable)));
+    std::size_t sz = 0;
+    decode(sz, msg);
+    msg.align(alignof(T));
+    auto* elements = msg.pop_elements<T>(sz);
+    decodable = elements ? std::span<const T>(elements, sz) : std::span<const T>();
 }
 
-void decode(std::string& decodable, DeserialisedData& msg);
-
 template <typename T>
 void decode(std::vector<T>& decodable, DeserialisedData& msg)
 {
-    std::size_t sz;
+    std::size_t sz = 0;
     decode(sz, msg);
+    if constexpr (BitwiseArchivable<T>) {
+        msg.align(alignof(T));
+        auto* elements = msg.pop_elements<T>(sz);
+        decodable.resize(elements ? sz : 0);
+        if (elements)
+            std::memcpy(decodable.data(), elements, sz * sizeof(T));
+        return;
+    }
+
     decodable.clear();
-    decodable.reserve(sz);
-    for (std::size_t i = 0; i < sz; i++) {
+    // The length comes from the sender, so only what the message could hold is reserved.
+    decodable.reserve(sz < msg.remaining() ? sz : msg.remaining());
+    for (std::size_t i = 0; i < sz && !msg.failed(); i++) {
         /// FIXME: We do not want to require that T is default constructible.
         T t;
         decode(t, msg);
-        decodable.push_back(t);
+        decodable.push_back(std::move(t));
     }
 }
 
 template <typename T>
 void decode(std::list<T>& decodable, DeserialisedData& msg)
 {
-    std::size_t sz;
+    std::size_t sz = 0;
     decode(sz, msg);
     decodable.clear();
-    for (std::size_t i = 0; i < sz; i++) {
+    for (std::size_t i = 0; i < sz && !msg.failed(); i++) {
         /// FIXME: We do not want to require that T is default constructible.
         T t;
         decode(t, msg);
@@ -109,4 +205,4 @@ void DeserialisedData::decode(T& decodable)
 
 }
 
-#endif
\ No newline at end of file
+#endif
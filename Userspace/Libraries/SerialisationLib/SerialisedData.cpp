@@ -7,10 +7,12 @@ namespace Serialisation
 
 void encode(const std::string& encodable, SerialisedData& msg)
 {
-    std::size_t sz = encodable.size();
-    msg.push(reinterpret_cast<const uint8_t*>(&sz), sizeof(sz));
-    for (char c : encodable)
-        encode(c, msg);
+    encode_sequence(encodable.data(), encodable.size(), msg);
 }
 
-}
\ No newline at end of file
+void encode(std::string_view encodable, SerialisedData& msg)
+{
+    encode_sequence(encodable.data(), encodable.size(), msg);
+}
+
+}
@@ -1,10 +1,12 @@
 #ifndef SERIALISED_DATA_H
 #define SERIALISED_DATA_H
 
-//#include "common/Vector.h"
 #include "Archive.h"
 #include <cstdint>
+#include <cstring>
+#include <span>
 #include <string>
+#include <string_view>
 #include <list>
 #include <vector>
 
@@ -14,11 +16,24 @@ namespace Serialisation
 struct SerialisedData
 {
 public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 256;
+
     SerialisedData()
     {
-        m_rawBytes.reserve(1024);
+        grow(DEFAULT_CAPACITY);
     }
 
+    /**
+     * Encodes into the caller's buffer, only allocating if it is too small.
+     */
+    SerialisedData(uint8_t* buffer, std::size_t capacity)
+        : m_data(buffer)
+        , m_capacity(capacity)
+    {}
+
+    SerialisedData(const SerialisedData&) = delete;
+    SerialisedData& operator=(const SerialisedData&) = delete;
+
     friend auto& operator>>(ArchivableTo<SerialisedData> auto& data, SerialisedData& self)
     {
         data.define_archivable(self);
@@ -39,45 +54,90 @@ public:
 
     void push(const uint8_t* values, std::size_t count)
     {
-        for (std::size_t i = 0; i < count; i++) 
-            m_rawBytes.push_back(values[i]);
+        if (m_length + count > m_capacity)
+            grow(m_length + count);
+        std::memcpy(m_data + m_length, values, count);
+        m_length += count;
+    }
+
+    /**
+     * Pads with zeros to a multiple of the alignment, so that data after it can be
+     * decoded in place.
+     */
+    void align(std::size_t alignment)
+    {
+        auto padding = (alignment - m_length % alignment) % alignment;
+        if (m_length + padding > m_capacity)
+            grow(m_length + padding);
+        std::memset(m_data + m_length, 0, padding);
+        m_length += padding;
     }
 
     const uint8_t* bytes() 
     {
-        return m_rawBytes.data();
+        return m_data;
     }
 
     auto length()
     {
-        return m_rawBytes.size();
+        return m_length;
     }
 
 private:
-    std::vector<uint8_t> m_rawBytes;
+    void grow(std::size_t needed)
+    {
+        auto capacity = m_capacity * 2 > needed ? m_capacity * 2 : needed;
+        std::vector<uint8_t> heap(capacity);
+        if (m_length)
+            std::memcpy(heap.data(), m_data, m_length);
+        m_heap = std::move(heap);
+        m_data = m_heap.data();
+        m_capacity = capacity;
+    }
+
+    uint8_t* m_data = nullptr;
+    std::size_t m_length = 0;
+    std::size_t m_capacity = 0;
+    std::vector<uint8_t> m_heap;
 };
 
-void encode(const std::integral auto& encodable, SerialisedData& msg)
+void encode(const BitwiseArchivable auto& encodable, SerialisedData& msg)
 {
     msg.push(reinterpret_cast<const uint8_t*>(&encodable), sizeof(encodable));
 }
 
-void encode(const std::floating_point auto& encodable, SerialisedData& msg)
+/**
+ * Sequences are encoded as their length and then their elements. Bitwise
+ * archivable elements are aligned and copied at once, so they can be decoded
+ * in place as a span.
+ */
+template <typename T>
+void encode_sequence(const T* items, std::size_t count, SerialisedData& msg)
 {
-    msg.push(reinterpret_cast<const uint8_t*>(&encodable), sizeof(encodable));
+    msg.push(reinterpret_cast<const uint8_t*>(&count), sizeof(count));
+    if constexpr (BitwiseArchivable<T>) {
+        msg.align(alignof(T));
+        msg.push(reinterpret_cast<const uint8_t*>(items), count * sizeof(T));
+    } else {
+        for (std::size_t i = 0; i < count; i++)
+            encode(items[i], msg);
+    }
 }
 
 void encode(const std::string& encodable, SerialisedData& msg);
+void encode(std::string_view encodable, SerialisedData& msg);
 
 template<typename T>
 void encode(const std::vector<T>& encodable, SerialisedData& msg)
 {
-    std::size_t sz = encodable.size();
-    msg.push(reinterpret_cast<const uint8_t*>(&sz), sizeof(sz));
-    for (auto const& item : encodable)
-        encode(item, msg);
+    encode_sequence(encodable.data(), encodable.size(), msg);
 }
 
+template<typename T, std::size_t Extent>
+void encode(std::span<T, Extent> encodable, SerialisedData& msg)
+{
+    encode_sequence(encodable.data(), encodable.size(), msg);
+}
 
 void encode(const auto& encodable, SerialisedData& msg)
 {
@@ -92,4 +152,4 @@ void SerialisedData::encode(const T& encodable)
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -41,12 +41,24 @@ namespace xpOS::System::WindowServer
         unsigned char key;
 
         template<typename Archive>
-        void define_archivable(Archive& ar)
+        constexpr void define_archivable(Archive& ar)
         {
             ar(keyUp, key);
         }
     };
 
+    struct ResizeWindowCallback
+    {
+        static constexpr int MessageId = 6;
+        bool resized;
+
+        template<typename Archive>
+        constexpr void define_archivable(Archive& ar)
+        {
+            ar(resized);
+        }
+    };
+
     using ClientEndpoint = xpOS::IPC::Endpoint<KeyEvent>;
 }
 
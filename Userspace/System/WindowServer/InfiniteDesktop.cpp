@@ -20,6 +20,7 @@
 #include "Graphics.h"
 #include <ranges>
 #include "Libraries/GraphicsLib/stb_image.h"
+#include "Libraries/OSLib/MappedFile.h"
 
 InfiniteDesktop::InfiniteDesktop(const RenderBuffer& buffer)
     : m_buffer(buffer)
@@ -29,8 +30,10 @@ InfiniteDesktop::InfiniteDesktop(const RenderBuffer& buffer)
         .width = m_buffer.width,
         .height = m_buffer.height,
     };
-    unsigned char *data = stbi_load(
-        "xpinitrd/System/Resources/SmallCursor.png",
+    xpOS::OSLib::MappedFile cursorFile("xpinitrd/System/Resources/SmallCursor.png");
+    unsigned char *data = stbi_load_from_memory(
+        cursorFile.data(),
+        cursorFile.size(),
         &m_mouseRect.width,
         &m_mouseRect.height,
         nullptr,
@@ -41,8 +44,10 @@ InfiniteDesktop::InfiniteDesktop(const RenderBuffer& buffer)
     m_mouseBuffer.height = m_mouseRect.height;
     m_mouseBuffer.buffer = reinterpret_cast<uint32_t*>(data);
 
-    data = stbi_load(
-        "xpinitrd/System/Resources/Wallpaper.png",
+    xpOS::OSLib::MappedFile wallpaperFile("xpinitrd/System/Resources/Wallpaper.png");
+    data = stbi_load_from_memory(
+        wallpaperFile.data(),
+        wallpaperFile.size(),
         &m_bgBuffer.width,
         &m_bgBuffer.height,
         nullptr,
@@ -61,7 +61,7 @@ struct ServerHandler
 
         auto* window = desktop->make_window(context, WorldCoord(10 + currentWindowId * 150, 10));
         windowMap.insert({&conn, window});
-        conn.send_message(callback);
+        conn.reply(callback);
         desktop->paint_all();
     }
 
@@ -75,6 +75,23 @@ struct ServerHandler
             return;
         desktop->invalidate_window(it->second);
     }
+
+    static void handle_ipc_message(
+        ResizeWindow rwindow,
+        xpOS::IPC::Connection<WSEndpoint>& conn
+    )
+    {
+        ResizeWindowCallback callback {
+            .resized = false
+        };
+        auto it = windowMap.find(&conn);
+        if (it != windowMap.end())
+            callback.resized = it->second->get_context()->resize(rwindow.width, rwindow.height);
+        conn.reply(callback);
+
+        if (callback.resized)
+            desktop->paint_all();
+    }
 };
 
 }
@@ -31,7 +31,7 @@ struct CreateWindow
     int height;
 
     template<typename Archive>
-    void define_archivable(Archive& ar)
+    constexpr void define_archivable(Archive& ar)
     {
         ar(width, height);
     }
@@ -43,13 +43,29 @@ struct FlushWindow
     //int i;
 
     template<typename Archive>
-    void define_archivable(Archive& ar)
+    constexpr void define_archivable(Archive& ar)
     {
         ar();
     }
 };
 
-using WSEndpoint = xpOS::IPC::Endpoint<CreateWindow, FlushWindow>;
+/**
+ * Resizes the window's shared framebuffer in place. Answered with a ResizeWindowCallback.
+ */
+struct ResizeWindow
+{
+    static constexpr int MessageId = 5;
+    int width;
+    int height;
+
+    template<typename Archive>
+    constexpr void define_archivable(Archive& ar)
+    {
+        ar(width, height);
+    }
+};
+
+using WSEndpoint = xpOS::IPC::Endpoint<CreateWindow, FlushWindow, ResizeWindow>;
 
 }
 
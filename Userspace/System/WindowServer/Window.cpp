@@ -42,6 +42,24 @@ Context::~Context()
     OSLib::pclose(m_sharedMemoryFd);
 }
 
+bool Context::resize(int width, int height)
+{
+    API::SharedMemory::ResizeRequest req = {
+        .length = width * height * sizeof(uint32_t)
+    };
+    if (OSLib::pwrite(m_sharedMemoryFd, &req, sizeof(req)) != sizeof(req))
+        return false;
+
+    API::SharedMemory::MappingInfo info;
+    if (OSLib::pread(m_sharedMemoryFd, &info, sizeof(info)) != sizeof(info))
+        return false;
+
+    m_buffer.buffer = static_cast<uint32_t*>(info.mappedTo);
+    m_buffer.width = width;
+    m_buffer.height = height;
+    return true;
+}
+
 void Context::handle_keyboard_event(API::HID::KeyboardEvent apiEvent)
 {
     KeyEvent kEvent;
@@ -42,6 +42,12 @@ public:
 
     void handle_keyboard_event(API::HID::KeyboardEvent event);
 
+    /**
+     * Resizes the shared framebuffer without creating a new object. The client's mapping
+     * is updated by the kernel, which notifies it with a RESIZED event so it can redraw.
+     */
+    bool resize(int width, int height);
+
     const RenderBuffer& get_buffer() const
     {
         return m_buffer;